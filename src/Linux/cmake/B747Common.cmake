@@ -0,0 +1,9 @@
+# Destino B747Common: código compartido de src_Common.
+
+if(TARGET B747Common)
+    return()
+endif()
+
+include(${CMAKE_CURRENT_LIST_DIR}/OrbiterSDK.cmake)
+
+add_subdirectory(${CMAKE_CURRENT_LIST_DIR}/../src_Common ${CMAKE_BINARY_DIR}/src_Common)
@@ -0,0 +1,33 @@
+# Destino OrbiterSDK: cabeceras y bibliotecas contra las que se enlazan los módulos.
+# Con B747_HEADLESS se usa la implementación de src_Headless en lugar del Orbitersdk real.
+# src_Headless se compila siempre: las herramientas de src_Tools se ejecutan en la máquina de
+# compilación y enlazan con ella aunque los módulos usen el Orbitersdk real.
+
+if(TARGET OrbiterSDK)
+    return()
+endif()
+
+set(ORBITERSDK_DIR "$ENV{HOME}/orbiter_test/Orbiter/Orbitersdk" CACHE PATH "Directorio del Orbitersdk")
+
+# Por defecto según haya o no un Orbitersdk en ORBITERSDK_DIR; -DB747_HEADLESS=ON/OFF manda
+if(EXISTS "${ORBITERSDK_DIR}/include/Orbitersdk.h")
+    set(B747_HEADLESS_DEFAULT OFF)
+else()
+    set(B747_HEADLESS_DEFAULT ON)
+endif()
+set(B747_HEADLESS ${B747_HEADLESS_DEFAULT} CACHE BOOL "Compilar contra la implementación headless de la API de Orbiter")
+
+add_library(OrbiterSDK INTERFACE)
+
+if(NOT TARGET OrbiterHeadless)
+    add_subdirectory(${CMAKE_CURRENT_LIST_DIR}/../src_Headless ${CMAKE_BINARY_DIR}/src_Headless)
+endif()
+
+if(B747_HEADLESS)
+    target_link_libraries(OrbiterSDK INTERFACE OrbiterHeadless)
+else()
+    # Directorio que contiene las bibliotecas
+    file(GLOB ORBITERSDK_LIBRARIES "${ORBITERSDK_DIR}/lib/*.a")
+    target_include_directories(OrbiterSDK INTERFACE "${ORBITERSDK_DIR}/include")
+    target_link_libraries(OrbiterSDK INTERFACE ${ORBITERSDK_LIBRARIES})
+endif()
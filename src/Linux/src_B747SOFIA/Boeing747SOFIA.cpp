@@ -14,77 +14,64 @@
 #include "Boeing747SOFIA.h"
 #include <cstring>
 #include <cstdio>
+#include <vector>
 
-bool parkingBrakeEnabled;
-bool lights_on;
-bool bGearIsDown;
-bool engines_on;
-int enginevalue;
 
 // 1. vertical lift component
 
+static AeroPolars aero;
+static TouchdownSets touchdown_sets;
+static AnimationSet animations;
+static FlapPolars flap_polars;
+static MeshCache meshes;
+
+//Virtual cockpit meshes, added by clbkLoadVC; see B747VC.h.
+static const VCMeshSpec B747SOFIA_VC_MESHES[] = {
+    {"Boeing747\\Boeing_747_cockpit", 1},
+};
+
+//Light emitters by group, created in clbkSetClassCaps; the cockpit and cabin ones with the VC meshes.
+static const LightSpec B747SOFIA_LIGHTS[] = {
+    {LIGHTS_LANDING, LIGHT1_Location},
+    {LIGHTS_LANDING, LIGHT2_Location},
+    {LIGHTS_LANDING, LIGHT3_Location},
+    {LIGHTS_LANDING, LIGHT4_Location},
+    {LIGHTS_COCKPIT, PL1_Location},
+    {LIGHTS_COCKPIT, PL2_Location},
+};
+
 void VLiftCoeff (VESSEL *v, double aoa, double M, double Re, void *context, double *cl, double *cm, double *cd)
 {
-	const int nabsc = 9;
-	static const double AOA[nabsc] = {-180*RAD,-60*RAD,-30*RAD, -15*RAD, 0*RAD,15*RAD,30*RAD,60*RAD,180*RAD};
-	static const double CL[nabsc]  = {   0,    -0.56,   -0.56,   -0.16,  0.15,  0.46,  0.56,  0.56,  0.00};
-	static const double CM[nabsc]  = {    0,    0.00,   0.00,     0.00,  0.00,  0.00,  0.00,  0.00,  0.00};
-
-
-	int i;
-	for (i = 0; i < nabsc-1 && AOA[i+1] < aoa; i++);
-	if (i < nabsc - 1) {
-		double f = (aoa - AOA[i]) / (AOA[i + 1] - AOA[i]);
-		*cl = CL[i] + (CL[i + 1] - CL[i]) * f;  // aoa-dependent lift coefficient
-		*cm = CM[i] + (CM[i + 1] - CM[i]) * f;  // aoa-dependent moment coefficient
-	}
-	else {
-		*cl = CL[nabsc - 1];
-		*cm = CM[nabsc - 1];
-	}
-	double saoa = sin(aoa);
-	double pd = 0.015 + 0.4*saoa*saoa;  // profile drag
-	*cd = pd + oapiGetInducedDrag (*cl, B747SOFIA_VLIFT_A, 0.7) + oapiGetWaveDrag (M, 0.75, 1.0, 1.1, 0.04);
-	// profile drag + (lift-)induced drag + transonic/supersonic wave (compressibility) drag
+	aero.vlift.Lookup(aoa, M, Re, cl, cm, cd);
+	if(context) ((const FlapSystem *)context)->Add(aoa, cl, cd);  //Wings only
 }
 
 // 2. horizontal lift component (vertical stabilisers and body)
 
 void HLiftCoeff (VESSEL *v, double beta, double M, double Re, void *context, double *cl, double *cm, double *cd)
 {
-	int i;
-	const int nabsc = 8;
-	static const double BETA[nabsc] = {-180*RAD,-135*RAD,-90*RAD,-45*RAD,45*RAD,90*RAD,135*RAD,180*RAD};
-	static const double CL[nabsc]   = {       0,    +0.3,      0,   -0.3,  +0.3,     0,   -0.3,      0};
-	for (i = 0; i < nabsc-1 && BETA[i+1] < beta; i++);
-	if (i < nabsc - 1) {
-		*cl = CL[i] + (CL[i + 1] - CL[i]) * (beta - BETA[i]) / (BETA[i + 1] - BETA[i]);
-	}
-	else {
-		*cl = CL[nabsc - 1];
-	}
-	*cm = 0.0;
-	*cd = 0.015 + oapiGetInducedDrag (*cl, B747SOFIA_HLIFT_A, 0.6) + oapiGetWaveDrag (M, 0.75, 1.0, 1.1, 0.04);
+	aero.hlift.Lookup(beta, M, Re, cl, cm, cd);
 }
 
 //Constructor
 B747SOFIA::B747SOFIA(OBJHANDLE hVessel, int flightmodel) : VESSEL4(hVessel, flightmodel){
 
-    landing_gear_proc = 0.0;
-
-    telescope_hatch_proc = 0.0;
+    parts.Add<GearTraits>(PART_GEAR);
+    flaps.Init(&flap_polars);
+    systems.Add<PartsSystem>(SYSTEM_PARTS);
+    systems.Add<EnginesSystem>(SYSTEM_ENGINES);
+    systems.Add<ContrailSystem>(SYSTEM_CONTRAILS);
+    systems.Add<VCSystem>(SYSTEM_VC);
+    systems.Add<LODSystem>(SYSTEM_LOD);
+    parts.Add<HatchTraits>(PART_HATCH);
+    parts.AddEach<CabinDoorTraits>(PART_CABIN_DOOR1, CabinDoorSequence());
 
-    telescope_hatch_status = HATCH_CLOSED;
-
-	landing_gear_status = GEAR_DOWN;
-
-	DefineAnimations();
+    DefineAnimations();
 
     B747SOFIA_mesh = NULL;
 
     mhcockpit_mesh = NULL;
 
-    engines_on = false;
 
 }
 
@@ -94,380 +81,55 @@ B747SOFIA::~B747SOFIA(){
 }
 
 void B747SOFIA::DefineAnimations(void){
-    
-    //Front landing gear
-
-    static unsigned int FrontLandingGearGrp[1] = {Front_landing_gear_Id};
-    static MGROUP_ROTATE FrontLandingGearRotate(
-        0,
-        FrontLandingGearGrp,
-        1,
-        (Axis_front_landing_gear_rotate_Location),
-        _V(1, 0, 0),
-        (float)(-110*RAD)
-    );
-
-    static unsigned int FrontLandingGearLeftDoorGrp[1] = {Front_landing_gear_left_door_Id};
-    static MGROUP_ROTATE FrontLandingGearLeftDoor(
-        0,
-        FrontLandingGearLeftDoorGrp,
-        1,
-        (Axis_front_landing_gear_left_door_Location),
-        _V(0, 0, 1),
-        (float)(90*RAD)
-    );
-
-    static unsigned int FrontLandingGearRightDoorGrp[1] = {Front_landing_gear_right_door_Id};
-    static MGROUP_ROTATE FrontLandingGearRightDoor(
-        0,
-        FrontLandingGearRightDoorGrp,
-        1,
-        (Axis_front_landing_gear_right_door_Location),
-        _V(0, 0, 1),
-        (float)(-90*RAD)
-    );
-
-    anim_landing_gear = CreateAnimation(0.0);
-
-    AddAnimationComponent(anim_landing_gear, 0, 0.25, &FrontLandingGearRotate);
-    AddAnimationComponent(anim_landing_gear, 0, 0.5, &FrontLandingGearLeftDoor);
-    AddAnimationComponent(anim_landing_gear, 0, 0.5, &FrontLandingGearRightDoor);
-
-    //Rear landing gears
-
-    static unsigned int RearLeftWingLandingGearGrp[1] = {Rear_left_wing_landing_gear_Id};
-    static MGROUP_ROTATE RearLeftWingLandingGearStow(
-        0,
-        RearLeftWingLandingGearGrp,
-        1,
-        (Axis_left_wing_landing_gear_Location),
-        _V(0, 0, 1),
-        (float)(90*RAD)
-    );
-    
-    static unsigned int RearLeftWingLandingGearPartGrp [1] = {Rear_left_wing_landing_gear_part_Id};
-    static MGROUP_ROTATE RearLeftWingLandingGearPart(
-        0,
-        RearLeftWingLandingGearPartGrp,
-        1,
-        (Axis_rear_left_wing_landing_gear_part_Location),
-        _V(0, 0, 1),
-        (float)(-90*RAD)
-    );
-
-    AddAnimationComponent(anim_landing_gear, 0, 0.5, &RearLeftWingLandingGearStow);
-    AddAnimationComponent(anim_landing_gear, 0, 0.5, &RearLeftWingLandingGearPart);
-
-    static unsigned int RearRightWingLandingGearGrp[1] = {Rear_right_wing_landing_gear_Id};
-    static MGROUP_ROTATE RearRightWingLandingGearStow(
-        0,
-        RearRightWingLandingGearGrp,
-        1,
-        (Axis_right_wing_landing_gear_Location),
-        _V(0, 0, 1),
-        (float)(-90*RAD)
-    );
-
-    static unsigned int RearRightWingLandingGearPartGrp[1] = {Rear_right_wing_landing_gear_part_Id};
-    static MGROUP_ROTATE RearRightWingLandingGearPart(
-        0,
-        RearRightWingLandingGearPartGrp,
-        1,
-        (Axis_rear_right_wing_landing_gear_part_Location),
-        _V(0, 0, 1),
-        (float)(90*RAD)
-    );
-
-    AddAnimationComponent(anim_landing_gear, 0, 0.5, &RearRightWingLandingGearStow);
-    AddAnimationComponent(anim_landing_gear, 0, 0.5, &RearRightWingLandingGearPart);
-
-    static unsigned int RearLeftLandingGearGrp[1] = {Rear_left_landing_gear_Id};
-    static MGROUP_ROTATE RearLeftLandingGear(
-        0,
-        RearLeftLandingGearGrp,
-        1,
-        (Axis_left_landing_gear_Location),
-        _V(1, 0, 0),
-        (float)(-180*RAD)
-    );
-
-    static unsigned int RearRightLandingGearGrp[1] = {Rear_right_landing_gear_Id};
-    static MGROUP_ROTATE RearRightLandingGear(
-        0,
-        RearRightLandingGearGrp,
-        1,
-        (Axis_right_landing_gear_Location),
-        _V(1, 0, 0),
-        (float)(-180*RAD)
-    );
-
-    AddAnimationComponent(anim_landing_gear, 0, 0.5, &RearLeftLandingGear);
-    AddAnimationComponent(anim_landing_gear, 0, 0.5, &RearRightLandingGear);
-
-    static unsigned int RearLeftLandingGearDoor1Grp[2] = {Rear_left_landing_gear_door1_Id, Rear_left_landing_gear_door2_Id};
-    static MGROUP_ROTATE RearLeftLandingGearDoor1(
-        0,
-        RearLeftLandingGearDoor1Grp,
-        2,
-        (Axis_landing_gear_left_door_1_Location),
-        _V(0, 0, 1),
-        (float)(-90*RAD)
-    );
-
-    static unsigned int RearLeftLandingGearDoor2Grp[1] = {Rear_left_landing_gear_door2_Id};
-    static MGROUP_ROTATE RearLeftLandingGearDoor2(
-        0,
-        RearLeftLandingGearDoor2Grp,
-        1,
-        (Axis_left_landing_gear_door2_Location),
-        _V(0, 0, 1),
-        (float)(-180*RAD)
-    );
-
-    AddAnimationComponent(anim_landing_gear, 0.25, 0.5, &RearLeftLandingGearDoor1);
-    AddAnimationComponent(anim_landing_gear, 0.5, 1, &RearLeftLandingGearDoor2);
-
-    static unsigned int RearRightLandingGearDoor1Grp[2] = {Rear_right_landing_gear_door1_Id, Rear_right_landing_gear_door2_Id};
-    static MGROUP_ROTATE RearRightLandingGearDoor1(
-        0,
-        RearRightLandingGearDoor1Grp,
-        2,
-        (Axis_landing_gear_right_door_1_Location),
-        _V(0, 0, 1),
-        (float)(90*RAD)
-    );
-
-    static unsigned int RearRightLandingGearDoor2Grp[1] = {Rear_right_landing_gear_door2_Id};
-    static MGROUP_ROTATE RearRightLandingGearDoor2(
-        0,
-        RearRightLandingGearDoor2Grp,
-        1,
-        (Axis_right_landing_gear_door2_Location),
-        _V(0, 0, 1),
-        (float)(180*RAD)
-    );
-
-    AddAnimationComponent(anim_landing_gear, 0.25, 0.5, &RearRightLandingGearDoor1);
-    AddAnimationComponent(anim_landing_gear, 0.5, 1, &RearRightLandingGearDoor2);
-
-    //Engines
-
-    static unsigned int Engine1Grp[1] = {ENG1_blades_Id};
-    static MGROUP_ROTATE Engine1(
-        0,
-        Engine1Grp,
-        1,
-        (ENG1_blades_Location),
-        _V(0, 0, 1),
-        (float)(360*RAD)
-    );
-    
-    
-    static unsigned int Engine2Grp[1] = {ENG2_blades_Id};
-    static MGROUP_ROTATE Engine2(
-        0,
-        Engine2Grp,
-        1,
-        (ENG2_blades_Location),
-        _V(0, 0, 1),
-        (float)(360*RAD)
-    );
-
-    static unsigned int Engine3Grp[1] = {ENG3_blades_Id};
-    static MGROUP_ROTATE Engine3(
-        0,
-        Engine3Grp,
-        1,
-        (ENG3_blades_Location),
-        _V(0, 0, 1),
-        (float)(360*RAD)
-    );
-
-    static unsigned int Engine4Grp[1] = {ENG4_blades_Id};
-    static MGROUP_ROTATE Engine4(
-        0,
-        Engine4Grp,
-        1,
-        (ENG4_blades_Location),
-        _V(0, 0, 1),
-        (float)(360*RAD)
-    );
-    
-    anim_engines = CreateAnimation(0.0);
-
-    AddAnimationComponent(anim_engines, 0, 1, &Engine1);
-    AddAnimationComponent(anim_engines, 0, 1, &Engine2);
-    AddAnimationComponent(anim_engines, 0, 1, &Engine3);
-    AddAnimationComponent(anim_engines, 0, 1, &Engine4);
-
-    //Control surfaces
-
-    static unsigned int LeftElevatorGrp[1] = {Left_elevator_trim_Id};
-    static MGROUP_ROTATE LeftElevator(
-        0,
-        LeftElevatorGrp,
-        1,
-        (Axis_elevator_left_Location),
-        _V(1, 0, 0.5),
-        (float)(45*RAD)
-    );
-
-    static unsigned int RightElevatorGrp[1] = {Right_elevator_trim_Id};
-    static MGROUP_ROTATE RightElevator(
-        0,
-        RightElevatorGrp,
-        1,
-        (Axis_elevator_right_Location),
-        _V(1, 0, -0.5),
-        (float)(45*RAD)
-    );
-
-    anim_elevator = CreateAnimation(0.5);
-    AddAnimationComponent(anim_elevator, 0, 1, &LeftElevator);
-    AddAnimationComponent(anim_elevator, 0, 1, &RightElevator);
-
-    static unsigned int LeftElevatorTrimGrp[1] = {Left_elevator_trim_Id};
-    static MGROUP_ROTATE LeftElevatorTrim(
-        0,
-        LeftElevatorTrimGrp,
-        1,
-        (Axis_elevator_left_Location),
-        _V(1, 0, 0.5),
-        (float)(22.5*RAD)
-    );
-
-    static unsigned int RightElevatorTrimGrp[1] = {Right_elevator_trim_Id};
-    static MGROUP_ROTATE RightElevatorTrim(
-        0,
-        RightElevatorTrimGrp,
-        1,
-        (Axis_elevator_right_Location),
-        _V(1, 0, -0.5),
-        (float)(22.5*RAD)
-    );
-
-    anim_elevator_trim = CreateAnimation(0.5);
-    AddAnimationComponent(anim_elevator_trim, 0, 1, &LeftElevatorTrim);
-    AddAnimationComponent(anim_elevator_trim, 0, 1, &RightElevatorTrim);
-
-    static unsigned int RudderGrp[1] = {Rudder_Id};
-    static MGROUP_ROTATE Rudder(
-        0,
-        RudderGrp,
-        1,
-        (Axis_rudder_Location),
-        _V(0, 1, -0.75),
-        (float)(22.5*RAD)
-    );
-    anim_rudder = CreateAnimation(0.5);
-    AddAnimationComponent(anim_rudder, 0, 1, &Rudder);
-
-    static unsigned int LAileronGrp[1] = {LAileron_Id};
-    static MGROUP_ROTATE LAileron(
-        0,
-        LAileronGrp,
-        1,
-        (Axis_laileron_Location),
-        _V(-1, 0, -0.75),
-        (float)(45*RAD)
-    );
-
-    static unsigned int RAileronGrp[1] = {Raileron_Id};
-    static MGROUP_ROTATE RAileron(
-        0,
-        RAileronGrp,
-        1,
-        (Axis_raileron_Location),
-        _V(1, 0, -0.75),
-        (float)(45*RAD)
-    );
-
-    anim_laileron = CreateAnimation(0.5);
-    anim_raileron = CreateAnimation(0.5);
-
-    AddAnimationComponent(anim_laileron, 0, 1, &LAileron);
-    AddAnimationComponent(anim_raileron, 0, 1, &RAileron);
-
-
-    //Cockpit animations
-
-    static unsigned int LYokeColumnGrp[2] = {LYoke_column_Id, LYoke_Id};
-    static MGROUP_ROTATE LYokeColumn(
-        uimesh_Cockpit,
-        LYokeColumnGrp,
-        2,
-        (Axis_LYoke_column_Location),
-        _V(-1, 0, 0),
-        (float)(30*RAD)
-    );
-
-    static unsigned int RYokeColumnGrp[2] = {RYoke_column_Id, RYoke_Id};
-    static MGROUP_ROTATE RYokeColumn(
-        uimesh_Cockpit,
-        RYokeColumnGrp,
-        2,
-        (Axis_RYoke_column_Location),
-        _V(-1, 0, 0),
-        (float)(30*RAD)
-    );
-
-    AddAnimationComponent(anim_elevator, 0, 1, &LYokeColumn);
-    AddAnimationComponent(anim_elevator, 0, 1, &RYokeColumn);
-
-    static unsigned int LYokeGrp[1] = {LYoke_Id};
-    static MGROUP_ROTATE LYoke(
-        uimesh_Cockpit,
-        LYokeGrp,
-        1,
-        (LYoke_Location),
-        _V(0, 0, -1),
-        (float)(90*RAD)
-    );
-
-    static unsigned int RYokeGrp[1] = {RYoke_Id};
-    static MGROUP_ROTATE RYoke(
-        uimesh_Cockpit,
-        RYokeGrp,
-        1,
-        (RYoke_Location),
-        _V(0, 0, -1),
-        (float)(90*RAD)
-    );
-
-    AddAnimationComponent(anim_laileron, 0, 1, &LYoke);
-    AddAnimationComponent(anim_laileron, 0, 1, &RYoke);
-
-    static unsigned int GearLeverGrp[1] = {Landing_gear_lever_Id};
-    static MGROUP_ROTATE GearLever(
-        uimesh_Cockpit,
-        GearLeverGrp,
-        1,
-        (Axis_landing_gear_lever_Location),
-        _V(1, 0, 0),
-        (float)(90*RAD)
-    );
-
-    AddAnimationComponent(anim_landing_gear, 0, 0.1, &GearLever);
-
-    //Telescope hatch
-
-    static unsigned int TelescopeHatchGrp[1] = {Telescope_hatch_Id};
-    static MGROUP_ROTATE TelescopeHatch(
-        0,
-        TelescopeHatchGrp,
-        1,
-        (Axis_telescope_Location),
-        _V(0, 0, 1),
-        (float)(-70*RAD)
-    );
-
-    anim_telescope_hatch = CreateAnimation(0.0);
-    AddAnimationComponent(anim_telescope_hatch, 0, 1, &TelescopeHatch);
+
+    //Built from Config/Boeing747/Animations; see InitModule.
+    const AnimBinding bindings[] = {
+        {"landing_gear", &anim_landing_gear, ANIM_ALWAYS},
+        {"engines", &anim_engines, ANIM_EXTERNAL},
+        {"elevator", &anim_elevator},
+        {"elevator_trim", &anim_elevator_trim},
+        {"rudder", &anim_rudder},
+        {"laileron", &anim_laileron},
+        {"raileron", &anim_raileron},
+        {"gear_lever", &anim_gear_lever, ANIM_VC},
+        {"yoke_pitch", &anim_yoke_pitch, ANIM_VC},
+        {"yoke_roll", &anim_yoke_roll, ANIM_VC},
+        {"flaps", &anim_flaps, ANIM_EXTERNAL},
+        {"flaps_lever", &anim_flaps_lever, ANIM_VC},
+        {"telescope_hatch", &anim_telescope_hatch, ANIM_ALWAYS},
+    };
+    std::vector<AnimBinding> list(std::begin(bindings), std::end(bindings));
+    for(int i = 0; i < CABIN_DOOR_COUNT; i++){
+        list.push_back({CABIN_DOOR_NAMES[i], &anim_cabin_doors[i], ANIM_EXTERNAL});
+    }
+    animations.Create(this, list.data(), (int)list.size(), &anim_sched);
 
 }
 
 void B747SOFIA::clbkSetClassCaps(FILEHANDLE cfg){
 
+    //Gear contact sets, built by the first vessel of the class and shared by the rest. With no
+    //GearContactSteps the gear up and gear down sets swap halfway through the transition.
+    if(!touchdown_sets.Built()){
+        int gear_contact_steps = 0;
+        oapiReadItem_int(cfg, "GearContactSteps", gear_contact_steps);
+        touchdown_sets.Build(tdvtx_geardown, ntdvtx_geardown, tdvtx_gearup, ntdvtx_gearup, gear_contact_steps);
+    }
+
+    //Seconds the cockpit and cabin meshes stay after the camera leaves the cockpit.
+    double vc_release_time = VC_RELEASE_TIME;
+    oapiReadItem_float(cfg, "VCReleaseTime", vc_release_time);
+    vc.Init(this, &meshes, B747SOFIA_VC_MESHES, sizeof(B747SOFIA_VC_MESHES)/sizeof(B747SOFIA_VC_MESHES[0]), vc_release_time);
+
+    //Camera distances, in metres, from which the distance levels of the airframe mesh are drawn.
+    double lod_distance[LOD_LEVELS];
+    for(int i = 0; i < LOD_LEVELS; i++){
+        char key[16];
+        sprintf(key, "LOD%dDistance", i + 1);
+        lod_distance[i] = LOD_DISTANCE[i];
+        oapiReadItem_float(cfg, key, lod_distance[i]);
+    }
+
     //Physical vessel parameters
     SetSize(B747SOFIA_SIZE);
     SetEmptyMass(B747SOFIA_EMPTYMASS);
@@ -482,13 +144,13 @@ void B747SOFIA::clbkSetClassCaps(FILEHANDLE cfg){
     th_main[1] = CreateThruster((ENG2_Location), _V(0, 0, 1), B747SOFIA_MAXMAINTH, JET_A1, B747SOFIA_ISP);
     th_main[2] = CreateThruster((ENG3_Location), _V(0, 0, 1), B747SOFIA_MAXMAINTH, JET_A1, B747SOFIA_ISP);
     th_main[3] = CreateThruster((ENG4_Location), _V(0, 0, 1), B747SOFIA_MAXMAINTH, JET_A1, B747SOFIA_ISP);
-    thg_main = CreateThrusterGroup(th_main, 4, THGROUP_MAIN);
 
     th_retro[0] = CreateThruster((ENG1_Location), _V(0, 0, -1), (B747SOFIA_MAXMAINTH/4), JET_A1, B747SOFIA_ISP);
     th_retro[1] = CreateThruster((ENG2_Location), _V(0, 0, -1), (B747SOFIA_MAXMAINTH/4), JET_A1, B747SOFIA_ISP);
     th_retro[2] = CreateThruster((ENG3_Location), _V(0, 0, -1), (B747SOFIA_MAXMAINTH/4), JET_A1, B747SOFIA_ISP);
     th_retro[3] = CreateThruster((ENG4_Location), _V(0, 0, -1), (B747SOFIA_MAXMAINTH/4), JET_A1, B747SOFIA_ISP);
-    thg_retro = CreateThrusterGroup(th_retro, 4, THGROUP_RETRO);
+
+    engine_state.Init(this, th_main, th_retro, 4);
 
 	//Contrail effect on engines
     static PARTICLESTREAMSPEC engines_contrails = {
@@ -497,14 +159,14 @@ void B747SOFIA::clbkSetClassCaps(FILEHANDLE cfg){
 		PARTICLESTREAMSPEC::LVL_PLIN, -1.0, 25.0,
 		PARTICLESTREAMSPEC::ATM_PLIN, 
     };
-	AddParticleStream(&engines_contrails, (ENG1_Location), _V(0, 0, -1), &lvlcontrailengines);
-    AddParticleStream(&engines_contrails, (ENG2_Location), _V(0, 0, -1), &lvlcontrailengines);
-    AddParticleStream(&engines_contrails, (ENG3_Location), _V(0, 0, -1), &lvlcontrailengines);
-    AddParticleStream(&engines_contrails, (ENG4_Location), _V(0, 0, -1), &lvlcontrailengines);
+	AddParticleStream(&engines_contrails, (ENG1_Location), _V(0, 0, -1), &state.lvlcontrailengines);
+    AddParticleStream(&engines_contrails, (ENG2_Location), _V(0, 0, -1), &state.lvlcontrailengines);
+    AddParticleStream(&engines_contrails, (ENG3_Location), _V(0, 0, -1), &state.lvlcontrailengines);
+    AddParticleStream(&engines_contrails, (ENG4_Location), _V(0, 0, -1), &state.lvlcontrailengines);
 
-	lwing = CreateAirfoil3(LIFT_VERTICAL, (Left_wing_Location), VLiftCoeff, 0, B747SOFIA_VLIFT_C, (B747SOFIA_VLIFT_S*4), B747SOFIA_VLIFT_A);
+	lwing = CreateAirfoil3(LIFT_VERTICAL, (Left_wing_Location), VLiftCoeff, &flaps, B747SOFIA_VLIFT_C, (B747SOFIA_VLIFT_S*4), B747SOFIA_VLIFT_A);
 
-    rwing = CreateAirfoil3(LIFT_VERTICAL,(Right_wing_Location), VLiftCoeff, 0, B747SOFIA_VLIFT_C,(B747SOFIA_VLIFT_S*4), B747SOFIA_VLIFT_A);
+    rwing = CreateAirfoil3(LIFT_VERTICAL,(Right_wing_Location), VLiftCoeff, &flaps, B747SOFIA_VLIFT_C,(B747SOFIA_VLIFT_S*4), B747SOFIA_VLIFT_A);
 
     lstabilizer = CreateAirfoil3(LIFT_VERTICAL, (Left_stabilizer_Location), VLiftCoeff, 0, B747SOFIA_STAB_C, B747SOFIA_STAB_S, B747SOFIA_STAB_A);
 
@@ -524,12 +186,10 @@ void B747SOFIA::clbkSetClassCaps(FILEHANDLE cfg){
     CreateControlSurface3(AIRCTRL_RUDDER, 20.6937, 1.7, (Rudder_Location), AIRCTRL_AXIS_AUTO, 1.0, anim_rudder);
 
     //Add the mesh
-    SetMeshVisibilityMode (AddMesh (B747SOFIA_mesh = oapiLoadMeshGlobal ("Boeing747\\Boeing_747SOFIA")), MESHVIS_EXTERNAL);
+    SetMeshVisibilityMode (AddMesh (B747SOFIA_mesh = meshes.Load("Boeing747\\Boeing_747SOFIA")), MESHVIS_EXTERNAL);
+    lods.Init(this, &meshes, "Boeing747\\Boeing_747SOFIA", lod_distance);
     //AddMesh(B747SOFIA_mesh);
 
-    //Add the mesh for the cockpit
-    SetMeshVisibilityMode(AddMesh(mhcockpit_mesh = oapiLoadMeshGlobal("Boeing747\\Boeing_747_cockpit")), MESHVIS_VC);
-
     //Define beacons
 
     static VECTOR3 beaconpos_green[2] = { {Beacon2_right_wing_Location}, {Beacon3_upper_deck_Location}};
@@ -581,17 +241,33 @@ void B747SOFIA::clbkSetClassCaps(FILEHANDLE cfg){
 		AddBeacon(beaconwhite+i);
 	}
 
+    //All off until switched on; the switches only activate them.
+    lights.Create(this, B747SOFIA_LIGHTS, sizeof(B747SOFIA_LIGHTS)/sizeof(B747SOFIA_LIGHTS[0]));
+
+}
+
+void B747SOFIA::clbkVisualCreated(VISHANDLE vis, int refcount){
+
+    B747_PROFILE_SCOPE(PROF_VISUALCREATED);
+
+    anim_sched.SetVisual(true);
+
+}
+
+void B747SOFIA::clbkVisualDestroyed(VISHANDLE vis, int refcount){
+
+    anim_sched.SetVisual(false);
 
 }
 
 void B747SOFIA::ParkingBrake(){
 
-    if(!parkingBrakeEnabled){
+    if(!state.parking_brake){
         SetWheelbrakeLevel(1, 0, true);
-        parkingBrakeEnabled = true;
+        state.parking_brake = true;
     } else {
         SetWheelbrakeLevel(0, 0, true);
-        parkingBrakeEnabled = false;
+        state.parking_brake = false;
     }
 
 }
@@ -626,65 +302,39 @@ void B747SOFIA::ActivateBeacons(){
 
 void B747SOFIA::LightsControl(void){
 
-    if(!lights_on){
-        l1 = AddSpotLight((LIGHT1_Location), _V(0, 0, 1), 100000, 1e-3, 0, 2e-3, 25*RAD, 45*RAD, col_d, col_s, col_a);
-        l2 = AddSpotLight((LIGHT2_Location), _V(0, 0, 1), 100000, 1e-3, 0, 2e-3, 25*RAD, 45*RAD, col_d, col_s, col_a);
-        l3 = AddSpotLight((LIGHT3_Location), _V(0, 0, 1), 100000, 1e-3, 0, 2e-3, 25*RAD, 45*RAD, col_d, col_s, col_a);
-        l4 = AddSpotLight((LIGHT4_Location), _V(0, 0, 1), 100000, 1e-3, 0, 2e-3, 25*RAD, 45*RAD, col_d, col_s, col_a);
-
-        cpl1 = AddPointLight((PL1_Location), 1, 0.15, 0, 0.15, ccol_d, ccol_s, ccol_a);
-        cpl1->SetVisibility(LightEmitter::VIS_COCKPIT);
-        cpl2 = AddPointLight((PL2_Location), 1, 0.15, 0, 0.15, ccol_d, ccol_s, ccol_a);
-        cpl2->SetVisibility(LightEmitter::VIS_COCKPIT);
+    lights.SetAll(!lights.AnyOn());
 
-        lights_on = true;
-    } else {
-        DelLightEmitter(l1);
-        DelLightEmitter(l2);
-        DelLightEmitter(l3);
-        DelLightEmitter(l4);
-
-        DelLightEmitter(cpl1);
-        DelLightEmitter(cpl2);
-
-        lights_on = false;
-    }
 }
 
 void B747SOFIA::EnginesAutostart(void){
 
-    engines_on = true;
-    enginevalue = 1;
-    m_pXRSound->PlayWav(engines_start);
+    if(engine_state.Start()){
+        m_pXRSound->PlayWav(engines_start);
+    }
     
 }
 
 void B747SOFIA::EnginesAutostop(void){
 
-    engines_on = false;
-    enginevalue = 0;
-    m_pXRSound->PlayWav(engines_shutdown);
+    if(engine_state.Stop()){
+        m_pXRSound->PlayWav(engines_shutdown);
+    }
     
 }
 
-void B747SOFIA::UpdateEnginesStatus(){
-
-    if(engines_on == true){
-        thg_main = CreateThrusterGroup(th_main, 4, THGROUP_MAIN);
-
-        thg_retro = CreateThrusterGroup(th_retro, 4, THGROUP_RETRO);
+void B747SOFIA::UpdateEnginesStatus(double simdt, const FlightState &flight){
 
-        pwr = GetThrusterLevel(thg_main);
+    engine_state.Update(simdt, flight);
 
-    } else if (engines_on == false){
-        DelThrusterGroup(thg_main);
-        DelThrusterGroup(thg_retro);
-        pwr = 0;
-    }
+    state.pwr = engine_state.GetPower();
 }
 
 bool B747SOFIA::clbkLoadVC(int id){
 
+    B747_PROFILE_SCOPE(PROF_LOADVC);
+
+    vc.Load(lights);
+
     static VCMFDSPEC mfds_1 = {1, MFD1_Id};
     oapiVCRegisterMFD(MFD_LEFT, &mfds_1);
 
@@ -721,10 +371,16 @@ bool B747SOFIA::clbkLoadVC(int id){
 
 int B747SOFIA::clbkConsumeBufferedKey(int key, bool down, char *kstate){
 
+    B747_PROFILE_SCOPE(PROF_CONSUMEKEY);
+
     if(key == OAPI_KEY_G && down){
         SetGearDown();
         return 1;
     }
+    if((key == OAPI_KEY_COMMA || key == OAPI_KEY_PERIOD) && down){
+        OperateFlaps(key == OAPI_KEY_PERIOD ? 1 : -1);
+        return 1;
+    }
     if(key == OAPI_KEY_NUMPADENTER && down){
         ParkingBrake();
         return 1;
@@ -734,13 +390,27 @@ int B747SOFIA::clbkConsumeBufferedKey(int key, bool down, char *kstate){
         return 1;
     }
     if(key == OAPI_KEY_F && down){
-        LightsControl();
+        if(KEYMOD_SHIFT(kstate)) lights.Toggle(LIGHTS_LANDING);
+        else if(KEYMOD_CONTROL(kstate)) lights.Toggle(LIGHTS_COCKPIT);
+        else if(KEYMOD_ALT(kstate)) lights.Toggle(LIGHTS_CABIN);
+        else LightsControl();
         return 1;
     }
     if(key == OAPI_KEY_D && down){
         OpenTelescopeHatch();
         return 1;
     }
+    if(key == OAPI_KEY_K && down){
+        OperateCabinDoors();
+        return 1;
+    }
+    if(down){
+        int door = CabinDoorKey(key, kstate);
+        if(door >= 0){
+            OperateCabinDoor(door);
+            return 1;
+        }
+    }
     if(down){
         if(KEYMOD_CONTROL(kstate)){
             switch(key){
@@ -764,23 +434,32 @@ void B747SOFIA::clbkLoadStateEx(FILEHANDLE scn, void *vs){
 
     while(oapiReadScenario_nextline(scn, line)){
         if(!strncasecmp(line, "GEAR", 4)){
-            sscanf(line+4, "%d%lf", (int *)&landing_gear_status, &landing_gear_proc);
-            SetAnimation(anim_landing_gear, landing_gear_proc);
-            if (landing_gear_proc == 1.0){
-                bGearIsDown = true;
-            } else {
-                bGearIsDown = false;
-            }
-        } else if (!strncasecmp(line+9, "TELESCOPE", 9)){
-            sscanf(line+4, "%d%lf", (int *)&telescope_hatch_status, &telescope_hatch_proc);
-            SetAnimation(anim_telescope_hatch, telescope_hatch_proc);
+            int status = 0;
+            double proc = 0.0;
+            sscanf(line+4, "%d%lf", &status, &proc);
+            parts.Set(*this, PART_GEAR, status, proc);
+        } else if(!strncasecmp(line, "FLAPS", 5)){
+            int detent = 0;
+            double angle = 0.0;
+            sscanf(line+5, "%d%lf", &detent, &angle);
+            flaps.Set(detent, angle);
+            anim_sched.Set(anim_flaps, flaps.FlapState());
+            anim_sched.Set(anim_flaps_lever, flaps.LeverState());
+        } else if (!strncasecmp(line, "TELESCOPE", 9)){
+            int status = 0;
+            double proc = 0.0;
+            sscanf(line+9, "%d%lf", &status, &proc);
+            parts.Set(*this, PART_HATCH, status, proc);
+        } else if (!strncasecmp(line, "DOOR", 4)){
+            LoadCabinDoor(*this, parts, PART_CABIN_DOOR1, line);
+        } else if (!strncasecmp(line, "LIGHTS", 6)){
+            int lightsvalue = 0;
+            sscanf(line+6, "%d", &lightsvalue);
+            lights.SetMask(lightsvalue);
         } else if (!strncasecmp(line, "ENGINES", 7)){
+            int enginevalue = 0;
             sscanf(line+7, "%d", &enginevalue);
-            if(enginevalue == 1){
-                engines_on = true;
-            } else {
-                engines_on = false;
-            }
+            engine_state.SetRunning(enginevalue == 1);
         } else {
             ParseScenarioLineEx(line, vs);
         }
@@ -793,82 +472,77 @@ void B747SOFIA::clbkSaveState(FILEHANDLE scn){
 
     SaveDefaultState(scn);
 
-    sprintf(cbuf, "%d %0.4f", landing_gear_status, landing_gear_proc);
+    sprintf(cbuf, "%d %0.4f", parts.Status(PART_GEAR), parts.Proc(PART_GEAR));
     oapiWriteScenario_string(scn, "GEAR", cbuf);
 
-    sprintf(cbuf, "%d %0.4f", telescope_hatch_status, telescope_hatch_proc);
+    if(flaps.Lever() || flaps.Angle() > 0.0){
+        sprintf(cbuf, "%d %0.4f", flaps.Lever(), flaps.Angle());
+        oapiWriteScenario_string(scn, "FLAPS", cbuf);
+    }
+
+    SaveCabinDoors(scn, parts, PART_CABIN_DOOR1);
+
+    sprintf(cbuf, "%d %0.4f", parts.Status(PART_HATCH), parts.Proc(PART_HATCH));
     oapiWriteScenario_string(scn, "TELESCOPE", cbuf);
 
-    oapiWriteScenario_int(scn, "ENGINES", enginevalue);
+    oapiWriteScenario_int(scn, "ENGINES", engine_state.GetScenarioValue());
+
+    oapiWriteScenario_int(scn, "LIGHTS", lights.GetMask());
 
 }
 
 //////////Logic for animations
 void B747SOFIA::SetGearDown(void){
-    ActivateLandingGear((landing_gear_status == GEAR_DOWN || landing_gear_status == GEAR_DEPLOYING) ?
-        GEAR_STOWING : GEAR_DEPLOYING);
+    parts.Toggle(PART_GEAR, m_pXRSound);
 }
 
-void B747SOFIA::ActivateLandingGear(LandingGearStatus action){
-    landing_gear_status = action;
+void B747SOFIA::OperateFlaps(int dir){
+    if(flaps.Step(dir)) anim_sched.Set(anim_flaps_lever, flaps.LeverState());
 }
 
-void B747SOFIA::UpdateLandingGearAnimation(double simdt) {
-    if (landing_gear_status >= GEAR_DEPLOYING) {
-        double da = simdt * LANDING_GEAR_OPERATING_SPEED;
-        if (landing_gear_status == GEAR_DEPLOYING) {
-            if (landing_gear_proc > 0.0) landing_gear_proc = std::max(0.0, landing_gear_proc - da);
-            else landing_gear_status = GEAR_DOWN;
-            SetTouchdownPoints(tdvtx_geardown, ntdvtx_geardown);
-            bGearIsDown = true;
-        } else {
-            if (landing_gear_proc < 1.0) landing_gear_proc = std::min(1.0, landing_gear_proc + da);
-            else landing_gear_status = GEAR_UP;
-            SetTouchdownPoints(tdvtx_gearup, ntdvtx_gearup);
-            bGearIsDown = true;
-        }
-        SetAnimation(anim_landing_gear, landing_gear_proc);
-    }
+void B747SOFIA::OperateCabinDoor(int door){
+    parts.Toggle(PART_CABIN_DOOR1 + door, m_pXRSound);
+}
+
+void B747SOFIA::OperateCabinDoors(void){
+    parts.ToggleAll(CabinDoorMask(PART_CABIN_DOOR1), m_pXRSound);
+}
+
+void B747SOFIA::GearTraits::Moved(B747SOFIA &v, double proc){
+    v.anim_sched.Set(v.anim_landing_gear, proc);
+    v.anim_sched.Set(v.anim_gear_lever, proc);
+    v.gear_contact.Update(&v, touchdown_sets, proc);
+}
+
+void B747SOFIA::GearTraits::Detent(B747SOFIA &v, DeployStatus at){
+    v.state.gear_down = at == DEPLOY_AT_0;
+    v.SetNosewheelSteering(touchdown_sets.Wheels(v.gear_contact.Current()));
+}
+
+void B747SOFIA::PartsSystem::Run(B747SOFIA &v, double dt, const FlightState &flight){
+    v.parts.Update(v, dt);
+    if(v.flaps.Update(dt)) v.anim_sched.Set(v.anim_flaps, v.flaps.FlapState());
 }
 
 void B747SOFIA::UpdateGearStatus(void){
-    if(!bGearIsDown){
-        SetTouchdownPoints(tdvtx_geardown, ntdvtx_geardown);
-        SetNosewheelSteering(true);
-    } else if (bGearIsDown){
-        SetTouchdownPoints(tdvtx_gearup, ntdvtx_gearup);
-        SetNosewheelSteering(false);
-    }
+    gear_contact.Update(this, touchdown_sets, parts.Proc(PART_GEAR));
+    SetNosewheelSteering(touchdown_sets.Wheels(gear_contact.Current()));
 }
 
 void B747SOFIA::OpenTelescopeHatch(void){
-    ActivateTelescopeHatch((telescope_hatch_status == HATCH_CLOSED || telescope_hatch_status == HATCH_OPENING) ?
-        HATCH_CLOSING : HATCH_OPENING);
+    parts.Toggle(PART_HATCH, m_pXRSound);
 }
 
-void B747SOFIA::ActivateTelescopeHatch(TelescopeHatchStatus action){
-    telescope_hatch_status = action;
+void B747SOFIA::HatchTraits::Moved(B747SOFIA &v, double proc){
+    v.anim_sched.Set(v.anim_telescope_hatch, proc);
 }
 
-void B747SOFIA::UpdateTelescopeHatchAnimation(double simdt) {
-    if (telescope_hatch_status >= HATCH_OPENING) {
-        double da = simdt * LANDING_GEAR_OPERATING_SPEED;
-        if (telescope_hatch_status == HATCH_OPENING) {
-            if (telescope_hatch_proc > 0.0) telescope_hatch_proc = std::max(0.0, telescope_hatch_proc - da);
-            else telescope_hatch_status = HATCH_CLOSED;
-        } else {
-            if (telescope_hatch_proc < 1.0) telescope_hatch_proc = std::min(1.0, telescope_hatch_proc + da);
-            else telescope_hatch_status = HATCH_OPEN;
-        }
-        SetAnimation(anim_telescope_hatch, telescope_hatch_proc);
-    }
+void B747SOFIA::HatchTraits::Detent(B747SOFIA &v, DeployStatus at){
 }
 
-double B747SOFIA::UpdateLvlEnginesContrail(){
-    double machnumber = GetMachNumber();
-    double altitude = GetAltitude();
+double B747SOFIA::UpdateLvlEnginesContrail(const FlightState &flight){
 
-    if((machnumber > 0.5) && ((altitude > 10000) && (altitude < 15000))){
+    if((flight.mach > 0.5) && ((flight.altitude > 10000) && (flight.altitude < 15000))){
         return 1.0;
     } else {
         return 0.0;
@@ -877,10 +551,9 @@ double B747SOFIA::UpdateLvlEnginesContrail(){
 }
 
 void B747SOFIA::clbkPostStep(double simt, double simdt, double mjd){
-    UpdateLandingGearAnimation(simdt);
-    UpdateTelescopeHatchAnimation(simdt);
-    lvlcontrailengines = UpdateLvlEnginesContrail();
-    UpdateEnginesStatus();
+    B747_PROFILE_SCOPE(PROF_POSTSTEP);
+
+    systems.Update(*this, simdt, flight);
 }
 
 void B747SOFIA::clbkPostCreation(){
@@ -905,22 +578,29 @@ void B747SOFIA::clbkPostCreation(){
 
     m_pXRSound->LoadWav(gear_movement, "XRSound\\Default\\Gear Whine.wav", XRSound::PlaybackType::BothViewMedium);
 
+    m_pXRSound->LoadWav(door_movement, "XRSound\\Default\\Hydraulics1.wav", XRSound::PlaybackType::BothViewMedium);
+
 }
 
 void B747SOFIA::clbkPreStep(double simt, double simdt, double mjd){
 
-    double grndspd = GetGroundspeed();
-    double pwr = GetThrusterLevel(th_main);
-    double prp = GetAnimation(anim_engines);
+    B747_PROFILE_SCOPE(PROF_PRESTEP);
+
+    //The one read of the flight values this step, of the fields the systems running this step read.
+    flight.Sample(this, systems.Fields(*this, simdt));
+
+    anim_sched.Update();
+
     double msimdt = simdt * ENGINE_ROTATION_SPEED;
-    double da = msimdt * 0.1 + (pwr * 0.1);
+    double da = (msimdt * 0.1 + (state.pwr * 0.1)) * engine_state.GetSpool();
 
-    engines_proc = prp + da;
+    state.engines_proc = fmod(state.engines_proc + da, 1.0);
+    anim_sched.Set(anim_engines, state.engines_proc);
 
-    if(prp < 1){
-        SetAnimation(anim_engines, engines_proc);
-    } else {
-        SetAnimation(anim_engines, 0.0);
+    //Orbiter animates the control surfaces; the yokes follow them with the same mapping.
+    if(anim_sched.InVC()){
+        anim_sched.Set(anim_yoke_pitch, (GetControlSurfaceLevel(AIRCTRL_ELEVATOR) + 1.0)*0.5);
+        anim_sched.Set(anim_yoke_roll, (GetControlSurfaceLevel(AIRCTRL_AILERON) + 1.0)*0.5);
     }
 }
 
@@ -928,11 +608,25 @@ void B747SOFIA::clbkPreStep(double simt, double simdt, double mjd){
 
 DLLCLBK void InitModule(MODULEHANDLE hModule){
 
+    aero.Load("B747SOFIA", B747SOFIA_VLIFT_A, B747SOFIA_HLIFT_A);
+
+    flap_polars.Build();
+
+    animations.AnimateCopies(0, LOD_MESH_INDEX, LOD_LEVELS);
+    animations.Load("B747SOFIA");
 
 }
 
 DLLCLBK void ExitModule(MODULEHANDLE *hModule){
 
+    B747_PROFILE_DUMP("B747SOFIA");
+
+    aero.Release();
+
+    animations.Clear();
+
+    meshes.Clear();
+
 }
 
 
@@ -11,6 +11,21 @@
 #include "747SOFIAdefinitions.h"
 #include "747cockpitdefinitions.h"
 #include "XRSound.h"
+#include "B747Profiler.h"
+#include "B747Engines.h"
+#include "B747Aero.h"
+#include "B747State.h"
+#include "B747Flight.h"
+#include "B747Systems.h"
+#include "B747Mesh.h"
+#include "B747VC.h"
+#include "B747LOD.h"
+#include "B747Lights.h"
+#include "B747Gear.h"
+#include "B747Anim.h"
+#include "B747Deploy.h"
+#include "B747Flaps.h"
+#include "B747Doors.h"
 
 
 //Vessel parameters
@@ -25,7 +40,7 @@ const double B747SOFIA_ISP = 100000; //Fuel-specific impulse in m/s.
 
 const double B747SOFIA_MAXMAINTH = 400e3; //Max main thrust in kN.
 
-const double LANDING_GEAR_OPERATING_SPEED = 0.06;
+constexpr double LANDING_GEAR_OPERATING_SPEED = 0.06;
 
 const double ENGINE_ROTATION_SPEED = 10;
 
@@ -118,27 +133,79 @@ class B747SOFIA : public VESSEL4{
 
     public:
         
-        enum MySounds {engines_start, engines_shutdown, engines, cabin_ambiance, rotate, gear_movement};
+        enum MySounds {engines_start, engines_shutdown, engines, cabin_ambiance, rotate, gear_movement, door_movement};
         
-        enum LandingGearStatus{GEAR_DOWN, GEAR_UP, GEAR_DEPLOYING, GEAR_STOWING} landing_gear_status;
-
-        enum TelescopeHatchStatus{HATCH_CLOSED, HATCH_OPEN, HATCH_OPENING, HATCH_CLOSING} telescope_hatch_status;
+        //Parts moved by `parts`, and how each kind moves; see B747Deploy.h.
+        enum Part{PART_GEAR, PART_HATCH, PART_CABIN_DOOR1, PART_COUNT = PART_CABIN_DOOR1 + CABIN_DOOR_COUNT};
+
+        struct GearTraits {
+            static constexpr double SPEED = LANDING_GEAR_OPERATING_SPEED;
+            static constexpr int SOUND = -1;
+            static void Moved(B747SOFIA &v, double proc);
+            static void Detent(B747SOFIA &v, DeployStatus at);
+        };
+
+        struct HatchTraits {
+            static constexpr double SPEED = LANDING_GEAR_OPERATING_SPEED;
+            static constexpr int SOUND = -1;
+            static void Moved(B747SOFIA &v, double proc);
+            static void Detent(B747SOFIA &v, DeployStatus at);
+        };
+
+        template<int I> struct CabinDoorTraits {
+            static constexpr double SPEED = CABIN_DOOR_OPERATING_SPEED;
+            static constexpr int SOUND = door_movement;
+            static void Moved(B747SOFIA &v, double proc){ v.anim_sched.Set(v.anim_cabin_doors[I], proc); }
+            static void Detent(B747SOFIA &v, DeployStatus at){}
+        };
+
+        //Systems run by `systems`, and how often; see B747Systems.h.
+        enum System{SYSTEM_PARTS, SYSTEM_ENGINES, SYSTEM_CONTRAILS, SYSTEM_VC, SYSTEM_LOD, SYSTEM_COUNT};
+
+        struct PartsSystem {
+            static constexpr double RATE = SYSTEM_EVERY_FRAME;
+            static unsigned int Fields(const B747SOFIA &v){ return 0; }
+            static void Run(B747SOFIA &v, double dt, const FlightState &flight);
+        };
+
+        struct EnginesSystem {
+            static constexpr double RATE = 50.0;
+            static unsigned int Fields(const B747SOFIA &v){ return v.engine_state.FlightFields(); }
+            static void Run(B747SOFIA &v, double dt, const FlightState &flight){ v.UpdateEnginesStatus(dt, flight); }
+        };
+
+        struct ContrailSystem {
+            static constexpr double RATE = 1.0;
+            static unsigned int Fields(const B747SOFIA &v){ return FLIGHT_MACH | FLIGHT_ALTITUDE; }
+            static void Run(B747SOFIA &v, double dt, const FlightState &flight){ v.state.lvlcontrailengines = v.UpdateLvlEnginesContrail(flight); }
+        };
+
+        struct VCSystem {
+            static constexpr double RATE = 1.0;
+            static unsigned int Fields(const B747SOFIA &v){ return 0; }
+            static void Run(B747SOFIA &v, double dt, const FlightState &flight){ v.vc.Update(v.anim_sched.InVC(), dt, v.lights); }
+        };
+
+        struct LODSystem {
+            static constexpr double RATE = 4.0;
+            static unsigned int Fields(const B747SOFIA &v){ return 0; }
+            static void Run(B747SOFIA &v, double dt, const FlightState &flight){ v.lods.Update(); }
+        };
 
         B747SOFIA(OBJHANDLE hVessel, int flightmodel);
         virtual ~B747SOFIA();
         
         void DefineAnimations(void);
 
-        void ActivateLandingGear(LandingGearStatus action);
         void SetGearDown(void);
+        void OperateFlaps(int dir);
+        void OperateCabinDoor(int door);
+        void OperateCabinDoors(void);
         void UpdateGearStatus(void);
 
-        void UpdateLandingGearAnimation(double);
-        void ActivateTelescopeHatch(TelescopeHatchStatus telescope_hatch_status);
         void OpenTelescopeHatch(void);
-        void UpdateTelescopeHatchAnimation(double);
 
-        double UpdateLvlEnginesContrail();
+        double UpdateLvlEnginesContrail(const FlightState &flight);
 
         void ParkingBrake();
 
@@ -148,7 +215,7 @@ class B747SOFIA : public VESSEL4{
 
         void EnginesAutostart(void);
         void EnginesAutostop(void);
-        void UpdateEnginesStatus(void);
+        void UpdateEnginesStatus(double, const FlightState &);
 
         void clbkSetClassCaps(FILEHANDLE cfg) override;
         void clbkLoadStateEx(FILEHANDLE scn, void *vs) override;
@@ -160,6 +227,9 @@ class B747SOFIA : public VESSEL4{
 
         bool clbkLoadVC(int) override;
 
+        void clbkVisualCreated(VISHANDLE vis, int refcount) override;
+        void clbkVisualDestroyed (VISHANDLE vis, int refcount) override;
+
         MESHHANDLE B747SOFIA_mesh, mhcockpit_mesh;  //Mesh handle
         unsigned int uimesh_Cockpit = 1;
 
@@ -169,38 +239,33 @@ class B747SOFIA : public VESSEL4{
     private:
 
         unsigned int anim_landing_gear;
-        unsigned int anim_door;
+        unsigned int anim_cabin_doors[CABIN_DOOR_COUNT];
         unsigned int anim_laileron;
         unsigned int anim_raileron;
         unsigned int anim_elevator;
         unsigned int anim_elevator_trim;
         unsigned int anim_rudder;
         unsigned int anim_engines;
+        unsigned int anim_gear_lever, anim_yoke_pitch, anim_yoke_roll;
+        unsigned int anim_flaps, anim_flaps_lever;
         unsigned int anim_telescope_hatch;
 
-        double lvlcontrailengines;
-        double landing_gear_proc;
-        double engines_proc;
-        double telescope_hatch_proc;
-        double pwr;
+        B747State state;
+        FlightState flight;           //Sampled at the start of clbkPreStep
+        Systems<B747SOFIA, SYSTEM_COUNT> systems;  //Run from clbkPostStep, each at its own rate
 
         AIRFOILHANDLE lwing, rwing, lstabilizer, rstabilizer;
         CTRLSURFHANDLE hlaileron, hraileron;
         THRUSTER_HANDLE th_main[4], th_retro[4];
-        THGROUP_HANDLE thg_main, thg_retro;
+        EngineStateMachine engine_state;
         BEACONLIGHTSPEC beacongreen[2], beaconred[2], beaconwhite[1];
-        LightEmitter *l1, *l2, *l3, *l4, *cpl1, *cpl2;
-        
-
-        COLOUR4 col_d = {0.9,0.8,1,0};
-	    COLOUR4 col_s = {1.9,0.8,1,0};
-	    COLOUR4 col_a = {0,0,0,0};
-        COLOUR4 ccol_d = {1, 0.508, 0.100};
-        COLOUR4 ccol_s = {1, 0.508, 0.100};
-        COLOUR4 ccol_a = {1, 0.508, 0.100};
-        COLOUR4 fccol_d = {1, 1, 1};
-        COLOUR4 fccol_s = {1, 1, 1};
-        COLOUR4 fccol_a = {1, 1, 1};
+        LightGroups lights;
+        VCResources vc;               //Cockpit and cabin meshes, loaded on the first clbkLoadVC
+        LODMeshes lods;               //Distance levels of the airframe mesh
+        GearContact gear_contact;     //Touchdown set in place, from the module's TouchdownSets
+        AnimScheduler anim_sched;     //Sends the animation states the vessel code drives
+        Deployables<B747SOFIA, PART_COUNT> parts;  //Gear and the other moving parts, advanced in clbkPostStep
+        FlapSystem flaps;             //Lever detent and flap angle
 
 };
 
@@ -60,6 +60,8 @@
     const UINT ENG4_Id = 50;
     const UINT ENG4_blades_Id = 51;
     const UINT APU_engine_exhaust_Id = 52;
+    const UINT Flaps_right_Id = 53;
+    const UINT Flaps2_right_Id = 54;
     constexpr VECTOR3 Fuselage_Location =     {0.0407, 5.5787, 3.7052};
     constexpr VECTOR3 Vertical_stabilizer_Location =     {0.0301, 11.8905, -20.0546};
     constexpr VECTOR3 Right_stabilizer_Location =     {5.1018, 6.9979, -22.4832};
@@ -15,70 +15,74 @@
 #include <cstdio>
 #include <algorithm>
 
-bool parkingBrakeEnabled;
-bool lights_on;
-static int currentSkin = 0;
-bool bGearIsDown;
-bool engines_on;
-int enginevalue;
-
 
 // 1. vertical lift component
 
+static AeroPolars aero;
+static TouchdownSets touchdown_sets;
+static AnimationSet animations;
+static FlapPolars flap_polars;
+static MeshCache meshes;
+
+//Virtual cockpit meshes, added by clbkLoadVC; see B747VC.h.
+static const VCMeshSpec B747400_VC_MESHES[] = {
+    {"Boeing747\\Boeing_747_cockpit", 1},
+    {"Boeing747\\Boeing_747_first_class", 2},
+};
+
+//Light emitters by group, created in clbkSetClassCaps; the cockpit and cabin ones with the VC meshes.
+static const LightSpec B747400_LIGHTS[] = {
+    {LIGHTS_LANDING, LIGHT1_Location},
+    {LIGHTS_LANDING, LIGHT2_Location},
+    {LIGHTS_LANDING, LIGHT3_Location},
+    {LIGHTS_LANDING, LIGHT4_Location},
+    {LIGHTS_COCKPIT, PL1_Location},
+    {LIGHTS_COCKPIT, PL2_Location},
+    {LIGHTS_CABIN, FC_PL1_Location},
+    {LIGHTS_CABIN, FC_PL2_Location},
+    {LIGHTS_CABIN, FC_PL3_Location},
+    {LIGHTS_CABIN, FC_PL4_Location},
+    {LIGHTS_CABIN, FC_PL5_Location},
+    {LIGHTS_CABIN, FC_PL6_Location},
+    {LIGHTS_CABIN, FC_PL7_Location},
+    {LIGHTS_CABIN, FC_PL8_Location},
+    {LIGHTS_CABIN, FC_PL9_Location},
+    {LIGHTS_CABIN, FC_PL10_Location},
+    {LIGHTS_CABIN, FC_PL11_Location},
+    {LIGHTS_CABIN, FC_PL12_Location},
+};
+
+static LiveryCache liveries;
+
+static LiveryIndex skins;
+
+static LiveryPrefetcher prefetch;
+
 void VLiftCoeff (VESSEL *v, double aoa, double M, double Re, void *context, double *cl, double *cm, double *cd)
 {
-	const int nabsc = 9;
-	static const double AOA[nabsc] = {-180*RAD,-60*RAD,-30*RAD, -15*RAD, 0*RAD,15*RAD,30*RAD,60*RAD,180*RAD};
-	static const double CL[nabsc]  = {   0,    -0.56,   -0.56,   -0.16,  0.15,  0.46,  0.56,  0.56,  0.00};
-	static const double CM[nabsc]  = {    0,    0.00,   0.00,     0.00,  0.00,  0.00,  0.00,  0.00,  0.00};
-
-
-	int i;
-	for (i = 0; i < nabsc-1 && AOA[i+1] < aoa; i++);
-	if (i < nabsc - 1) {
-		double f = (aoa - AOA[i]) / (AOA[i + 1] - AOA[i]);
-		*cl = CL[i] + (CL[i + 1] - CL[i]) * f;  // aoa-dependent lift coefficient
-		*cm = CM[i] + (CM[i + 1] - CM[i]) * f;  // aoa-dependent moment coefficient
-	}
-	else {
-		*cl = CL[nabsc - 1];
-		*cm = CM[nabsc - 1];
-	}
-	double saoa = sin(aoa);
-	double pd = 0.015 + 0.4*saoa*saoa;  // profile drag
-	*cd = pd + oapiGetInducedDrag (*cl, B747400_VLIFT_A, 0.7) + oapiGetWaveDrag (M, 0.75, 1.0, 1.1, 0.04);
-	// profile drag + (lift-)induced drag + transonic/supersonic wave (compressibility) drag
+	aero.vlift.Lookup(aoa, M, Re, cl, cm, cd);
+	if(context) ((const FlapSystem *)context)->Add(aoa, cl, cd);  //Wings only
 }
 
 // 2. horizontal lift component (vertical stabilisers and body)
 
 void HLiftCoeff (VESSEL *v, double beta, double M, double Re, void *context, double *cl, double *cm, double *cd)
 {
-	int i;
-	const int nabsc = 8;
-	static const double BETA[nabsc] = {-180*RAD,-135*RAD,-90*RAD,-45*RAD,45*RAD,90*RAD,135*RAD,180*RAD};
-	static const double CL[nabsc]   = {       0,    +0.3,      0,   -0.3,  +0.3,     0,   -0.3,      0};
-	for (i = 0; i < nabsc-1 && BETA[i+1] < beta; i++);
-	if (i < nabsc - 1) {
-		*cl = CL[i] + (CL[i + 1] - CL[i]) * (beta - BETA[i]) / (BETA[i + 1] - BETA[i]);
-	}
-	else {
-		*cl = CL[nabsc - 1];
-	}
-	*cm = 0.0;
-	*cd = 0.015 + oapiGetInducedDrag (*cl, B747400_HLIFT_A, 0.6) + oapiGetWaveDrag (M, 0.75, 1.0, 1.1, 0.04);
+	aero.hlift.Lookup(beta, M, Re, cl, cm, cd);
 }
 
 //Constructor
 B747400::B747400(OBJHANDLE hVessel, int flightmodel) : VESSEL4(hVessel, flightmodel){
 
-    landing_gear_proc = 0.0;
+    parts.Add<GearTraits>(PART_GEAR);
+    flaps.Init(&flap_polars);
+    systems.Add<PartsSystem>(SYSTEM_PARTS);
+    systems.Add<EnginesSystem>(SYSTEM_ENGINES);
+    systems.Add<ContrailSystem>(SYSTEM_CONTRAILS);
+    systems.Add<VCSystem>(SYSTEM_VC);
+    systems.Add<LODSystem>(SYSTEM_LOD);
 
-	landing_gear_status = GEAR_DOWN;
-
-    engines_on = false;
-
-	DefineAnimations();
+    DefineAnimations();
 
     b747400_mesh = NULL;
 
@@ -86,377 +90,67 @@ B747400::B747400(OBJHANDLE hVessel, int flightmodel) : VESSEL4(hVessel, flightmo
 
     fccabin_mesh = NULL;
 
-    skinpath[0] = '\0';
-    for (int i = 0; i < 5; i++)
-        skin[i] = 0;
+    livery = NULL;
+    skinname[0] = '\0';
 
 }
 
 //Destructor
 B747400::~B747400(){
 
+    liveries.Release(livery);
+
 }
 
 void B747400::DefineAnimations(void){
-    
-    //Front landing gear
-
-    static unsigned int FrontLandingGearGrp[1] = {Front_landing_gear_Id};
-    static MGROUP_ROTATE FrontLandingGearRotate(
-        0,
-        FrontLandingGearGrp,
-        1,
-        (Axis_front_landing_gear_rotate_Location),
-        _V(1, 0, 0),
-        (float)(-110*RAD)
-    );
-
-    static unsigned int FrontLandingGearLeftDoorGrp[1] = {Front_landing_gear_left_door_Id};
-    static MGROUP_ROTATE FrontLandingGearLeftDoor(
-        0,
-        FrontLandingGearLeftDoorGrp,
-        1,
-        (Axis_front_landing_gear_left_door_Location),
-        _V(0, 0, 1),
-        (float)(90*RAD)
-    );
-
-    static unsigned int FrontLandingGearRightDoorGrp[1] = {Front_landing_gear_right_door_Id};
-    static MGROUP_ROTATE FrontLandingGearRightDoor(
-        0,
-        FrontLandingGearRightDoorGrp,
-        1,
-        (Axis_front_landing_gear_right_door_Location),
-        _V(0, 0, 1),
-        (float)(-90*RAD)
-    );
-
-    anim_landing_gear = CreateAnimation(0.0);
-
-    AddAnimationComponent(anim_landing_gear, 0, 0.25, &FrontLandingGearRotate);
-    AddAnimationComponent(anim_landing_gear, 0, 0.5, &FrontLandingGearLeftDoor);
-    AddAnimationComponent(anim_landing_gear, 0, 0.5, &FrontLandingGearRightDoor);
-
-    //Rear landing gears
-
-    static unsigned int RearLeftWingLandingGearGrp[1] = {Rear_left_wing_landing_gear_Id};
-    static MGROUP_ROTATE RearLeftWingLandingGearStow(
-        0,
-        RearLeftWingLandingGearGrp,
-        1,
-        (Axis_left_wing_landing_gear_Location),
-        _V(0, 0, 1),
-        (float)(90*RAD)
-    );
-    
-    static unsigned int RearLeftWingLandingGearPartGrp [1] = {Rear_left_wing_landing_gear_part_Id};
-    static MGROUP_ROTATE RearLeftWingLandingGearPart(
-        0,
-        RearLeftWingLandingGearPartGrp,
-        1,
-        (Axis_rear_left_wing_landing_gear_part_Location),
-        _V(0, 0, 1),
-        (float)(-90*RAD)
-    );
-
-    AddAnimationComponent(anim_landing_gear, 0, 0.5, &RearLeftWingLandingGearStow);
-    AddAnimationComponent(anim_landing_gear, 0, 0.5, &RearLeftWingLandingGearPart);
-
-    static unsigned int RearRightWingLandingGearGrp[1] = {Rear_right_wing_landing_gear_Id};
-    static MGROUP_ROTATE RearRightWingLandingGearStow(
-        0,
-        RearRightWingLandingGearGrp,
-        1,
-        (Axis_right_wing_landing_gear_Location),
-        _V(0, 0, 1),
-        (float)(-90*RAD)
-    );
-
-    static unsigned int RearRightWingLandingGearPartGrp[1] = {Rear_right_wing_landing_gear_part_Id};
-    static MGROUP_ROTATE RearRightWingLandingGearPart(
-        0,
-        RearRightWingLandingGearPartGrp,
-        1,
-        (Axis_rear_right_wing_landing_gear_part_Location),
-        _V(0, 0, 1),
-        (float)(90*RAD)
-    );
-
-    AddAnimationComponent(anim_landing_gear, 0, 0.5, &RearRightWingLandingGearStow);
-    AddAnimationComponent(anim_landing_gear, 0, 0.5, &RearRightWingLandingGearPart);
-
-    static unsigned int RearLeftLandingGearGrp[1] = {Rear_left_landing_gear_Id};
-    static MGROUP_ROTATE RearLeftLandingGear(
-        0,
-        RearLeftLandingGearGrp,
-        1,
-        (Axis_left_landing_gear_Location),
-        _V(1, 0, 0),
-        (float)(-180*RAD)
-    );
-
-    static unsigned int RearRightLandingGearGrp[1] = {Rear_right_landing_gear_Id};
-    static MGROUP_ROTATE RearRightLandingGear(
-        0,
-        RearRightLandingGearGrp,
-        1,
-        (Axis_right_landing_gear_Location),
-        _V(1, 0, 0),
-        (float)(-180*RAD)
-    );
-
-    AddAnimationComponent(anim_landing_gear, 0, 0.5, &RearLeftLandingGear);
-    AddAnimationComponent(anim_landing_gear, 0, 0.5, &RearRightLandingGear);
-
-    static unsigned int RearLeftLandingGearDoor1Grp[2] = {Rear_left_landing_gear_door1_Id, Rear_left_landing_gear_door2_Id};
-    static MGROUP_ROTATE RearLeftLandingGearDoor1(
-        0,
-        RearLeftLandingGearDoor1Grp,
-        2,
-        (Axis_landing_gear_left_door_1_Location),
-        _V(0, 0, 1),
-        (float)(-90*RAD)
-    );
-
-    static unsigned int RearLeftLandingGearDoor2Grp[1] = {Rear_left_landing_gear_door2_Id};
-    static MGROUP_ROTATE RearLeftLandingGearDoor2(
-        0,
-        RearLeftLandingGearDoor2Grp,
-        1,
-        (Axis_left_landing_gear_door2_Location),
-        _V(0, 0, 1),
-        (float)(-180*RAD)
-    );
-
-    AddAnimationComponent(anim_landing_gear, 0.25, 0.5, &RearLeftLandingGearDoor1);
-    AddAnimationComponent(anim_landing_gear, 0.5, 1, &RearLeftLandingGearDoor2);
-
-    static unsigned int RearRightLandingGearDoor1Grp[2] = {Rear_right_landing_gear_door1_Id, Rear_right_landing_gear_door2_Id};
-    static MGROUP_ROTATE RearRightLandingGearDoor1(
-        0,
-        RearRightLandingGearDoor1Grp,
-        2,
-        (Axis_landing_gear_right_door_1_Location),
-        _V(0, 0, 1),
-        (float)(90*RAD)
-    );
-
-    static unsigned int RearRightLandingGearDoor2Grp[1] = {Rear_right_landing_gear_door2_Id};
-    static MGROUP_ROTATE RearRightLandingGearDoor2(
-        0,
-        RearRightLandingGearDoor2Grp,
-        1,
-        (Axis_right_landing_gear_door2_Location),
-        _V(0, 0, 1),
-        (float)(180*RAD)
-    );
-
-    AddAnimationComponent(anim_landing_gear, 0.25, 0.5, &RearRightLandingGearDoor1);
-    AddAnimationComponent(anim_landing_gear, 0.5, 1, &RearRightLandingGearDoor2);
-
-    //Engines
-
-    static unsigned int Engine1Grp[1] = {ENG1_blades_Id};
-    static MGROUP_ROTATE Engine1(
-        0,
-        Engine1Grp,
-        1,
-        (ENG1_blades_Location),
-        _V(0, 0, 1),
-        (float)(360*RAD)
-    );
-    
-    
-    static unsigned int Engine2Grp[1] = {ENG2_blades_Id};
-    static MGROUP_ROTATE Engine2(
-        0,
-        Engine2Grp,
-        1,
-        (ENG2_blades_Location),
-        _V(0, 0, 1),
-        (float)(360*RAD)
-    );
-
-    static unsigned int Engine3Grp[1] = {ENG3_blades_Id};
-    static MGROUP_ROTATE Engine3(
-        0,
-        Engine3Grp,
-        1,
-        (ENG3_blades_Location),
-        _V(0, 0, 1),
-        (float)(360*RAD)
-    );
-
-    static unsigned int Engine4Grp[1] = {ENG4_blades_Id};
-    static MGROUP_ROTATE Engine4(
-        0,
-        Engine4Grp,
-        1,
-        (ENG4_blades_Location),
-        _V(0, 0, 1),
-        (float)(360*RAD)
-    );
-    
-    anim_engines = CreateAnimation(0.0);
-
-    AddAnimationComponent(anim_engines, 0, 1, &Engine1);
-    AddAnimationComponent(anim_engines, 0, 1, &Engine2);
-    AddAnimationComponent(anim_engines, 0, 1, &Engine3);
-    AddAnimationComponent(anim_engines, 0, 1, &Engine4);
-
-    //Control surfaces
-
-    static unsigned int LeftElevatorGrp[1] = {Left_elevator_trim_Id};
-    static MGROUP_ROTATE LeftElevator(
-        0,
-        LeftElevatorGrp,
-        1,
-        (Axis_elevator_left_Location),
-        _V(1, 0, 0.5),
-        (float)(45*RAD)
-    );
-
-    static unsigned int RightElevatorGrp[1] = {Right_elevator_trim_Id};
-    static MGROUP_ROTATE RightElevator(
-        0,
-        RightElevatorGrp,
-        1,
-        (Axis_elevator_right_Location),
-        _V(1, 0, -0.5),
-        (float)(45*RAD)
-    );
-
-    anim_elevator = CreateAnimation(0.5);
-    AddAnimationComponent(anim_elevator, 0, 1, &LeftElevator);
-    AddAnimationComponent(anim_elevator, 0, 1, &RightElevator);
-
-    static unsigned int LeftElevatorTrimGrp[1] = {Left_elevator_trim_Id};
-    static MGROUP_ROTATE LeftElevatorTrim(
-        0,
-        LeftElevatorTrimGrp,
-        1,
-        (Axis_elevator_left_Location),
-        _V(1, 0, 0.5),
-        (float)(22.5*RAD)
-    );
-
-    static unsigned int RightElevatorTrimGrp[1] = {Right_elevator_trim_Id};
-    static MGROUP_ROTATE RightElevatorTrim(
-        0,
-        RightElevatorTrimGrp,
-        1,
-        (Axis_elevator_right_Location),
-        _V(1, 0, -0.5),
-        (float)(22.5*RAD)
-    );
-
-    anim_elevator_trim = CreateAnimation(0.5);
-    AddAnimationComponent(anim_elevator_trim, 0, 1, &LeftElevatorTrim);
-    AddAnimationComponent(anim_elevator_trim, 0, 1, &RightElevatorTrim);
-
-    static unsigned int RudderGrp[1] = {Rudder_Id};
-    static MGROUP_ROTATE Rudder(
-        0,
-        RudderGrp,
-        1,
-        (Axis_rudder_Location),
-        _V(0, 1, -0.75),
-        (float)(22.5*RAD)
-    );
-    anim_rudder = CreateAnimation(0.5);
-    AddAnimationComponent(anim_rudder, 0, 1, &Rudder);
-
-    static unsigned int LAileronGrp[1] = {LAileron_Id};
-    static MGROUP_ROTATE LAileron(
-        0,
-        LAileronGrp,
-        1,
-        (Axis_laileron_Location),
-        _V(-1, 0, -0.75),
-        (float)(45*RAD)
-    );
-
-    static unsigned int RAileronGrp[1] = {Raileron_Id};
-    static MGROUP_ROTATE RAileron(
-        0,
-        RAileronGrp,
-        1,
-        (Axis_raileron_Location),
-        _V(1, 0, -0.75),
-        (float)(45*RAD)
-    );
-
-    anim_laileron = CreateAnimation(0.5);
-    anim_raileron = CreateAnimation(0.5);
-
-    AddAnimationComponent(anim_laileron, 0, 1, &LAileron);
-    AddAnimationComponent(anim_raileron, 0, 1, &RAileron);
-
-
-    //Cockpit animations
-
-    static unsigned int LYokeColumnGrp[2] = {LYoke_column_Id, LYoke_Id};
-    static MGROUP_ROTATE LYokeColumn(
-        uimesh_Cockpit,
-        LYokeColumnGrp,
-        2,
-        (Axis_LYoke_column_Location),
-        _V(-1, 0, 0),
-        (float)(30*RAD)
-    );
-
-    static unsigned int RYokeColumnGrp[2] = {RYoke_column_Id, RYoke_Id};
-    static MGROUP_ROTATE RYokeColumn(
-        uimesh_Cockpit,
-        RYokeColumnGrp,
-        2,
-        (Axis_RYoke_column_Location),
-        _V(-1, 0, 0),
-        (float)(30*RAD)
-    );
-
-    AddAnimationComponent(anim_elevator, 0, 1, &LYokeColumn);
-    AddAnimationComponent(anim_elevator, 0, 1, &RYokeColumn);
-
-    static unsigned int LYokeGrp[1] = {LYoke_Id};
-    static MGROUP_ROTATE LYoke(
-        uimesh_Cockpit,
-        LYokeGrp,
-        1,
-        (LYoke_Location),
-        _V(0, 0, -1),
-        (float)(90*RAD)
-    );
-
-    static unsigned int RYokeGrp[1] = {RYoke_Id};
-    static MGROUP_ROTATE RYoke(
-        uimesh_Cockpit,
-        RYokeGrp,
-        1,
-        (RYoke_Location),
-        _V(0, 0, -1),
-        (float)(90*RAD)
-    );
-
-    AddAnimationComponent(anim_laileron, 0, 1, &LYoke);
-    AddAnimationComponent(anim_laileron, 0, 1, &RYoke);
-
-    static unsigned int GearLeverGrp[1] = {Landing_gear_lever_Id};
-    static MGROUP_ROTATE GearLever(
-        uimesh_Cockpit,
-        GearLeverGrp,
-        1,
-        (Axis_landing_gear_lever_Location),
-        _V(1, 0, 0),
-        (float)(90*RAD)
-    );
-
-    AddAnimationComponent(anim_landing_gear, 0, 0.1, &GearLever);
+
+    //Built from Config/Boeing747/Animations; see InitModule.
+    const AnimBinding bindings[] = {
+        {"landing_gear", &anim_landing_gear, ANIM_ALWAYS},
+        {"engines", &anim_engines, ANIM_EXTERNAL},
+        {"elevator", &anim_elevator},
+        {"elevator_trim", &anim_elevator_trim},
+        {"rudder", &anim_rudder},
+        {"laileron", &anim_laileron},
+        {"raileron", &anim_raileron},
+        {"gear_lever", &anim_gear_lever, ANIM_VC},
+        {"yoke_pitch", &anim_yoke_pitch, ANIM_VC},
+        {"yoke_roll", &anim_yoke_roll, ANIM_VC},
+        {"flaps", &anim_flaps, ANIM_EXTERNAL},
+        {"flaps_lever", &anim_flaps_lever, ANIM_VC},
+    };
+    animations.Create(this, bindings, sizeof(bindings)/sizeof(bindings[0]), &anim_sched);
 
 }
 
 void B747400::clbkSetClassCaps(FILEHANDLE cfg){
 
+    //Memory the module may keep in unused liveries, shared by every vessel of the class.
+    int livery_cache_mb;
+    if(oapiReadItem_int(cfg, "LiveryCacheMB", livery_cache_mb)) liveries.SetBudget((size_t)livery_cache_mb << 20);
+
+    //Gear contact sets, built by the first vessel of the class and shared by the rest. With no
+    //GearContactSteps the gear up and gear down sets swap halfway through the transition.
+    if(!touchdown_sets.Built()){
+        int gear_contact_steps = 0;
+        oapiReadItem_int(cfg, "GearContactSteps", gear_contact_steps);
+        touchdown_sets.Build(tdvtx_geardown, ntdvtx_geardown, tdvtx_gearup, ntdvtx_gearup, gear_contact_steps);
+    }
+
+    //Seconds the cockpit and cabin meshes stay after the camera leaves the cockpit.
+    double vc_release_time = VC_RELEASE_TIME;
+    oapiReadItem_float(cfg, "VCReleaseTime", vc_release_time);
+    vc.Init(this, &meshes, B747400_VC_MESHES, sizeof(B747400_VC_MESHES)/sizeof(B747400_VC_MESHES[0]), vc_release_time);
+
+    //Camera distances, in metres, from which the distance levels of the airframe mesh are drawn.
+    double lod_distance[LOD_LEVELS];
+    for(int i = 0; i < LOD_LEVELS; i++){
+        char key[16];
+        sprintf(key, "LOD%dDistance", i + 1);
+        lod_distance[i] = LOD_DISTANCE[i];
+        oapiReadItem_float(cfg, key, lod_distance[i]);
+    }
+
     //Physical vessel parameters
     SetSize(B747400_SIZE);
     SetEmptyMass(B747400_EMPTYMASS);
@@ -479,6 +173,8 @@ void B747400::clbkSetClassCaps(FILEHANDLE cfg){
     th_retro[2] = CreateThruster((ENG3_Location), _V(0, 0, -1), (B747400_MAXMAINTH/4), JET_A1, B747400_ISP);
     th_retro[3] = CreateThruster((ENG4_Location), _V(0, 0, -1), (B747400_MAXMAINTH/4), JET_A1, B747400_ISP);
 
+    engine_state.Init(this, th_main, th_retro, 4);
+
     /* //RCS setup, Wait what?. Yes RCS, its a cheat to make LVL Horizon Autopilot work. Shh...
     THRUSTER_HANDLE th_rcs[24], th_group[4];
         
@@ -562,14 +258,14 @@ void B747400::clbkSetClassCaps(FILEHANDLE cfg){
 		PARTICLESTREAMSPEC::LVL_PLIN, -1.0, 25.0,
 		PARTICLESTREAMSPEC::ATM_PLIN, 
     };
-	AddParticleStream(&engines_contrails, (ENG1_Location), _V(0, 0, -1), &lvlcontrailengines);
-    AddParticleStream(&engines_contrails, (ENG2_Location), _V(0, 0, -1), &lvlcontrailengines);
-    AddParticleStream(&engines_contrails, (ENG3_Location), _V(0, 0, -1), &lvlcontrailengines);
-    AddParticleStream(&engines_contrails, (ENG4_Location), _V(0, 0, -1), &lvlcontrailengines);
+	AddParticleStream(&engines_contrails, (ENG1_Location), _V(0, 0, -1), &state.lvlcontrailengines);
+    AddParticleStream(&engines_contrails, (ENG2_Location), _V(0, 0, -1), &state.lvlcontrailengines);
+    AddParticleStream(&engines_contrails, (ENG3_Location), _V(0, 0, -1), &state.lvlcontrailengines);
+    AddParticleStream(&engines_contrails, (ENG4_Location), _V(0, 0, -1), &state.lvlcontrailengines);
 
-	lwing = CreateAirfoil3(LIFT_VERTICAL, (Left_wing_Location), VLiftCoeff, 0, B747400_VLIFT_C, (B747400_VLIFT_S*4), B747400_VLIFT_A);
+	lwing = CreateAirfoil3(LIFT_VERTICAL, (Left_wing_Location), VLiftCoeff, &flaps, B747400_VLIFT_C, (B747400_VLIFT_S*4), B747400_VLIFT_A);
 
-    rwing = CreateAirfoil3(LIFT_VERTICAL,(Right_wing_Location), VLiftCoeff, 0, B747400_VLIFT_C,(B747400_VLIFT_S*4), B747400_VLIFT_A);
+    rwing = CreateAirfoil3(LIFT_VERTICAL,(Right_wing_Location), VLiftCoeff, &flaps, B747400_VLIFT_C,(B747400_VLIFT_S*4), B747400_VLIFT_A);
 
     lstabilizer = CreateAirfoil3(LIFT_VERTICAL, (Left_stabilizer_Location), VLiftCoeff, 0, B747400_STAB_C, B747400_STAB_S, B747400_STAB_A);
 
@@ -589,15 +285,10 @@ void B747400::clbkSetClassCaps(FILEHANDLE cfg){
     CreateControlSurface3(AIRCTRL_RUDDER, 20.6937, 1.7, (Rudder_Location), AIRCTRL_AXIS_AUTO, 1.0, anim_rudder);
 
     //Add the mesh
-    SetMeshVisibilityMode (AddMesh (b747400_mesh = oapiLoadMeshGlobal ("Boeing747\\Boeing_747_400")), MESHVIS_EXTERNAL);
+    SetMeshVisibilityMode (AddMesh (b747400_mesh = meshes.Load("Boeing747\\Boeing_747_400")), MESHVIS_EXTERNAL);
+    lods.Init(this, &meshes, "Boeing747\\Boeing_747_400", lod_distance);
     //AddMesh(b747sp_mesh);
 
-    //Add the mesh for the cockpit
-    SetMeshVisibilityMode(AddMesh(mhcockpit_mesh = oapiLoadMeshGlobal("Boeing747\\Boeing_747_cockpit")), MESHVIS_VC);
-
-    //Add the mesh for the First Class cabin
-    SetMeshVisibilityMode(AddMesh(fccabin_mesh = oapiLoadMeshGlobal("Boeing747\\Boeing_747_first_class")), MESHVIS_VC);
-
     //Define beacons
 
     static VECTOR3 beaconpos_green[2] = { {Beacon2_right_wing_Location}, {Beacon3_upper_deck_Location}};
@@ -649,14 +340,22 @@ void B747400::clbkSetClassCaps(FILEHANDLE cfg){
 		AddBeacon(beaconwhite+i);
 	}
 
+    //All off until switched on; the switches only activate them.
+    lights.Create(this, B747400_LIGHTS, sizeof(B747400_LIGHTS)/sizeof(B747400_LIGHTS[0]));
+
 }
 
 void B747400::clbkVisualCreated(VISHANDLE vis, int refcount){
 
+    B747_PROFILE_SCOPE(PROF_VISUALCREATED);
+
     visual = vis;
+    anim_sched.SetVisual(true);
 
     b747400_dmesh = GetDevMesh(vis, 0);
 
+    if(!livery && skinname[0]) livery = liveries.Acquire(B747400_SKINDIR, skinname);
+
     ApplyLivery();
 
 
@@ -665,86 +364,67 @@ void B747400::clbkVisualCreated(VISHANDLE vis, int refcount){
 void B747400::clbkVisualDestroyed(VISHANDLE vis, int refcount){
 
     visual = NULL;
+    anim_sched.SetVisual(false);
     b747400_dmesh = NULL;
 
+    //The textures stay cached until the budget needs the room.
+    liveries.Release(livery);
+    livery = NULL;
+
 }
 
 void B747400::NextSkin() {
-    if (currentSkin >= 15) {
-        currentSkin = 0;
-    }
-
+    state.current_skin = skins.Next(state.current_skin);
     ChangeLivery();
-    currentSkin++;
 }
 
 void B747400::ChangeLivery() {
-    
-    char completedir_fus[256];
-    char completedir_vs[256];
-    char completedir_rw[256];
-    char completedir_eng[256];
-    char completedir_lw[256];
-    const char SKINLIST[][15] = {"SKIN1", "SKIN2", "SKIN3", "SKIN4", "SKIN5", "SKIN6", "SKIN7", "SKIN8", "SKIN9", "SKIN10", "SKIN11", "SKIN12", "SKIN13", "SKIN14", "SKIN15"};
-    
-    skinlist = oapiOpenFile(fname, FILE_IN, ROOT);
-    oapiReadItem_string(skinlist, SKINLIST[currentSkin], skinname);
-    
 
-    strcpy(completedir_fus, skindir);
-    strcat(completedir_fus, skinname);
-    strcat(completedir_fus, texname_fus);
+    B747_PROFILE_SCOPE(PROF_CHANGELIVERY);
 
-    strcpy(completedir_vs, skindir);
-    strcat(completedir_vs, skinname);
-    strcat(completedir_vs, texname_vs);
-
-    strcpy(completedir_rw, skindir);
-    strcat(completedir_rw, skinname);
-    strcat(completedir_rw, texname_rw);
-
-    strcpy(completedir_eng, skindir);
-    strcat(completedir_eng, skinname);
-    strcat(completedir_eng, texname_eng);
-
-    strcpy(completedir_lw, skindir);
-    strcat(completedir_lw, skinname);
-    strcat(completedir_lw, texname_lw);
-
-    skin[0] = oapiLoadTexture(completedir_fus);
-    skin[1] = oapiLoadTexture(completedir_vs);
-    skin[2] = oapiLoadTexture(completedir_rw);
-    skin[3] = oapiLoadTexture(completedir_lw);
-    skin[4] = oapiLoadTexture(completedir_eng);
+    if(state.current_skin < 0) return;
+    strcpy(skinname, skins.Name(state.current_skin));
 
+    //Take the new livery before dropping the old one, so reselecting the current skin does not reload it.
+    LiveryCache::Livery *previous = livery;
+    livery = liveries.Acquire(B747400_SKINDIR, skinname);
+    liveries.Release(previous);
 
     ApplyLivery();
+
+    prefetch.RequestNeighbours(skins, B747400_SKINDIR, state.current_skin);
 }
 
 void B747400::ApplyLivery(){
 
-    if(!b747400_dmesh) return;
+    if(!b747400_dmesh || !livery) return;
 
-    if(skin[0]) oapiSetTexture(b747400_dmesh, 1, skin[0]);
+    //The distance levels use the airframe mesh's texture indices.
+    for(int l = 0; l <= lods.Levels(); l++){
+        DEVMESHHANDLE dmesh = l ? GetDevMesh(visual, LODMeshes::Mesh(l)) : b747400_dmesh;
+        if(!dmesh) continue;
 
-    if(skin[1]) oapiSetTexture(b747400_dmesh, 2, skin[1]);
+        if(livery->tex[0]) oapiSetTexture(dmesh, 1, livery->tex[0]);
 
-    if(skin[2]) oapiSetTexture(b747400_dmesh, 3, skin[2]);
+        if(livery->tex[1]) oapiSetTexture(dmesh, 2, livery->tex[1]);
 
-    if(skin[3]) oapiSetTexture(b747400_dmesh, 8, skin[3]);
+        if(livery->tex[2]) oapiSetTexture(dmesh, 3, livery->tex[2]);
 
-    if(skin[4]) oapiSetTexture(b747400_dmesh, 10, skin[4]);
+        if(livery->tex[3]) oapiSetTexture(dmesh, 8, livery->tex[3]);
+
+        if(livery->tex[4]) oapiSetTexture(dmesh, 10, livery->tex[4]);
+    }
 
 }
 
 void B747400::ParkingBrake(){
 
-    if(!parkingBrakeEnabled){
+    if(!state.parking_brake){
         SetWheelbrakeLevel(1, 0, true);
-        parkingBrakeEnabled = true;
+        state.parking_brake = true;
     } else {
         SetWheelbrakeLevel(0, 0, true);
-        parkingBrakeEnabled = false;
+        state.parking_brake = false;
     }
 
 }
@@ -780,103 +460,39 @@ void B747400::ActivateBeacons(){
 
 void B747400::LightsControl(void){
 
-    if(!lights_on){
-        l1 = AddSpotLight((LIGHT1_Location), _V(0, 0, 1), 100000, 1e-3, 0, 2e-3, 25*RAD, 45*RAD, col_d, col_s, col_a);
-        l2 = AddSpotLight((LIGHT2_Location), _V(0, 0, 1), 100000, 1e-3, 0, 2e-3, 25*RAD, 45*RAD, col_d, col_s, col_a);
-        l3 = AddSpotLight((LIGHT3_Location), _V(0, 0, 1), 100000, 1e-3, 0, 2e-3, 25*RAD, 45*RAD, col_d, col_s, col_a);
-        l4 = AddSpotLight((LIGHT4_Location), _V(0, 0, 1), 100000, 1e-3, 0, 2e-3, 25*RAD, 45*RAD, col_d, col_s, col_a);
-
-        cpl1 = AddPointLight((PL1_Location), 1, 0.15, 0, 0.15, ccol_d, ccol_s, ccol_a);
-        cpl1->SetVisibility(LightEmitter::VIS_COCKPIT);
-        cpl2 = AddPointLight((PL2_Location), 1, 0.15, 0, 0.15, ccol_d, ccol_s, ccol_a);
-        cpl2->SetVisibility(LightEmitter::VIS_COCKPIT);
-
-        fcl1 = AddPointLight((FC_PL1_Location), 1, 0.5, 0, 0.5, fccol_d, fccol_s, fccol_a);
-        fcl1->SetVisibility(LightEmitter::VIS_COCKPIT);
-        fcl2 = AddPointLight((FC_PL2_Location), 1, 0.5, 0, 0.5, fccol_d, fccol_s, fccol_a);
-        fcl2->SetVisibility(LightEmitter::VIS_COCKPIT);
-        fcl3 = AddPointLight((FC_PL3_Location), 1, 0.5, 0, 0.5, fccol_d, fccol_s, fccol_a);
-        fcl3->SetVisibility(LightEmitter::VIS_COCKPIT);
-        fcl4 = AddPointLight((FC_PL4_Location), 1, 0.5, 0, 0.5, fccol_d, fccol_s, fccol_a);
-        fcl4->SetVisibility(LightEmitter::VIS_COCKPIT);
-        fcl5 = AddPointLight((FC_PL5_Location), 1, 0.5, 0, 0.5, fccol_d, fccol_s, fccol_a);
-        fcl5->SetVisibility(LightEmitter::VIS_COCKPIT);
-        fcl6 = AddPointLight((FC_PL6_Location), 1, 0.5, 0, 0.5, fccol_d, fccol_s, fccol_a);
-        fcl6->SetVisibility(LightEmitter::VIS_COCKPIT);
-        fcl7 = AddPointLight((FC_PL7_Location), 1, 0.5, 0, 0.5, fccol_d, fccol_s, fccol_a);
-        fcl7->SetVisibility(LightEmitter::VIS_COCKPIT);
-        fcl8 = AddPointLight((FC_PL8_Location), 1, 0.5, 0, 0.5, fccol_d, fccol_s, fccol_a);
-        fcl8->SetVisibility(LightEmitter::VIS_COCKPIT);
-        fcl9 = AddPointLight((FC_PL9_Location), 1, 0.5, 0, 0.5, fccol_d, fccol_s, fccol_a);
-        fcl9->SetVisibility(LightEmitter::VIS_COCKPIT);
-        fcl10 = AddPointLight((FC_PL10_Location), 1, 0.5, 0, 0.5, fccol_d, fccol_s, fccol_a);
-        fcl10->SetVisibility(LightEmitter::VIS_COCKPIT);
-        fcl11 = AddPointLight((FC_PL11_Location), 1, 0.5, 0, 0.5, fccol_d, fccol_s, fccol_a);
-        fcl11->SetVisibility(LightEmitter::VIS_COCKPIT);
-        fcl12 = AddPointLight((FC_PL12_Location), 1, 0.5, 0, 0.5, fccol_d, fccol_s, fccol_a);
-        fcl12->SetVisibility(LightEmitter::VIS_COCKPIT);
-
-        lights_on = true;
-    } else {
-        DelLightEmitter(l1);
-        DelLightEmitter(l2);
-        DelLightEmitter(l3);
-        DelLightEmitter(l4);
-
-        DelLightEmitter(cpl1);
-        DelLightEmitter(cpl2);
-
-        DelLightEmitter(fcl1);
-        DelLightEmitter(fcl2);
-        DelLightEmitter(fcl3);
-        DelLightEmitter(fcl4);
-        DelLightEmitter(fcl5);
-        DelLightEmitter(fcl6);
-        DelLightEmitter(fcl7);
-        DelLightEmitter(fcl8);
-        DelLightEmitter(fcl9);
-        DelLightEmitter(fcl10);
-        DelLightEmitter(fcl11);
-        DelLightEmitter(fcl12);
-
-        lights_on = false;
-    }
+    lights.SetAll(!lights.AnyOn());
+
 }
 
 void B747400::EnginesAutostart(void){
 
-    engines_on = true;
-    enginevalue = 1;
-    m_pXRSound->PlayWav(engines_start);
+    if(engine_state.Start()){
+        m_pXRSound->PlayWav(engines_start);
+    }
     
 }
 
 void B747400::EnginesAutostop(void){
 
-    engines_on = false;
-    enginevalue = 0;
-    m_pXRSound->PlayWav(engines_shutdown);
+    if(engine_state.Stop()){
+        m_pXRSound->PlayWav(engines_shutdown);
+    }
     
 }
 
-void B747400::UpdateEnginesStatus(){
-
-    if(engines_on == true){
-        thg_main = CreateThrusterGroup(th_main, 4, THGROUP_MAIN);
-
-        thg_retro = CreateThrusterGroup(th_retro, 4, THGROUP_RETRO);
+void B747400::UpdateEnginesStatus(double simdt, const FlightState &flight){
 
-        pwr = GetThrusterLevel(thg_main);
+    engine_state.Update(simdt, flight);
 
-    } else if (engines_on == false){
-        DelThrusterGroup(thg_main);
-        DelThrusterGroup(thg_retro);
-        pwr = 0;
-    }
+    state.pwr = engine_state.GetPower();
 }
 
 bool B747400::clbkLoadVC(int id){
 
+    B747_PROFILE_SCOPE(PROF_LOADVC);
+
+    vc.Load(lights);
+
     static VCMFDSPEC mfds_1 = {1, MFD1_Id};
     oapiVCRegisterMFD(MFD_LEFT, &mfds_1);
 
@@ -956,10 +572,16 @@ bool B747400::clbkLoadVC(int id){
 
 int B747400::clbkConsumeBufferedKey(int key, bool down, char *kstate){
 
+    B747_PROFILE_SCOPE(PROF_CONSUMEKEY);
+
     if(key == OAPI_KEY_G && down){
         SetGearDown();
         return 1;
     }
+    if((key == OAPI_KEY_COMMA || key == OAPI_KEY_PERIOD) && down){
+        OperateFlaps(key == OAPI_KEY_PERIOD ? 1 : -1);
+        return 1;
+    }
     if(key == OAPI_KEY_NUMPADENTER && down){
         ParkingBrake();
         return 1;
@@ -969,7 +591,10 @@ int B747400::clbkConsumeBufferedKey(int key, bool down, char *kstate){
         return 1;
     }
     if(key == OAPI_KEY_F && down){
-        LightsControl();
+        if(KEYMOD_SHIFT(kstate)) lights.Toggle(LIGHTS_LANDING);
+        else if(KEYMOD_CONTROL(kstate)) lights.Toggle(LIGHTS_COCKPIT);
+        else if(KEYMOD_ALT(kstate)) lights.Toggle(LIGHTS_CABIN);
+        else LightsControl();
         return 1;
     }
     if(key == OAPI_KEY_V && down){
@@ -999,37 +624,34 @@ void B747400::clbkLoadStateEx(FILEHANDLE scn, void *vs){
 
     while(oapiReadScenario_nextline(scn, line)){
         if(!strncasecmp(line, "GEAR", 4)){
-            sscanf(line+4, "%d%lf", (int *)&landing_gear_status, &landing_gear_proc);
-            SetAnimation(anim_landing_gear, landing_gear_proc);
-            if (landing_gear_proc == 1.0){
-                bGearIsDown = true;
-            } else {
-                bGearIsDown = false;
-            }
+            int status = 0;
+            double proc = 0.0;
+            sscanf(line+4, "%d%lf", &status, &proc);
+            parts.Set(*this, PART_GEAR, status, proc);
+        } else if(!strncasecmp(line, "FLAPS", 5)){
+            int detent = 0;
+            double angle = 0.0;
+            sscanf(line+5, "%d%lf", &detent, &angle);
+            flaps.Set(detent, angle);
+            anim_sched.Set(anim_flaps, flaps.FlapState());
+            anim_sched.Set(anim_flaps_lever, flaps.LeverState());
         } else if(!strncasecmp(line, "SKIN", 4)){
-            sscanf(line+4, "%s", skinpath);
-            char fname[256];
-            strcpy(fname, "Boeing_747\\B747_400\\Skins\\");
-            strcat(fname, skinpath);
-            int n = strlen(fname); fname[n++] = '\\';
-
-            strcpy(fname+n, "Fuselage.dds"); skin[0] = oapiLoadTexture(fname);
-
-            strcpy(fname+n, "Vertical_stabilizer.dds"); skin[1] = oapiLoadTexture(fname);
-
-            strcpy(fname+n, "Right_wing.dds"); skin[2] = oapiLoadTexture(fname);
-
-            strcpy(fname+n, "Left_wing.dds"); skin[3] = oapiLoadTexture(fname);
-
-            strcpy(fname+n, "ENG1.dds"); skin[4] = oapiLoadTexture(fname);
+            if(sscanf(line+4, "%s", skinname) == 1){
+                //Loaded with the visual. Until then the worker reads the files.
+                liveries.Release(livery);
+                livery = NULL;
+                state.current_skin = skins.Find(skinname);
+                prefetch.Request(B747400_SKINDIR, skinname);
+            }
 
+        } else if (!strncasecmp(line, "LIGHTS", 6)){
+            int lightsvalue = 0;
+            sscanf(line+6, "%d", &lightsvalue);
+            lights.SetMask(lightsvalue);
         } else if (!strncasecmp(line, "ENGINES", 7)){
+            int enginevalue = 0;
             sscanf(line+7, "%d", &enginevalue);
-            if(enginevalue == 1){
-                engines_on = true;
-            } else {
-                engines_on = false;
-            }
+            engine_state.SetRunning(enginevalue == 1);
         } else {
             ParseScenarioLineEx(line, vs);
         }
@@ -1041,59 +663,55 @@ void B747400::clbkSaveState(FILEHANDLE scn){
     char cbuf[256];
 
     SaveDefaultState(scn);
-    sprintf(cbuf, "%d %0.4f", landing_gear_status, landing_gear_proc);
+    sprintf(cbuf, "%d %0.4f", parts.Status(PART_GEAR), parts.Proc(PART_GEAR));
     oapiWriteScenario_string(scn, "GEAR", cbuf);
+
+    if(flaps.Lever() || flaps.Angle() > 0.0){
+        sprintf(cbuf, "%d %0.4f", flaps.Lever(), flaps.Angle());
+        oapiWriteScenario_string(scn, "FLAPS", cbuf);
+    }
     
-    oapiWriteScenario_string (scn, "SKIN", skinname);
+    if(skinname[0]) oapiWriteScenario_string (scn, "SKIN", skinname);
+
+    oapiWriteScenario_int(scn, "ENGINES", engine_state.GetScenarioValue());
 
-    oapiWriteScenario_int(scn, "ENGINES", enginevalue);
+    oapiWriteScenario_int(scn, "LIGHTS", lights.GetMask());
 
 }
 
 //////////Logic for animations
 void B747400::SetGearDown(void){
-    ActivateLandingGear((landing_gear_status == GEAR_DOWN || landing_gear_status == GEAR_DEPLOYING) ?
-        GEAR_STOWING : GEAR_DEPLOYING);
+    parts.Toggle(PART_GEAR, m_pXRSound);
 }
 
-void B747400::ActivateLandingGear(LandingGearStatus action){
-    m_pXRSound->PlayWav(gear_movement);
-    landing_gear_status = action;
+void B747400::OperateFlaps(int dir){
+    if(flaps.Step(dir)) anim_sched.Set(anim_flaps_lever, flaps.LeverState());
 }
 
-void B747400::UpdateLandingGearAnimation(double simdt) {
-    if (landing_gear_status >= GEAR_DEPLOYING) {
-        double da = simdt * LANDING_GEAR_OPERATING_SPEED;
-        if (landing_gear_status == GEAR_DEPLOYING) {
-            if (landing_gear_proc > 0.0) landing_gear_proc = std::max(0.0, landing_gear_proc - da);
-            else landing_gear_status = GEAR_DOWN;
-            SetTouchdownPoints(tdvtx_geardown, ntdvtx_geardown);
-            bGearIsDown = true;
-        } else {
-            if (landing_gear_proc < 1.0) landing_gear_proc = std::min(1.0, landing_gear_proc + da);
-            else landing_gear_status = GEAR_UP;
-            SetTouchdownPoints(tdvtx_gearup, ntdvtx_gearup);
-            bGearIsDown = false;
-        }
-        SetAnimation(anim_landing_gear, landing_gear_proc);
-    }
+void B747400::GearTraits::Moved(B747400 &v, double proc){
+    v.anim_sched.Set(v.anim_landing_gear, proc);
+    v.anim_sched.Set(v.anim_gear_lever, proc);
+    v.gear_contact.Update(&v, touchdown_sets, proc);
+}
+
+void B747400::GearTraits::Detent(B747400 &v, DeployStatus at){
+    v.state.gear_down = at == DEPLOY_AT_0;
+    v.SetNosewheelSteering(touchdown_sets.Wheels(v.gear_contact.Current()));
+}
+
+void B747400::PartsSystem::Run(B747400 &v, double dt, const FlightState &flight){
+    v.parts.Update(v, dt);
+    if(v.flaps.Update(dt)) v.anim_sched.Set(v.anim_flaps, v.flaps.FlapState());
 }
 
 void B747400::UpdateGearStatus(void){
-    if(!bGearIsDown){
-        SetTouchdownPoints(tdvtx_geardown, ntdvtx_geardown);
-        SetNosewheelSteering(true);
-    } else if (bGearIsDown){
-        SetTouchdownPoints(tdvtx_gearup, ntdvtx_gearup);
-        SetNosewheelSteering(false);
-    }
+    gear_contact.Update(this, touchdown_sets, parts.Proc(PART_GEAR));
+    SetNosewheelSteering(touchdown_sets.Wheels(gear_contact.Current()));
 }
 
-double B747400::UpdateLvlEnginesContrail(){
-    double machnumber = GetMachNumber();
-    double altitude = GetAltitude();
+double B747400::UpdateLvlEnginesContrail(const FlightState &flight){
 
-    if((machnumber > 0.5) && ((altitude > 10000) && (altitude < 15000))){
+    if((flight.mach > 0.5) && ((flight.altitude > 10000) && (flight.altitude < 15000))){
         return 1.0;
     } else {
         return 0.0;
@@ -1104,13 +722,15 @@ double B747400::UpdateLvlEnginesContrail(){
 
 
 void B747400::clbkPostStep(double simt, double simdt, double mjd){
-    UpdateLandingGearAnimation(simdt);
-    lvlcontrailengines = UpdateLvlEnginesContrail();
-    UpdateEnginesStatus();
+    B747_PROFILE_SCOPE(PROF_POSTSTEP);
+
+    systems.Update(*this, simdt, flight);
 }
 
 void B747400::clbkPostCreation(){
 
+    prefetch.RequestNeighbours(skins, B747400_SKINDIR, state.current_skin);
+
     UpdateGearStatus();
 
     m_pXRSound = XRSound::CreateInstance(this);
@@ -1135,18 +755,23 @@ void B747400::clbkPostCreation(){
 
 void B747400::clbkPreStep(double simt, double simdt, double mjd){
 
-    double grndspd = GetGroundspeed();
-    
-    double prp = GetAnimation(anim_engines);
+    B747_PROFILE_SCOPE(PROF_PRESTEP);
+
+    //The one read of the flight values this step, of the fields the systems running this step read.
+    flight.Sample(this, systems.Fields(*this, simdt));
+
+    anim_sched.Update();
+
     double msimdt = simdt * ENGINE_ROTATION_SPEED;
-    double da = msimdt * 0.1 + (pwr * 0.1);
+    double da = (msimdt * 0.1 + (state.pwr * 0.1)) * engine_state.GetSpool();
 
-    engines_proc = prp + da;
+    state.engines_proc = fmod(state.engines_proc + da, 1.0);
+    anim_sched.Set(anim_engines, state.engines_proc);
 
-    if(prp < 1){
-        SetAnimation(anim_engines, engines_proc);
-    } else {
-        SetAnimation(anim_engines, 0.0);
+    //Orbiter animates the control surfaces; the yokes follow them with the same mapping.
+    if(anim_sched.InVC()){
+        anim_sched.Set(anim_yoke_pitch, (GetControlSurfaceLevel(AIRCTRL_ELEVATOR) + 1.0)*0.5);
+        anim_sched.Set(anim_yoke_roll, (GetControlSurfaceLevel(AIRCTRL_AILERON) + 1.0)*0.5);
     }
 }
 
@@ -1154,11 +779,31 @@ void B747400::clbkPreStep(double simt, double simdt, double mjd){
 
 DLLCLBK void InitModule(MODULEHANDLE hModule){
 
+    aero.Load("B747400", B747400_VLIFT_A, B747400_HLIFT_A);
+
+    flap_polars.Build();
+
+    animations.AnimateCopies(0, LOD_MESH_INDEX, LOD_LEVELS);
+    animations.Load("B747400");
+
+    skins.Scan(B747400_SKINDIR);
 
 }
 
 DLLCLBK void ExitModule(MODULEHANDLE *hModule){
 
+    B747_PROFILE_DUMP("B747400");
+
+    prefetch.Stop();
+
+    aero.Release();
+
+    animations.Clear();
+
+    meshes.Clear();
+
+    liveries.Clear();
+
 }
 
 
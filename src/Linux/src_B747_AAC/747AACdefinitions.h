@@ -51,6 +51,8 @@
     const UINT Fuselage_Id = 41;
     const UINT APU_engine_exhaust_Id = 42;
     const UINT Fuselage_interior_Id = 43;
+    const UINT Flaps_right_Id = 44;
+    const UINT Flaps2_right_Id = 45;
     constexpr VECTOR3 Vertical_stabilizer_Location =     {0.0262, 11.8905, -31.6377};
     constexpr VECTOR3 Right_stabilizer_Location =     {5.0978, 6.9979, -34.0662};
     constexpr VECTOR3 Right_wing_Location =     {8.9758, 4.0812, -1.1481};
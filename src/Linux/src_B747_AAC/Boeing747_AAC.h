@@ -11,6 +11,20 @@
 #include "747AACdefinitions.h"
 #include "747cockpitdefinitions.h"
 #include "XRSound.h"
+#include "B747Profiler.h"
+#include "B747Engines.h"
+#include "B747Aero.h"
+#include "B747State.h"
+#include "B747Flight.h"
+#include "B747Systems.h"
+#include "B747Mesh.h"
+#include "B747VC.h"
+#include "B747LOD.h"
+#include "B747Lights.h"
+#include "B747Gear.h"
+#include "B747Anim.h"
+#include "B747Deploy.h"
+#include "B747Flaps.h"
 
 //Vessel parameters
 const double B747AAC_SIZE = 25; //Mean radius in meters.
@@ -24,7 +38,7 @@ const double B747AAC_ISP = 100000; //Fuel-specific impulse in m/s.
 
 const double B747AAC_MAXMAINTH = 400e3;  //Max main thrust in kN.
 
-const double LANDING_GEAR_OPERATING_SPEED = 0.06;
+constexpr double LANDING_GEAR_OPERATING_SPEED = 0.06;
 
 const double ENGINE_ROTATION_SPEED = 25;
 
@@ -97,23 +111,66 @@ class B747AAC : public VESSEL4{
 
         enum MySounds {engines_start, engines_shutdown, engines, cabin_ambiance, rotate, gear_movement, doors_movement};
         
-        enum LandingGearStatus{GEAR_DOWN, GEAR_UP, GEAR_DEPLOYING, GEAR_STOWING} landing_gear_status;
-
-        enum DoorsStatus{DOORS_CLOSED, DOORS_OPEN, DOORS_CLOSING, DOORS_OPENING} doors_status;
+        //Parts moved by `parts`, and how each kind moves; see B747Deploy.h.
+        enum Part{PART_GEAR, PART_DOORS, PART_COUNT};
+
+        struct GearTraits {
+            static constexpr double SPEED = LANDING_GEAR_OPERATING_SPEED;
+            static constexpr int SOUND = gear_movement;
+            static void Moved(B747AAC &v, double proc);
+            static void Detent(B747AAC &v, DeployStatus at);
+        };
+
+        struct DoorsTraits {
+            static constexpr double SPEED = LANDING_GEAR_OPERATING_SPEED;
+            static constexpr int SOUND = doors_movement;
+            static void Moved(B747AAC &v, double proc);
+            static void Detent(B747AAC &v, DeployStatus at);
+        };
+
+        //Systems run by `systems`, and how often; see B747Systems.h.
+        enum System{SYSTEM_PARTS, SYSTEM_ENGINES, SYSTEM_CONTRAILS, SYSTEM_VC, SYSTEM_LOD, SYSTEM_COUNT};
+
+        struct PartsSystem {
+            static constexpr double RATE = SYSTEM_EVERY_FRAME;
+            static unsigned int Fields(const B747AAC &v){ return 0; }
+            static void Run(B747AAC &v, double dt, const FlightState &flight);
+        };
+
+        struct EnginesSystem {
+            static constexpr double RATE = 50.0;
+            static unsigned int Fields(const B747AAC &v){ return v.engine_state.FlightFields(); }
+            static void Run(B747AAC &v, double dt, const FlightState &flight){ v.UpdateEnginesStatus(dt, flight); }
+        };
+
+        struct ContrailSystem {
+            static constexpr double RATE = 1.0;
+            static unsigned int Fields(const B747AAC &v){ return FLIGHT_MACH | FLIGHT_ALTITUDE; }
+            static void Run(B747AAC &v, double dt, const FlightState &flight){ v.state.lvlcontrailengines = v.UpdateLvlEnginesContrail(flight); }
+        };
+
+        struct VCSystem {
+            static constexpr double RATE = 1.0;
+            static unsigned int Fields(const B747AAC &v){ return 0; }
+            static void Run(B747AAC &v, double dt, const FlightState &flight){ v.vc.Update(v.anim_sched.InVC(), dt, v.lights); }
+        };
+
+        struct LODSystem {
+            static constexpr double RATE = 4.0;
+            static unsigned int Fields(const B747AAC &v){ return 0; }
+            static void Run(B747AAC &v, double dt, const FlightState &flight){ v.lods.Update(); }
+        };
 
         B747AAC(OBJHANDLE hVessel, int flightmodel);
         virtual ~B747AAC();
 
         void DefineAnimations(void);
-        void ActivateLandingGear(LandingGearStatus action);
         void SetGearDown(void);
-        void UpdateLandingGearAnimation(double);
+        void OperateFlaps(int dir);
         void UpdateGearStatus(void);
-        void ActivateDoors(DoorsStatus action);
         void CloseDoors(void);
-        void UpdateDoorsAnimations(double);
 
-        double UpdateLvlEnginesContrail();
+        double UpdateLvlEnginesContrail(const FlightState &flight);
 
         void ParkingBrake();
 
@@ -123,7 +180,7 @@ class B747AAC : public VESSEL4{
 
         void EnginesAutostart(void);
         void EnginesAutostop(void);
-        void UpdateEnginesStatus(void);
+        void UpdateEnginesStatus(double, const FlightState &);
 
         void clbkSetClassCaps(FILEHANDLE cfg) override;
         void clbkLoadStateEx(FILEHANDLE scn, void *vs) override;
@@ -135,6 +192,9 @@ class B747AAC : public VESSEL4{
 
         bool clbkLoadVC(int) override;
 
+        void clbkVisualCreated(VISHANDLE vis, int refcount) override;
+        void clbkVisualDestroyed (VISHANDLE vis, int refcount) override;
+
 
 
         MESHHANDLE B747AAC_mesh, mhcockpit_mesh, fccabin_mesh;  //Mesh handle
@@ -151,33 +211,28 @@ class B747AAC : public VESSEL4{
         unsigned int anim_elevator_trim;
         unsigned int anim_rudder;
         unsigned int anim_engines;
+        unsigned int anim_gear_lever, anim_yoke_pitch, anim_yoke_roll;
+        unsigned int anim_flaps, anim_flaps_lever;
         unsigned int anim_doors;
 
-        double lvlcontrailengines;
-        double landing_gear_proc;
-        double doors_proc;
-        double engines_proc;
-        double pwr;
+        B747State state;
+        FlightState flight;           //Sampled at the start of clbkPreStep
+        Systems<B747AAC, SYSTEM_COUNT> systems;  //Run from clbkPostStep, each at its own rate
 
         AIRFOILHANDLE lwing, rwing, lstabilizer, rstabilizer;
         CTRLSURFHANDLE hlaileron, hraileron;
         THRUSTER_HANDLE th_main[4], th_retro[4];
-        THGROUP_HANDLE thg_main, thg_retro;
+        EngineStateMachine engine_state;
         BEACONLIGHTSPEC beacongreen[2], beaconred[2], beaconwhite[1];
         DOCKHANDLE dfront, drear;
 
-        LightEmitter *l1, *l2, *l3, *l4, *cpl1, *cpl2;
-        
-
-        COLOUR4 col_d = {0.9,0.8,1,0};
-	    COLOUR4 col_s = {1.9,0.8,1,0};
-	    COLOUR4 col_a = {0,0,0,0};
-        COLOUR4 ccol_d = {1, 0.508, 0.100};
-        COLOUR4 ccol_s = {1, 0.508, 0.100};
-        COLOUR4 ccol_a = {1, 0.508, 0.100};
-        COLOUR4 fccol_d = {1, 1, 1};
-        COLOUR4 fccol_s = {1, 1, 1};
-        COLOUR4 fccol_a = {1, 1, 1};
+        LightGroups lights;
+        VCResources vc;               //Cockpit and cabin meshes, loaded on the first clbkLoadVC
+        LODMeshes lods;               //Distance levels of the airframe mesh
+        GearContact gear_contact;     //Touchdown set in place, from the module's TouchdownSets
+        AnimScheduler anim_sched;     //Sends the animation states the vessel code drives
+        Deployables<B747AAC, PART_COUNT> parts;  //Gear and the other moving parts, advanced in clbkPostStep
+        FlapSystem flaps;             //Lever detent and flap angle
 };
 
 #endif //!__BOEING747AAC_H
\ No newline at end of file
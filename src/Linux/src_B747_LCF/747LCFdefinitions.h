@@ -46,6 +46,8 @@
     const UINT APU_engine_exhaust_Id = 36;
     const UINT Right_wing_Id = 37;
     const UINT Left_wing_Id = 38;
+    const UINT Flaps_right_Id = 39;
+    const UINT Flaps2_right_Id = 40;
     constexpr VECTOR3 Right_wing_Location =     {8.9758, 4.0812, -1.1481};
     constexpr VECTOR3 Left_wing_Location =     {-9.0107, 4.0791, -1.1772};
     constexpr VECTOR3 Fuselage_Location =     {0.0000, 0.0000, 0.0000};
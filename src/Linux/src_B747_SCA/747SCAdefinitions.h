@@ -50,6 +50,8 @@
     const UINT ENG3_Id = 40;
     const UINT ENG3_blades_Id = 41;
     const UINT APU_engine_exhaust_Id = 42;
+    const UINT Flaps_right_Id = 43;
+    const UINT Flaps2_right_Id = 44;
     constexpr VECTOR3 Fuselage_Location =     {0.0000, 0.0000, 0.0000};
     constexpr VECTOR3 Vertical_stabilizer_Location =     {0.0262, 11.8905, -30.1377};
     constexpr VECTOR3 Right_stabilizer_Location =     {5.0978, 7.9979, -33.4662};
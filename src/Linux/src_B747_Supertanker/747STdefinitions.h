@@ -46,6 +46,8 @@
     const UINT ENG3_blades_Id = 36;
     const UINT ENG4_blades_Id = 37;
     const UINT APU_engine_exhaust_Id = 38;
+    const UINT Flaps_right_Id = 39;
+    const UINT Flaps2_right_Id = 40;
     constexpr VECTOR3 Fuselage_Location =     {0.0000, 0.0000, 0.0000};
     constexpr VECTOR3 Vertical_stabilizer_Location =     {0.0262, 11.8905, -31.6377};
     constexpr VECTOR3 Right_stabilizer_Location =     {5.0978, 6.9979, -34.0662};
@@ -0,0 +1,375 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          BOEING 747 COMMON CODE
+//
+//B747Aero.h
+//Airfoil coefficients shared by the 747 variants.
+//
+//B747VLiftCurve/B747HLiftCurve are the original breakpoint curves.
+//Vessels never evaluate them directly: they read an AeroTable, a
+//uniform aoa x Mach x Re grid read with index arithmetic and lerps,
+//without searches or calls into Orbiter.
+//
+//At InitModule each module maps Config/Boeing747/Aero/B747.aero
+//(written by b747_aerogen) read-only and points its tables into the
+//mapping, so every vessel of the class reads the same pages and the
+//kernel shares them with any other process mapping the file. The 747
+//variants fly the same curves with the same aspect ratios, so they all
+//map the one file, and a fleet of mixed variants holds one copy. A missing
+//file, or one failing the version or checksum test, is logged and the
+//built-in curves are sampled instead.
+//
+//Default grid: aoa every 1 deg over [-180, 180], Mach every 0.025 over
+//[0, 2], one Re layer. Every cl/cm breakpoint and every wave drag
+//corner (M 0.75, 1.0, 1.1) falls on a node, so the table reproduces the
+//curves within AERO_TABLE_TOL_CL/CM/CD. Inputs outside the grid are
+//clamped to its edges.
+//
+//==========================================
+
+#pragma once
+
+#ifndef __B747AERO_H
+#define __B747AERO_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Orbitersdk.h"
+
+const double AERO_TABLE_TOL_CL = 1e-6;
+const double AERO_TABLE_TOL_CM = 1e-6;
+const double AERO_TABLE_TOL_CD = 5e-4;
+
+typedef void (*AeroCurveFunc)(double aoa, double M, double A, double *cl, double *cm, double *cd);
+
+// 1. vertical lift component
+
+inline void B747VLiftCurve(double aoa, double M, double A, double *cl, double *cm, double *cd)
+{
+	const int nabsc = 9;
+	static const double AOA[nabsc] = {-180*RAD,-60*RAD,-30*RAD, -15*RAD, 0*RAD,15*RAD,30*RAD,60*RAD,180*RAD};
+	static const double CL[nabsc]  = {   0,    -0.56,   -0.56,   -0.16,  0.15,  0.46,  0.56,  0.56,  0.00};
+	static const double CM[nabsc]  = {    0,    0.00,   0.00,     0.00,  0.00,  0.00,  0.00,  0.00,  0.00};
+
+
+	int i;
+	for (i = 0; i < nabsc-1 && AOA[i+1] < aoa; i++);
+	if (i < nabsc - 1) {
+		double f = (aoa - AOA[i]) / (AOA[i + 1] - AOA[i]);
+		*cl = CL[i] + (CL[i + 1] - CL[i]) * f;  // aoa-dependent lift coefficient
+		*cm = CM[i] + (CM[i + 1] - CM[i]) * f;  // aoa-dependent moment coefficient
+	}
+	else {
+		*cl = CL[nabsc - 1];
+		*cm = CM[nabsc - 1];
+	}
+	double saoa = sin(aoa);
+	double pd = 0.015 + 0.4*saoa*saoa;  // profile drag
+	*cd = pd + oapiGetInducedDrag (*cl, A, 0.7) + oapiGetWaveDrag (M, 0.75, 1.0, 1.1, 0.04);
+	// profile drag + (lift-)induced drag + transonic/supersonic wave (compressibility) drag
+}
+
+// 2. horizontal lift component (vertical stabilisers and body)
+
+inline void B747HLiftCurve(double beta, double M, double A, double *cl, double *cm, double *cd)
+{
+	int i;
+	const int nabsc = 8;
+	static const double BETA[nabsc] = {-180*RAD,-135*RAD,-90*RAD,-45*RAD,45*RAD,90*RAD,135*RAD,180*RAD};
+	static const double CL[nabsc]   = {       0,    +0.3,      0,   -0.3,  +0.3,     0,   -0.3,      0};
+	for (i = 0; i < nabsc-1 && BETA[i+1] < beta; i++);
+	if (i < nabsc - 1) {
+		*cl = CL[i] + (CL[i + 1] - CL[i]) * (beta - BETA[i]) / (BETA[i + 1] - BETA[i]);
+	}
+	else {
+		*cl = CL[nabsc - 1];
+	}
+	*cm = 0.0;
+	*cd = 0.015 + oapiGetInducedDrag (*cl, A, 0.6) + oapiGetWaveDrag (M, 0.75, 1.0, 1.1, 0.04);
+}
+
+//////////Aero table file format (.aero, little endian)
+//
+//AeroFileHeader, then AERO_TABLE_COUNT AeroGrid records, then the node
+//arrays at the offsets the grids give. Nodes are ordered Re layer, aoa,
+//Mach (Mach varies fastest). The checksum covers every byte after it.
+//The header records the aspect ratios the tables were sampled with, and
+//a file whose ratios are not the module's is rejected as stale.
+
+enum AeroTableId {AERO_VLIFT, AERO_HLIFT, AERO_TABLE_COUNT};
+
+const char AERO_FILE_MAGIC[8] = {'B', '7', '4', '7', 'A', 'E', 'R', 'O'};
+const uint32_t AERO_FILE_VERSION = 2;
+const char AERO_FILE_NAME[] = "B747";     //Config/Boeing747/Aero/<name>.aero
+
+struct AeroFileHeader {
+    char magic[8];
+    uint64_t checksum;
+    uint32_t version;
+    uint32_t ntables;
+    uint64_t size;          //Whole file in bytes
+    double vlift_A;         //Wing aspect ratio
+    double hlift_A;         //Stabiliser aspect ratio
+};
+
+struct AeroGrid {
+    uint32_t naoa, nmach, nre, reserved;
+    double aoa_min, aoa_step;
+    double mach_min, mach_step;
+    double log10re_min, log10re_step;
+    uint64_t offset;        //Bytes from the start of the file to the first node
+};
+
+struct AeroNode {
+    float cl, cm, cd;
+};
+
+static_assert(sizeof(AeroFileHeader) == 48 && sizeof(AeroGrid) == 72 && sizeof(AeroNode) == 12, "aero file layout");
+
+//FNV-1a over 64-bit words; size must be a multiple of 8.
+inline uint64_t AeroChecksum(const void *data, size_t size){
+    const uint8_t *p = (const uint8_t *)data;
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i + 8 <= size; i += 8) {
+        uint64_t w;
+        memcpy(&w, p + i, 8);
+        h = (h ^ w) * 1099511628211ull;
+    }
+    return h;
+}
+
+class AeroTable {
+
+    public:
+
+        AeroTable() : node(NULL) { SetGrid(DefaultGrid()); }
+
+        static AeroGrid DefaultGrid(void){
+            AeroGrid g = {};
+            g.naoa = 361;
+            g.nmach = 81;
+            g.nre = 1;
+            g.aoa_min = -PI;
+            g.aoa_step = RAD;
+            g.mach_min = 0.0;
+            g.mach_step = 0.025;
+            return g;
+        }
+
+        //Samples the curve at every node into memory owned by the table.
+        void Sample(AeroCurveFunc curve, double A, const AeroGrid &g = DefaultGrid()){
+            SetGrid(g);
+            owned.resize((size_t)g.nre*g.naoa*g.nmach);
+            AeroNode *n = owned.data();
+            for (uint32_t k = 0; k < g.nre; k++)
+                for (uint32_t i = 0; i < g.naoa; i++)
+                    for (uint32_t j = 0; j < g.nmach; j++) {
+                        double cl, cm, cd;
+                        curve(g.aoa_min + i*g.aoa_step, g.mach_min + j*g.mach_step, A, &cl, &cm, &cd);
+                        *n++ = {(float)cl, (float)cm, (float)cd};
+                    }
+            node = owned.data();
+        }
+
+        //Reads the nodes in place, e.g. from a mapped file. They must outlive the table's use.
+        void Attach(const AeroGrid &g, const AeroNode *nodes){
+            SetGrid(g);
+            owned.clear();
+            owned.shrink_to_fit();
+            node = nodes;
+        }
+
+        void Clear(void){
+            owned.clear();
+            owned.shrink_to_fit();
+            node = NULL;
+        }
+
+        bool IsBuilt(void) const { return node != NULL; }
+        const AeroGrid &Grid(void) const { return grid; }
+        const AeroNode *Nodes(void) const { return node; }
+        size_t NodeCount(void) const { return (size_t)grid.nre*grid.naoa*grid.nmach; }
+
+        //No branches on aoa or M. Tables with Re layers take LookupRe.
+        //Results are only stored at the end so the outputs cannot alias the grid.
+        void Lookup(double aoa, double M, double Re, double *cl, double *cm, double *cd) const {
+            if (re_stride) {
+                LookupRe(aoa, M, Re, cl, cm, cd);
+                return;
+            }
+            Cell c = Locate(aoa, M);
+            Coeffs r = Blend(c);
+            *cl = r.cl;
+            *cm = r.cm;
+            *cd = r.cd;
+        }
+
+    private:
+
+        void SetGrid(const AeroGrid &g){
+            grid = g;
+            aoa_max = g.aoa_min + (g.naoa - 1)*g.aoa_step;
+            mach_max = g.mach_min + (g.nmach - 1)*g.mach_step;
+            re_max = g.log10re_min + (g.nre > 1 ? (g.nre - 1)*g.log10re_step : 0.0);
+            aoa_scale = 1.0/g.aoa_step;
+            mach_scale = 1.0/g.mach_step;
+            re_scale = g.nre > 1 ? 1.0/g.log10re_step : 0.0;
+            re_stride = g.nre > 1 ? (size_t)g.naoa*g.nmach : 0;
+        }
+
+        struct Cell {
+            const AeroNode *n;
+            double fa, fm;
+        };
+
+        struct Coeffs {
+            double cl, cm, cd;
+        };
+
+        Cell Locate(double aoa, double M) const {
+            double x = (std::min(std::max(aoa, grid.aoa_min), aoa_max) - grid.aoa_min)*aoa_scale;
+            double y = (std::min(std::max(M, grid.mach_min), mach_max) - grid.mach_min)*mach_scale;
+            int i = std::min((int)x, (int)grid.naoa - 2);
+            int j = std::min((int)y, (int)grid.nmach - 2);
+            return {node + (size_t)i*grid.nmach + j, x - i, y - j};
+        }
+
+        //Lerp along Mach on both aoa rows, then along aoa.
+        Coeffs Blend(const Cell &c) const {
+            const AeroNode *n0 = c.n, *n1 = c.n + grid.nmach;
+            double cl0 = n0[0].cl + (n0[1].cl - n0[0].cl)*c.fm, cl1 = n1[0].cl + (n1[1].cl - n1[0].cl)*c.fm;
+            double cm0 = n0[0].cm + (n0[1].cm - n0[0].cm)*c.fm, cm1 = n1[0].cm + (n1[1].cm - n1[0].cm)*c.fm;
+            double cd0 = n0[0].cd + (n0[1].cd - n0[0].cd)*c.fm, cd1 = n1[0].cd + (n1[1].cd - n1[0].cd)*c.fm;
+            return {cl0 + (cl1 - cl0)*c.fa, cm0 + (cm1 - cm0)*c.fa, cd0 + (cd1 - cd0)*c.fa};
+        }
+
+        __attribute__((noinline)) void LookupRe(double aoa, double M, double Re, double *cl, double *cm, double *cd) const {
+            Cell c = Locate(aoa, M);
+            double z = (std::min(std::max(log10(std::max(Re, 1.0)), grid.log10re_min), re_max) - grid.log10re_min)*re_scale;
+            int k = std::min((int)z, (int)grid.nre - 2);
+            double fr = z - k;
+            c.n += k*re_stride;
+            Coeffs r0 = Blend(c);
+            c.n += re_stride;
+            Coeffs r1 = Blend(c);
+            *cl = r0.cl + (r1.cl - r0.cl)*fr;
+            *cm = r0.cm + (r1.cm - r0.cm)*fr;
+            *cd = r0.cd + (r1.cd - r0.cd)*fr;
+        }
+
+        AeroGrid grid;
+        double aoa_max, mach_max, re_max;
+        double aoa_scale, mach_scale, re_scale;
+        size_t re_stride;
+        const AeroNode *node;
+        std::vector<AeroNode> owned;
+};
+
+//The lift and stabiliser tables of one airframe.
+class AeroPolars {
+
+    public:
+
+        AeroTable vlift, hlift;
+
+        AeroPolars() : map(MAP_FAILED), map_size(0) {}
+        ~AeroPolars(){ Release(); }
+
+        static void FileName(const char *name, char *fname, size_t len){
+            snprintf(fname, len, "Config/Boeing747/Aero/%s.aero", name);
+        }
+
+        //Call from InitModule. Maps the .aero file, or samples the built-in
+        //curves with the given aspect ratios if it is unusable; airframe
+        //names the module in the log.
+        void Load(const char *airframe, double vlift_A, double hlift_A){
+            char fname[256];
+            FileName(AERO_FILE_NAME, fname, sizeof(fname));
+            const char *err = Map(fname, vlift_A, hlift_A);
+            if (!err) {
+                oapiWriteLogV("%s: aero tables mapped from %s", airframe, fname);
+                return;
+            }
+            oapiWriteLogV("%s: %s %s, using built-in aero curves", airframe, fname, err);
+            vlift.Sample(B747VLiftCurve, vlift_A);
+            hlift.Sample(B747HLiftCurve, hlift_A);
+        }
+
+        //Call from ExitModule.
+        void Release(void){
+            vlift.Clear();
+            hlift.Clear();
+            if (map != MAP_FAILED) munmap(map, map_size);
+            map = MAP_FAILED;
+            map_size = 0;
+        }
+
+        bool IsMapped(void) const { return map != MAP_FAILED; }
+        const AeroFileHeader *Header(void) const { return IsMapped() ? (const AeroFileHeader *)map : NULL; }
+
+        //Returns NULL on success, otherwise why the file was rejected. An
+        //aspect ratio of 0 accepts whatever the file was sampled with.
+        const char *Map(const char *fname, double vlift_A = 0.0, double hlift_A = 0.0){
+            int fd = open(fname, O_RDONLY);
+            if (fd < 0) return "not found";
+            struct stat st;
+            void *p = MAP_FAILED;
+            if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(AeroFileHeader))
+                p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            close(fd);
+            if (p == MAP_FAILED) return "cannot be mapped";
+
+            size_t size = st.st_size;
+            const char *err = Validate((const uint8_t *)p, size);
+            const AeroFileHeader *h = (const AeroFileHeader *)p;
+            if (!err && ((vlift_A && fabs(h->vlift_A - vlift_A) > 1e-9) || (hlift_A && fabs(h->hlift_A - hlift_A) > 1e-9)))
+                err = "was sampled with other aspect ratios";
+            if (err) {
+                munmap(p, size);
+                return err;
+            }
+
+            Release();
+            map = p;
+            map_size = size;
+            const AeroGrid *g = (const AeroGrid *)((const uint8_t *)p + sizeof(AeroFileHeader));
+            vlift.Attach(g[AERO_VLIFT], (const AeroNode *)((const uint8_t *)p + g[AERO_VLIFT].offset));
+            hlift.Attach(g[AERO_HLIFT], (const AeroNode *)((const uint8_t *)p + g[AERO_HLIFT].offset));
+            return NULL;
+        }
+
+    private:
+
+        static const char *Validate(const uint8_t *p, size_t size){
+            const AeroFileHeader *h = (const AeroFileHeader *)p;
+            if (memcmp(h->magic, AERO_FILE_MAGIC, sizeof(h->magic))) return "is not an aero table file";
+            if (h->version != AERO_FILE_VERSION) return "has a stale format version";
+            if (h->ntables != AERO_TABLE_COUNT || h->size != size || size % 8) return "has a bad size";
+            if (size < sizeof(AeroFileHeader) + AERO_TABLE_COUNT*sizeof(AeroGrid)) return "has a bad size";
+            if (h->checksum != AeroChecksum(p + 16, size - 16)) return "fails the checksum";
+
+            const AeroGrid *g = (const AeroGrid *)(p + sizeof(AeroFileHeader));
+            for (int t = 0; t < AERO_TABLE_COUNT; t++) {
+                if (g[t].naoa < 2 || g[t].nmach < 2 || g[t].nre < 1) return "has a bad grid";
+                if (!(g[t].aoa_step > 0.0) || !(g[t].mach_step > 0.0) || (g[t].nre > 1 && !(g[t].log10re_step > 0.0))) return "has a bad grid";
+                uint64_t bytes = (uint64_t)g[t].nre*g[t].naoa*g[t].nmach*sizeof(AeroNode);
+                if (g[t].offset % alignof(AeroNode) || g[t].offset > size || bytes > size - g[t].offset) return "has a bad grid";
+            }
+            return NULL;
+        }
+
+        void *map;
+        size_t map_size;
+};
+
+#endif
@@ -0,0 +1,436 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          BOEING 747 COMMON CODE
+//
+//B747Anim.h
+//Mesh animations described as data. Config/Boeing747/Animations holds
+//one text source per airframe (<airframe>.txt) and the binary file
+//b747_animgen compiles from it (<airframe>.anim). At InitModule each
+//module reads the binary file, or parses the text source if the binary
+//one is missing, of another format version or was compiled from another
+//revision of the text source, and builds the group transforms once; every
+//vessel of the class then creates its animations from them in one pass.
+//A module drives the animations it binds by name; any other animation
+//in the source is still created, at its initial state.
+//
+//Text source, one record per line, ';' starts a comment:
+//
+//  ANIM name initial_state
+//  ROTATE mesh state0 state1 ref_x ref_y ref_z axis_x axis_y axis_z angle_deg group...
+//  TRANSLATE mesh state0 state1 shift_x shift_y shift_z group...
+//  SCALE mesh state0 state1 ref_x ref_y ref_z scale_x scale_y scale_z group...
+//
+//Components belong to the ANIM line above them.
+//
+//AnimScheduler sits between a vessel and SetAnimation for the
+//animations its code drives. A state that moved less than ANIM_EPSILON
+//is not sent, unless it is an end stop (0 or 1) or the part has come to
+//rest there (the same state set twice), so a part never stops a few
+//hundredths of a degree short. Cosmetic animations are not sent either while nobody can
+//see them: fan blades while the vessel has no visual or the camera is
+//more than ANIM_CULL_DISTANCE away, cockpit parts unless the camera is
+//in this vessel's virtual cockpit. Their latest state is sent when they
+//become visible again.
+//
+//==========================================
+
+#pragma once
+
+#ifndef __B747ANIM_H
+#define __B747ANIM_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <strings.h>
+#include <vector>
+#include <sys/stat.h>
+#include "Orbitersdk.h"
+
+enum AnimTransform {ANIM_ROTATE, ANIM_TRANSLATE, ANIM_SCALE, ANIM_TRANSFORM_COUNT};
+
+//Binary file layout: AnimFileHeader, then nanims AnimRecord, ncomps
+//AnimComponent and ngroups uint32_t group indices, zero padded to a
+//multiple of 8 bytes.
+
+const char ANIM_FILE_MAGIC[8] = {'B', '7', '4', '7', 'A', 'N', 'I', 'M'};
+const uint32_t ANIM_FILE_VERSION = 2;
+const int ANIM_NAME_LEN = 24;
+
+struct AnimFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t nanims, ncomps, ngroups;
+    uint64_t source_size;   //Bytes of the text source it was compiled from
+    int64_t source_mtime;   //and its modification time, seconds
+    uint64_t size;          //Whole file in bytes
+};
+
+struct AnimRecord {
+    char name[ANIM_NAME_LEN];
+    double state;           //Initial state
+    uint32_t first, count;  //Components
+};
+
+struct AnimComponent {
+    uint32_t type, mesh;
+    uint32_t first, count;  //Groups
+    double state0, state1;
+    double v0[3];           //Rotation and scale reference point, or translation
+    double v1[3];           //Rotation axis or scale factors
+    double angle;           //Rotation, radians
+};
+
+static_assert(sizeof(AnimFileHeader) == 48 && sizeof(AnimRecord) == 40 && sizeof(AnimComponent) == 88, "anim file layout");
+
+//When AnimScheduler sends an animation's state. ANIM_UNSCHEDULED is
+//for the animations Orbiter drives itself, like the control surfaces.
+enum AnimUpdate {ANIM_UNSCHEDULED, ANIM_ALWAYS, ANIM_EXTERNAL, ANIM_VC};
+
+const double ANIM_EPSILON = 1e-4;          //Smallest state change sent
+const double ANIM_CULL_DISTANCE = 2000.0;  //m, camera distance beyond which ANIM_EXTERNAL stops
+const int ANIM_SCHEDULED_MAX = 32;         //Handles from 0 to this are scheduled, the rest pass through
+
+class AnimScheduler {
+
+    public:
+
+        AnimScheduler() : vessel(NULL), visual(false), near(false), vc(false), entry{} {}
+
+        void Init(VESSEL *v){ vessel = v; }
+
+        void Track(UINT anim, AnimUpdate update, double state){
+            if (update == ANIM_UNSCHEDULED) return;
+            if (anim >= (UINT)ANIM_SCHEDULED_MAX) {
+                oapiWriteLogV("%s: animation %u is past ANIM_SCHEDULED_MAX (%d), it is sent on every Set", vessel->GetClassName(), anim, ANIM_SCHEDULED_MAX);
+                return;
+            }
+            entry[anim] = {state, state, update};
+        }
+
+        //Sends `state` now if the animation is visible and it moved, otherwise keeps it for later.
+        //Handles past ANIM_SCHEDULED_MAX go straight to SetAnimation.
+        void Set(UINT anim, double state){
+            if (anim >= (UINT)ANIM_SCHEDULED_MAX || entry[anim].update == ANIM_UNSCHEDULED) {
+                vessel->SetAnimation(anim, state);
+                return;
+            }
+            Entry &e = entry[anim];
+            bool rest = state == e.pending;
+            e.pending = state;
+            if (!Visible(e.update) || state == e.sent) return;
+            if (rest || state <= 0.0 || state >= 1.0 || std::fabs(state - e.sent) > ANIM_EPSILON) Send(anim);
+        }
+
+        //From clbkVisualCreated and clbkVisualDestroyed.
+        void SetVisual(bool created){
+            visual = created;
+            Refresh();
+        }
+
+        //Once per step, before the Set calls. Without a visual it calls nothing.
+        void Update(){
+            if (visual) Refresh();
+        }
+
+        //Whether the camera is in this vessel's virtual cockpit, so ANIM_VC states are worth computing.
+        bool InVC() const { return vc; }
+
+    private:
+
+        struct Entry {
+            double sent, pending;
+            AnimUpdate update;
+        };
+
+        bool Visible(AnimUpdate update) const {
+            return update == ANIM_ALWAYS || (update == ANIM_EXTERNAL && near) || (update == ANIM_VC && vc);
+        }
+
+        void Refresh(){
+            bool was_near = near, was_vc = vc;
+            vc = visual && oapiCameraInternal() && oapiCockpitMode() == COCKPIT_VIRTUAL && oapiGetFocusObject() == vessel->GetHandle();
+            near = vc;
+            if (visual && !vc) {
+                VECTOR3 cam, pos;
+                oapiCameraGlobalPos(&cam);
+                vessel->GetGlobalPos(pos);
+                near = dist(cam, pos) < ANIM_CULL_DISTANCE;
+            }
+            if ((near && !was_near) || (vc && !was_vc)) Flush();
+        }
+
+        //Sends the states kept while their animations were hidden.
+        void Flush(){
+            for (UINT anim = 0; anim < (UINT)ANIM_SCHEDULED_MAX; anim++)
+                if (entry[anim].update != ANIM_UNSCHEDULED && Visible(entry[anim].update) && entry[anim].pending != entry[anim].sent)
+                    Send(anim);
+        }
+
+        void Send(UINT anim){
+            vessel->SetAnimation(anim, entry[anim].pending);
+            entry[anim].sent = entry[anim].pending;
+        }
+
+        VESSEL *vessel;
+        bool visual, near, vc;
+        Entry entry[ANIM_SCHEDULED_MAX];
+};
+
+//Where a module wants the handle of a named animation, and how it is scheduled.
+struct AnimBinding {
+    const char *name;
+    unsigned int *anim;
+    AnimUpdate update = ANIM_UNSCHEDULED;
+};
+
+class AnimationSet {
+
+    public:
+
+        static void FileName(const char *airframe, const char *ext, char *fname, size_t len){
+            snprintf(fname, len, "Config/Boeing747/Animations/%s.%s", airframe, ext);
+        }
+
+        //Call from InitModule.
+        void Load(const char *airframe){
+            char fname[256], src[256];
+            snprintf(owner, sizeof(owner), "%s", airframe);
+            FileName(airframe, "anim", fname, sizeof(fname));
+            FileName(airframe, "txt", src, sizeof(src));
+            const char *err = Read(fname, src);
+            if (!err) {
+                oapiWriteLogV("%s: %d animations, %d components read from %s", owner, Count(), (int)comps.size(), fname);
+                return;
+            }
+            oapiWriteLogV("%s: %s %s, parsing %s", owner, fname, err, src);
+            err = Parse(src);
+            if (err) {
+                Clear();
+                oapiWriteLogV("%s: %s %s, vessels are not animated", owner, src, err);
+            }
+        }
+
+        //Returns NULL on success, otherwise why the file was rejected. With
+        //a source, the file must have been compiled from it as it is now.
+        const char *Read(const char *fname, const char *source = NULL){
+            FILE *f = fopen(fname, "rb");
+            if (!f) return "not found";
+            std::vector<uint8_t> buf;
+            uint8_t chunk[4096];
+            size_t n;
+            while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) buf.insert(buf.end(), chunk, chunk + n);
+            fclose(f);
+
+            const char *err = Validate(buf.data(), buf.size());
+            if (err) return err;
+            const AnimFileHeader *h = (const AnimFileHeader *)buf.data();
+            struct stat st;
+            if (source && stat(source, &st) == 0 &&
+                ((uint64_t)st.st_size != h->source_size || (int64_t)st.st_mtime != h->source_mtime))
+                return "is older than its source";
+            const uint8_t *p = buf.data() + sizeof(AnimFileHeader);
+            anims.assign((const AnimRecord *)p, (const AnimRecord *)p + h->nanims);
+            p += h->nanims*sizeof(AnimRecord);
+            comps.assign((const AnimComponent *)p, (const AnimComponent *)p + h->ncomps);
+            p += h->ncomps*sizeof(AnimComponent);
+            groups.resize(h->ngroups);
+            memcpy(groups.data(), p, h->ngroups*sizeof(uint32_t));
+            MakeTransforms();
+            return NULL;
+        }
+
+        //Reads a text source. Returns NULL on success, otherwise the first error and its line.
+        const char *Parse(const char *fname){
+            FILE *f = fopen(fname, "r");
+            if (!f) return "not found";
+            Clear();
+            char line[1024];
+            const char *err = NULL;
+            int lineno = 0;
+            while (!err && fgets(line, sizeof(line), f)) {
+                lineno++;
+                if (char *c = strchr(line, ';')) *c = '\0';
+                err = ParseLine(line);
+            }
+            fclose(f);
+            if (err) {
+                snprintf(error, sizeof(error), "line %d: %s", lineno, err);
+                Clear();
+                return error;
+            }
+            MakeTransforms();
+            return NULL;
+        }
+
+        //Creates every animation on `v`, stores the handles the module asked
+        //for and hands the scheduled ones to `sched`. A binding with no
+        //animation of its name gets an empty one.
+        void Create(VESSEL *v, const AnimBinding *bindings, int nbindings, AnimScheduler *sched = NULL) const {
+            std::vector<bool> bound(nbindings, false);
+            if (sched) sched->Init(v);
+            for (const AnimRecord &a : anims) {
+                UINT anim = v->CreateAnimation(a.state);
+                for (uint32_t c = a.first; c < a.first + a.count; c++) {
+                    v->AddAnimationComponent(anim, comps[c].state0, comps[c].state1, trans[c].get());
+                    for (const auto &t : copies[c]) v->AddAnimationComponent(anim, comps[c].state0, comps[c].state1, t.get());
+                }
+                for (int i = 0; i < nbindings; i++) {
+                    if (strcmp(bindings[i].name, a.name)) continue;
+                    *bindings[i].anim = anim;
+                    bound[i] = true;
+                    if (sched) sched->Track(anim, bindings[i].update, a.state);
+                }
+            }
+            for (int i = 0; i < nbindings; i++) {
+                if (bound[i]) continue;
+                *bindings[i].anim = v->CreateAnimation(0.0);
+                if (sched) sched->Track(*bindings[i].anim, bindings[i].update, 0.0);
+                oapiWriteLogV("%s: no animation %s", owner, bindings[i].name);
+            }
+        }
+
+        //Call from InitModule before Load: the components on `mesh` also move
+        //the same groups of meshes first..first + count - 1 (see B747LOD.h).
+        void AnimateCopies(UINT mesh, UINT first, int count){
+            copy_mesh = mesh;
+            copy_first = first;
+            copy_count = count;
+        }
+
+        //Call from ExitModule, once no vessel is left.
+        void Clear(){
+            anims.clear();
+            comps.clear();
+            groups.clear();
+            trans.clear();
+            copies.clear();
+        }
+
+        int Count() const { return (int)anims.size(); }
+
+        const std::vector<AnimRecord> &Animations() const { return anims; }
+        const std::vector<AnimComponent> &Components() const { return comps; }
+        const std::vector<uint32_t> &Groups() const { return groups; }
+
+    private:
+
+        static const char *Validate(const uint8_t *p, size_t size){
+            if (size < sizeof(AnimFileHeader)) return "has a bad size";
+            const AnimFileHeader *h = (const AnimFileHeader *)p;
+            if (memcmp(h->magic, ANIM_FILE_MAGIC, sizeof(h->magic))) return "is not an animation file";
+            if (h->version != ANIM_FILE_VERSION) return "has a stale format version";
+            uint64_t body = sizeof(AnimFileHeader) + (uint64_t)h->nanims*sizeof(AnimRecord) +
+                (uint64_t)h->ncomps*sizeof(AnimComponent) + (uint64_t)h->ngroups*sizeof(uint32_t);
+            if (h->size != size || (body + 7)/8*8 != size) return "has a bad size";
+
+            const AnimRecord *a = (const AnimRecord *)(p + sizeof(AnimFileHeader));
+            const AnimComponent *c = (const AnimComponent *)(a + h->nanims);
+            for (uint32_t i = 0; i < h->nanims; i++)
+                if (!memchr(a[i].name, '\0', ANIM_NAME_LEN) || a[i].first > h->ncomps || a[i].count > h->ncomps - a[i].first)
+                    return "has a bad animation record";
+            for (uint32_t i = 0; i < h->ncomps; i++)
+                if (c[i].type >= ANIM_TRANSFORM_COUNT || !c[i].count || c[i].first > h->ngroups || c[i].count > h->ngroups - c[i].first)
+                    return "has a bad component record";
+            return NULL;
+        }
+
+        const char *ParseLine(char *line){
+            const char *tok[64];
+            int n = 0;
+            for (char *t = strtok(line, " \t\r\n"); t && n < 64; t = strtok(NULL, " \t\r\n")) tok[n++] = t;
+            if (!n) return NULL;
+
+            if (!strcasecmp(tok[0], "ANIM")) {
+                if (n != 3) return "ANIM takes a name and an initial state";
+                if (strlen(tok[1]) >= ANIM_NAME_LEN) return "animation name too long";
+                AnimRecord a = {};
+                strcpy(a.name, tok[1]);
+                if (!Number(tok[2], a.state)) return "bad initial state";
+                a.first = (uint32_t)comps.size();
+                anims.push_back(a);
+                return NULL;
+            }
+
+            AnimComponent c = {};
+            int nvalues;
+            if (!strcasecmp(tok[0], "ROTATE")) c.type = ANIM_ROTATE, nvalues = 7;
+            else if (!strcasecmp(tok[0], "TRANSLATE")) c.type = ANIM_TRANSLATE, nvalues = 3;
+            else if (!strcasecmp(tok[0], "SCALE")) c.type = ANIM_SCALE, nvalues = 6;
+            else return "unknown record";
+            if (anims.empty()) return "component before the first ANIM";
+            if (n < 4 + nvalues + 1) return "too few values";
+
+            double x[10];
+            for (int i = 0; i < 3 + nvalues; i++)
+                if (!Number(tok[1 + i], x[i])) return "bad number";
+            if (x[0] < 0 || x[0] != (uint32_t)x[0]) return "bad mesh index";
+            c.mesh = (uint32_t)x[0];
+            c.state0 = x[1];
+            c.state1 = x[2];
+            for (int i = 0; i < 3; i++) {
+                c.v0[i] = x[3 + i];
+                if (nvalues >= 6) c.v1[i] = x[6 + i];
+            }
+            if (c.type == ANIM_ROTATE) c.angle = x[9]*RAD;
+
+            c.first = (uint32_t)groups.size();
+            for (int i = 4 + nvalues; i < n; i++) {
+                char *end;
+                unsigned long g = strtoul(tok[i], &end, 10);
+                if (*end || tok[i][0] == '-') return "bad group index";
+                groups.push_back((uint32_t)g);
+                c.count++;
+            }
+            comps.push_back(c);
+            anims.back().count++;
+            return NULL;
+        }
+
+        static bool Number(const char *s, double &x){
+            char *end;
+            x = strtod(s, &end);
+            return end != s && !*end;
+        }
+
+        //Orbiter keeps the transforms and group lists for the life of the
+        //animations, so they are built once and shared by every vessel.
+        void MakeTransforms(){
+            trans.clear();
+            copies.clear();
+            copies.resize(comps.size());
+            for (size_t i = 0; i < comps.size(); i++) {
+                const AnimComponent &c = comps[i];
+                trans.emplace_back(MakeTransform(c, c.mesh));
+                if (c.mesh == copy_mesh)
+                    for (int k = 0; k < copy_count; k++) copies[i].emplace_back(MakeTransform(c, copy_first + k));
+            }
+        }
+
+        MGROUP_TRANSFORM *MakeTransform(const AnimComponent &c, UINT mesh){
+            UINT *grp = groups.data() + c.first;
+            VECTOR3 v0 = _V(c.v0[0], c.v0[1], c.v0[2]), v1 = _V(c.v1[0], c.v1[1], c.v1[2]);
+            switch (c.type) {
+                case ANIM_ROTATE: return new MGROUP_ROTATE(mesh, grp, c.count, v0, v1, (float)c.angle);
+                case ANIM_TRANSLATE: return new MGROUP_TRANSLATE(mesh, grp, c.count, v0);
+                default: return new MGROUP_SCALE(mesh, grp, c.count, v0, v1);
+            }
+        }
+
+        std::vector<AnimRecord> anims;
+        std::vector<AnimComponent> comps;
+        std::vector<uint32_t> groups;
+        std::vector<std::unique_ptr<MGROUP_TRANSFORM>> trans;
+        std::vector<std::vector<std::unique_ptr<MGROUP_TRANSFORM>>> copies;    //By component
+        UINT copy_mesh = 0, copy_first = 0;
+        int copy_count = 0;
+        char owner[32] = "";
+        char error[160];
+};
+
+#endif
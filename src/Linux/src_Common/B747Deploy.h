@@ -0,0 +1,184 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          BOEING 747 COMMON CODE
+//
+//B747Deploy.h
+//Parts that travel between two end positions: the landing gear, the
+//AAC's doors, the SOFIA's telescope hatch. Each kind is described by a
+//traits struct, and a vessel keeps all of its parts in one Deployables
+//array whose Update only visits the ones moving, so a step costs nothing
+//for the parts at rest.
+//
+//A traits struct for an owner class V gives:
+//
+//  static constexpr double SPEED;         position change per second
+//  static constexpr int SOUND;            XRSound id played when it is commanded, -1 for none
+//  static void Moved(V &, double proc);   after every position change: animations, touchdown points
+//  static void Detent(V &, DeployStatus); when it comes to rest at either end
+//
+//Positions run from 0 to 1. DeployStatus keeps the numbering the
+//scenario GEAR, DOORS and TELESCOPE lines have always used.
+//
+//A part moves at constant speed, so one step is a closed form jump of
+//simdt*SPEED however long simdt is, and a frame under time acceleration
+//costs the same as any other. What a long frame can get wrong is the
+//order of what happens inside it: the parts that come to rest during
+//the frame run their hooks in the order they arrive, not in id order,
+//and before the parts still moving at the end of the frame.
+//
+//==========================================
+
+#pragma once
+
+#ifndef __B747DEPLOY_H
+#define __B747DEPLOY_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <utility>
+#include "Orbitersdk.h"
+#include "XRSound.h"
+
+enum DeployStatus{DEPLOY_AT_0, DEPLOY_AT_1, DEPLOY_TO_0, DEPLOY_TO_1};
+
+const int DEPLOYABLES_MAX = 32;  //Bits in the mask of moving parts
+
+//One step of a part of kind Traits. Compiled once per kind, with its speed and hooks inlined.
+template<class V, class Traits> struct Deployable {
+
+    //Returns false when the part has come to rest.
+    static bool Step(V &v, double &proc, DeployStatus &status, double simdt){
+        double da = simdt*Traits::SPEED;
+        bool to1 = status == DEPLOY_TO_1;
+        proc = to1 ? std::min(1.0, proc + da) : std::max(0.0, proc - da);
+        Traits::Moved(v, proc);
+        if (proc != (to1 ? 1.0 : 0.0)) return true;
+        status = to1 ? DEPLOY_AT_1 : DEPLOY_AT_0;
+        Traits::Detent(v, status);
+        return false;
+    }
+};
+
+template<class V, int N> class Deployables {
+
+    static_assert(N > 0 && N <= DEPLOYABLES_MAX, "Deployables holds 1 to 32 parts");
+
+    public:
+
+        Deployables() : active(0), proc{}, speed{}, status{}, step{}, moved{}, detent{}, sound{} {}
+
+        //Call from the constructor for every id below N. The part starts at rest at 0.
+        template<class Traits> void Add(int i){
+            proc[i] = 0.0;
+            speed[i] = Traits::SPEED;
+            status[i] = DEPLOY_AT_0;
+            step[i] = &Deployable<V, Traits>::Step;
+            moved[i] = &Traits::Moved;
+            detent[i] = &Traits::Detent;
+            sound[i] = Traits::SOUND;
+        }
+
+        //Adds Traits<0>...Traits<K-1> as parts first...first+K-1, e.g. one door kind per door.
+        template<template<int> class Traits, int... K> void AddEach(int first, std::integer_sequence<int, K...>){
+            (Add<Traits<K>>(first + K), ...);
+        }
+
+        //Starts part `i` towards DEPLOY_TO_0 or DEPLOY_TO_1, from wherever it is.
+        void Command(int i, DeployStatus target, XRSound *snd = NULL){
+            status[i] = target;
+            active |= 1u << i;
+            if (snd && sound[i] >= 0) snd->PlayWav(sound[i]);
+        }
+
+        //What the key handlers do: back towards 1 if at or going to 0, otherwise towards 0.
+        void Toggle(int i, XRSound *snd = NULL){
+            Command(i, (status[i] == DEPLOY_AT_0 || status[i] == DEPLOY_TO_0) ? DEPLOY_TO_1 : DEPLOY_TO_0, snd);
+        }
+
+        //Toggle for every part in `mask` at once, with one sound: all of them
+        //towards 1 if any is at or going to 0, otherwise all towards 0. Parts
+        //already at rest at that end stay out of the moving set.
+        void ToggleAll(uint32_t mask, XRSound *snd = NULL){
+            DeployStatus target = DEPLOY_TO_0, rest = DEPLOY_AT_0;
+            for (uint32_t m = mask; m; m &= m - 1) {
+                int i = std::countr_zero(m);
+                if (status[i] == DEPLOY_AT_0 || status[i] == DEPLOY_TO_0) {
+                    target = DEPLOY_TO_1;
+                    rest = DEPLOY_AT_1;
+                    break;
+                }
+            }
+            int first = -1;
+            for (uint32_t m = mask; m; m &= m - 1) {
+                int i = std::countr_zero(m);
+                if (status[i] == rest) continue;
+                status[i] = target;
+                active |= 1u << i;
+                if (first < 0) first = i;
+            }
+            if (snd && first >= 0 && sound[first] >= 0) snd->PlayWav(sound[first]);
+        }
+
+        //From clbkLoadStateEx, with the status and position of a scenario line. Runs the hooks once.
+        void Set(V &v, int i, int st, double p){
+            status[i] = (DeployStatus)std::clamp(st, (int)DEPLOY_AT_0, (int)DEPLOY_TO_1);
+            proc[i] = std::clamp(p, 0.0, 1.0);
+            if (status[i] >= DEPLOY_TO_0) active |= 1u << i;
+            else active &= ~(1u << i);
+            moved[i](v, proc[i]);
+            if (status[i] < DEPLOY_TO_0) detent[i](v, status[i]);
+        }
+
+        //From clbkPostStep.
+        void Update(V &v, double simdt){
+            int arriving[N], n = 0;
+            double at[N];
+            for (uint32_t m = active; m; m &= m - 1) {
+                int i = std::countr_zero(m);
+                double t = (status[i] == DEPLOY_TO_1 ? 1.0 - proc[i] : proc[i])/speed[i];
+                if (t > simdt) continue;
+                int k = n++;
+                for (; k > 0 && at[k - 1] > t; k--) {
+                    at[k] = at[k - 1];
+                    arriving[k] = arriving[k - 1];
+                }
+                at[k] = t;
+                arriving[k] = i;
+            }
+            for (int k = 0; k < n; k++) {
+                int i = arriving[k];
+                if (!step[i](v, proc[i], status[i], simdt)) active &= ~(1u << i);
+            }
+            uint32_t moving = active;
+            for (int k = 0; k < n; k++) moving &= ~(1u << arriving[k]);
+            for (uint32_t m = moving; m; m &= m - 1) {
+                int i = std::countr_zero(m);
+                if (!step[i](v, proc[i], status[i], simdt)) active &= ~(1u << i);
+            }
+        }
+
+        double Proc(int i) const { return proc[i]; }
+        DeployStatus Status(int i) const { return status[i]; }
+        bool Moving(int i) const { return (active >> i) & 1; }
+        uint32_t Active() const { return active; }
+
+    private:
+
+        typedef bool (*StepFunc)(V &, double &, DeployStatus &, double);
+        typedef void (*MovedFunc)(V &, double);
+        typedef void (*DetentFunc)(V &, DeployStatus);
+
+        uint32_t active;                 //Bit i set while part i is moving
+        double proc[N];
+        double speed[N];                 //Traits::SPEED, for the arrival times
+        DeployStatus status[N];
+        StepFunc step[N];
+        MovedFunc moved[N];
+        DetentFunc detent[N];
+        int sound[N];
+};
+
+#endif
@@ -0,0 +1,78 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          BOEING 747 COMMON CODE
+//
+//B747Doors.h
+//Passenger doors PSGR_door1..10 and lower deck cargo doors CRG_door1..4
+//of the meshes that have them. Their animations are named below in the
+//Config/Boeing747/Animations files, and each door is one part of the
+//vessel's Deployables, so closed doors cost nothing per step.
+//
+//  Ctrl+1..0   passenger door 1..10
+//  Alt+1..4    cargo door 1..4
+//  K           all doors: open them all if any is closed, otherwise close them all
+//
+//The scenario has a DOOR line for every door that is not closed:
+//DOOR <door 1..14> <status> <position>.
+//
+//==========================================
+
+#pragma once
+
+#ifndef __B747DOORS_H
+#define __B747DOORS_H
+
+#include <cstdint>
+#include <cstdio>
+#include <utility>
+#include "Orbitersdk.h"
+#include "B747Deploy.h"
+
+const int PSGR_DOOR_COUNT = 10;
+const int CRG_DOOR_COUNT = 4;
+const int CABIN_DOOR_COUNT = PSGR_DOOR_COUNT + CRG_DOOR_COUNT;
+
+constexpr double CABIN_DOOR_OPERATING_SPEED = 0.15;
+
+//Animation of each door: passenger doors first, then cargo doors.
+const char *const CABIN_DOOR_NAMES[CABIN_DOOR_COUNT] = {
+    "psgr_door1", "psgr_door2", "psgr_door3", "psgr_door4", "psgr_door5",
+    "psgr_door6", "psgr_door7", "psgr_door8", "psgr_door9", "psgr_door10",
+    "crg_door1", "crg_door2", "crg_door3", "crg_door4",
+};
+
+typedef std::make_integer_sequence<int, CABIN_DOOR_COUNT> CabinDoorSequence;
+
+//Mask of the doors' parts when the first of them is part `first`.
+constexpr uint32_t CabinDoorMask(int first){ return ((1u << CABIN_DOOR_COUNT) - 1) << first; }
+
+//Door commanded by a key press, or -1.
+inline int CabinDoorKey(int key, char *kstate){
+    if (key < OAPI_KEY_1 || key > OAPI_KEY_0) return -1;
+    int n = key - OAPI_KEY_1;
+    if (KEYMOD_CONTROL(kstate)) return n;
+    if (KEYMOD_ALT(kstate) && n < CRG_DOOR_COUNT) return PSGR_DOOR_COUNT + n;
+    return -1;
+}
+
+//From clbkLoadStateEx, for a line starting with DOOR.
+template<class V, int N> void LoadCabinDoor(V &v, Deployables<V, N> &parts, int first, const char *line){
+    int door = 0, status = 0;
+    double proc = 0.0;
+    if (sscanf(line + 4, "%d%d%lf", &door, &status, &proc) == 3 && door >= 1 && door <= CABIN_DOOR_COUNT)
+        parts.Set(v, first + door - 1, status, proc);
+}
+
+//From clbkSaveState.
+template<class V, int N> void SaveCabinDoors(FILEHANDLE scn, const Deployables<V, N> &parts, int first){
+    char cbuf[64];
+    for (int i = 0; i < CABIN_DOOR_COUNT; i++) {
+        if (parts.Status(first + i) == DEPLOY_AT_0) continue;
+        snprintf(cbuf, sizeof(cbuf), "%d %d %0.4f", i + 1, parts.Status(first + i), parts.Proc(first + i));
+        oapiWriteScenario_string(scn, "DOOR", cbuf);
+    }
+}
+
+#endif
@@ -0,0 +1,136 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          BOEING 747 COMMON CODE
+//
+//B747Engines.h
+//Engine start/stop sequencing shared by the 747 variants:
+//OFF -> STARTING -> RUNNING -> SHUTTING_DOWN -> OFF.
+//The main and retro thruster groups are created when the engines
+//reach RUNNING and deleted when they begin shutting down, so the
+//thruster group tables only change on transitions.
+//
+//==========================================
+
+#pragma once
+
+#ifndef __B747ENGINES_H
+#define __B747ENGINES_H
+
+#include <algorithm>
+#include "Orbitersdk.h"
+#include "B747Flight.h"
+
+const double ENGINE_START_TIME = 20.0;  //Seconds from autostart to thrust available.
+
+const double ENGINE_SHUTDOWN_TIME = 10.0;  //Seconds for the fans to spool down.
+
+class EngineStateMachine {
+
+    public:
+
+        enum EngineStatus{ENGINES_OFF, ENGINES_STARTING, ENGINES_RUNNING, ENGINES_SHUTTING_DOWN};
+
+        EngineStateMachine() : vessel(NULL), th_main(NULL), th_retro(NULL), nth(0),
+            thg_main(NULL), thg_retro(NULL), status(ENGINES_OFF), spool(0.0), power(0.0) {}
+
+        //Call from clbkSetClassCaps once the thrusters exist.
+        void Init(VESSEL *v, THRUSTER_HANDLE *main, THRUSTER_HANDLE *retro, int n){
+            vessel = v;
+            th_main = main;
+            th_retro = retro;
+            nth = n;
+        }
+
+        //Autostart. Returns false if the engines are already starting or running.
+        bool Start(void){
+            if(status == ENGINES_STARTING || status == ENGINES_RUNNING) return false;
+            status = ENGINES_STARTING;
+            return true;
+        }
+
+        //Autostop. Returns false if the engines are already off or shutting down.
+        bool Stop(void){
+            if(status == ENGINES_OFF || status == ENGINES_SHUTTING_DOWN) return false;
+            if(status == ENGINES_RUNNING) DeleteGroups();
+            status = ENGINES_SHUTTING_DOWN;
+            return true;
+        }
+
+        //Scenario state: jumps straight to RUNNING or OFF without the sequence.
+        void SetRunning(bool running){
+            if(running){
+                if(status != ENGINES_RUNNING) CreateGroups();
+                status = ENGINES_RUNNING;
+                spool = 1.0;
+            } else {
+                if(status == ENGINES_RUNNING) DeleteGroups();
+                status = ENGINES_OFF;
+                spool = 0.0;
+                power = 0.0;
+            }
+        }
+
+        //FlightState fields Update reads in this status.
+        unsigned int FlightFields(void) const { return status == ENGINES_RUNNING ? FLIGHT_THRUST_MAIN : 0; }
+
+        void Update(double simdt, const FlightState &flight){
+            switch(status){
+                case ENGINES_OFF:
+                break;
+
+                case ENGINES_STARTING:
+                    spool = std::min(1.0, spool + simdt / ENGINE_START_TIME);
+                    if(spool >= 1.0){
+                        CreateGroups();
+                        status = ENGINES_RUNNING;
+                    }
+                break;
+
+                case ENGINES_RUNNING:
+                    if(flight.fields & FLIGHT_THRUST_MAIN) power = flight.thrust_main;
+                break;
+
+                case ENGINES_SHUTTING_DOWN:
+                    spool = std::max(0.0, spool - simdt / ENGINE_SHUTDOWN_TIME);
+                    if(spool <= 0.0) status = ENGINES_OFF;
+                break;
+            }
+        }
+
+        EngineStatus GetStatus(void) const { return status; }
+
+        //Value of the ENGINES scenario line: an engine start in progress is saved as running.
+        int GetScenarioValue(void) const { return (status == ENGINES_STARTING || status == ENGINES_RUNNING) ? 1 : 0; }
+
+        //Fan speed fraction, 0 when off and 1 when running.
+        double GetSpool(void) const { return spool; }
+
+        //Main thruster group level, 0 unless running.
+        double GetPower(void) const { return power; }
+
+    private:
+
+        void CreateGroups(void){
+            thg_main = vessel->CreateThrusterGroup(th_main, nth, THGROUP_MAIN);
+            thg_retro = vessel->CreateThrusterGroup(th_retro, nth, THGROUP_RETRO);
+        }
+
+        void DeleteGroups(void){
+            vessel->DelThrusterGroup(thg_main);
+            vessel->DelThrusterGroup(thg_retro);
+            thg_main = thg_retro = NULL;
+            power = 0.0;
+        }
+
+        VESSEL *vessel;
+        THRUSTER_HANDLE *th_main, *th_retro;
+        int nth;
+        THGROUP_HANDLE thg_main, thg_retro;
+        EngineStatus status;
+        double spool;
+        double power;
+};
+
+#endif
@@ -0,0 +1,171 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          BOEING 747 COMMON CODE
+//
+//B747Flaps.h
+//Trailing edge flaps, set with the lever detents 0/1/5/10/20/25/30 and
+//driven by the Flaps and Flaps2 groups of every variant.
+//
+//The flaps change the wings' lift and drag through increments added to
+//the vertical lift table. FlapPolars holds one increment slice per
+//detent over a small aoa grid, built once per module. A vessel's
+//wings read the slice for its flap angle: a detent's own slice when the
+//flaps are at rest, otherwise one the vessel blends from the two
+//detents around the angle after each step in transit. The airfoil
+//callback then does one lookup and two adds, never a blend.
+//
+//  ,   one detent up
+//  .   one detent down
+//
+//The scenario line is FLAPS <lever detent> <flap angle in degrees>.
+//
+//==========================================
+
+#pragma once
+
+#ifndef __B747FLAPS_H
+#define __B747FLAPS_H
+
+#include <algorithm>
+#include <cmath>
+#include "Orbitersdk.h"
+
+const int FLAP_DETENT_COUNT = 7;
+const double FLAP_DETENTS[FLAP_DETENT_COUNT] = {0, 1, 5, 10, 20, 25, 30};  //Degrees
+const double FLAP_ANGLE_MAX = 30.0;
+
+constexpr double FLAP_OPERATING_SPEED = 1.5;  //Degrees per second
+
+//Increments at each detent in attached flow: lift, then drag.
+const double FLAP_DCL[FLAP_DETENT_COUNT] = {0, 0.03, 0.10, 0.17, 0.30, 0.38, 0.45};
+const double FLAP_DCD[FLAP_DETENT_COUNT] = {0, 0.002, 0.006, 0.012, 0.030, 0.045, 0.065};
+
+//aoa grid of the slices, every degree. Outside it the edge nodes hold:
+//no lift increment, full drag increment.
+const int FLAP_AOA_NODES = 61;
+const double FLAP_AOA_MIN = -30*RAD;
+const double FLAP_AOA_STEP = RAD;
+
+struct FlapNode {
+    float dcl, dcd;
+};
+
+struct FlapSlice {
+    FlapNode node[FLAP_AOA_NODES];
+
+    void Add(double aoa, double *cl, double *cd) const {
+        double x = (std::min(std::max(aoa, FLAP_AOA_MIN), -FLAP_AOA_MIN) - FLAP_AOA_MIN)*(1.0/FLAP_AOA_STEP);
+        int i = std::min((int)x, FLAP_AOA_NODES - 2);
+        double f = x - i;
+        const FlapNode *n = node + i;
+        *cl += n[0].dcl + (n[1].dcl - n[0].dcl)*f;
+        *cd += n[0].dcd + (n[1].dcd - n[0].dcd)*f;
+    }
+};
+
+class FlapPolars {
+
+    public:
+
+        //Call from InitModule. The lift increment is full to +-15 deg aoa and
+        //fades out towards +-30 deg, where the clean curve has stalled.
+        void Build(void){
+            for (int d = 0; d < FLAP_DETENT_COUNT; d++)
+                for (int i = 0; i < FLAP_AOA_NODES; i++) {
+                    double aoa = std::fabs(FLAP_AOA_MIN + i*FLAP_AOA_STEP);
+                    double w = std::min(1.0, std::max(0.0, (30*RAD - aoa)/(15*RAD)));
+                    slice[d].node[i] = {(float)(FLAP_DCL[d]*w), (float)FLAP_DCD[d]};
+                }
+        }
+
+        const FlapSlice &Detent(int d) const { return slice[d]; }
+
+    private:
+
+        FlapSlice slice[FLAP_DETENT_COUNT];
+};
+
+//The flaps of one vessel. Pass it as the context of the wing airfoils.
+class FlapSystem {
+
+    public:
+
+        FlapSystem() : polars(NULL), current(NULL), lever(0), angle(0.0) {}
+
+        //Call from the constructor. The module's polars are built in InitModule.
+        void Init(const FlapPolars *p){
+            polars = p;
+            Reblend();
+        }
+
+        //Moves the lever one detent; returns false at the stops.
+        bool Step(int dir){
+            int d = std::min(std::max(lever + dir, 0), FLAP_DETENT_COUNT - 1);
+            if (d == lever) return false;
+            lever = d;
+            return true;
+        }
+
+        //From clbkLoadStateEx.
+        void Set(int detent, double deg){
+            lever = std::min(std::max(detent, 0), FLAP_DETENT_COUNT - 1);
+            angle = std::min(std::max(deg, 0.0), FLAP_ANGLE_MAX);
+            Reblend();
+        }
+
+        bool Moving(void) const { return angle != FLAP_DETENTS[lever]; }
+
+        //From clbkPostStep. Returns true if the flaps moved.
+        bool Update(double simdt){
+            double target = FLAP_DETENTS[lever];
+            if (angle == target) return false;
+            double da = simdt*FLAP_OPERATING_SPEED;
+            angle = angle < target ? std::min(target, angle + da) : std::max(target, angle - da);
+            Reblend();
+            return true;
+        }
+
+        int Lever(void) const { return lever; }
+        double Angle(void) const { return angle; }
+
+        //Animation states: the lever in equal steps, the flaps by angle.
+        double LeverState(void) const { return (double)lever/(FLAP_DETENT_COUNT - 1); }
+        double FlapState(void) const { return angle/FLAP_ANGLE_MAX; }
+
+        //From the wings' lift callback.
+        void Add(double aoa, double *cl, double *cd) const {
+            if (current) current->Add(aoa, cl, cd);
+        }
+
+    private:
+
+        void Reblend(void){
+            if (!polars || angle == 0.0) {
+                current = NULL;
+                return;
+            }
+            int d = 1;
+            while (d < FLAP_DETENT_COUNT - 1 && FLAP_DETENTS[d] < angle) d++;
+            if (angle == FLAP_DETENTS[d]) {
+                current = &polars->Detent(d);
+                return;
+            }
+            const FlapSlice &a = polars->Detent(d - 1), &b = polars->Detent(d);
+            float f = (float)((angle - FLAP_DETENTS[d - 1])/(FLAP_DETENTS[d] - FLAP_DETENTS[d - 1]));
+            for (int i = 0; i < FLAP_AOA_NODES; i++) {
+                blend.node[i].dcl = a.node[i].dcl + (b.node[i].dcl - a.node[i].dcl)*f;
+                blend.node[i].dcd = a.node[i].dcd + (b.node[i].dcd - a.node[i].dcd)*f;
+            }
+            current = &blend;
+        }
+
+        const FlapPolars *polars;
+        const FlapSlice *current;    //NULL with the flaps up
+        int lever;
+        double angle;
+        FlapSlice blend;
+};
+
+#endif
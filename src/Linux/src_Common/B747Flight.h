@@ -0,0 +1,70 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          BOEING 747 COMMON CODE
+//
+//B747Flight.h
+//Snapshot of the flight values the vessel code reads, taken once at
+//the start of clbkPreStep and handed by const reference to the
+//subsystems for the rest of the step, so that no subsystem reads them
+//from Orbiter on its own.
+//
+//Each Get* is a call into Orbiter, so the snapshot only fetches the
+//fields asked for in that step's mask. The subsystems say what they
+//read: a subsystem with nothing to do this step asks for nothing.
+//Fields outside the mask keep the value of their last sample.
+//
+//==========================================
+
+#pragma once
+
+#ifndef __B747FLIGHT_H
+#define __B747FLIGHT_H
+
+#include "Orbitersdk.h"
+
+enum FlightField{
+    FLIGHT_MACH = 1 << 0,
+    FLIGHT_ALTITUDE = 1 << 1,
+    FLIGHT_GROUNDSPEED = 1 << 2,
+    FLIGHT_AIRSPEED = 1 << 3,
+    FLIGHT_AOA = 1 << 4,
+    FLIGHT_BANK = 1 << 5,
+    FLIGHT_DYNPRESSURE = 1 << 6,
+    FLIGHT_THRUST_MAIN = 1 << 7,
+    FLIGHT_THRUST_RETRO = 1 << 8,
+    FLIGHT_FUEL = 1 << 9,
+};
+
+struct FlightState {
+    double mach = 0.0;
+    double altitude = 0.0;       //m
+    double groundspeed = 0.0;    //m/s
+    double airspeed = 0.0;       //m/s
+    double aoa = 0.0;            //rad
+    double bank = 0.0;           //rad
+    double dynpressure = 0.0;    //Pa
+    double thrust_main = 0.0;    //Main thruster group level
+    double thrust_retro = 0.0;   //Retro thruster group level
+    double fuel_mass = 0.0;      //kg, all propellant resources
+
+    unsigned int fields = 0;     //FlightField bits sampled this step
+
+    //From clbkPreStep, before any subsystem runs.
+    void Sample(const VESSEL *v, unsigned int need){
+        fields = need;
+        if(need & FLIGHT_MACH) mach = v->GetMachNumber();
+        if(need & FLIGHT_ALTITUDE) altitude = v->GetAltitude();
+        if(need & FLIGHT_GROUNDSPEED) groundspeed = v->GetGroundspeed();
+        if(need & FLIGHT_AIRSPEED) airspeed = v->GetAirspeed();
+        if(need & FLIGHT_AOA) aoa = v->GetAOA();
+        if(need & FLIGHT_BANK) bank = v->GetBank();
+        if(need & FLIGHT_DYNPRESSURE) dynpressure = v->GetDynPressure();
+        if(need & FLIGHT_THRUST_MAIN) thrust_main = v->GetThrusterGroupLevel(THGROUP_MAIN);
+        if(need & FLIGHT_THRUST_RETRO) thrust_retro = v->GetThrusterGroupLevel(THGROUP_RETRO);
+        if(need & FLIGHT_FUEL) fuel_mass = v->GetFuelMass();
+    }
+};
+
+#endif
@@ -0,0 +1,110 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          BOEING 747 COMMON CODE
+//
+//B747Gear.h
+//Touchdown point sets for the landing gear. SetTouchdownPoints makes
+//Orbiter rebuild the vessel's contact model, so a vessel only sends a
+//set when the gear position moves it into another one, not on every
+//step of the 17 s transition.
+//
+//By default there are two sets, gear down and gear up, swapped when the
+//gear is halfway. With GearContactSteps = N in the class cfg the wheel
+//contacts instead rise in N steps from their extended position towards
+//the belly as the gear retracts, so a touchdown with the gear partly
+//out lands on shortened struts.
+//
+//==========================================
+
+#pragma once
+
+#ifndef __B747GEAR_H
+#define __B747GEAR_H
+
+#include <algorithm>
+#include <vector>
+#include "Orbitersdk.h"
+
+const double GEAR_CONTACT_THRESHOLD = 0.5;  //Gear position at which the two sets swap
+const int GEAR_CONTACT_STEPS_MAX = 32;
+
+class TouchdownSets {
+
+    public:
+
+        TouchdownSets() : steps(0) {}
+
+        //`down` starts with the `nwheels` wheel contacts, as Orbiter takes its
+        //first three points for the ground plane. Call once, from the first
+        //clbkSetClassCaps of the class; every vessel of the class uses the sets.
+        void Build(const TOUCHDOWNVTX *down, int ndown, const TOUCHDOWNVTX *up, int nup, int nsteps = 0, int nwheels = 3){
+            steps = std::max(0, std::min(nsteps, GEAR_CONTACT_STEPS_MAX));
+            sets.clear();
+            if (!steps) {
+                sets.emplace_back(down, down + ndown);
+                sets.emplace_back(up, up + nup);
+                return;
+            }
+            double belly = up[0].pos.y;
+            for (int i = 1; i < nup; i++) belly = std::min(belly, up[i].pos.y);
+            for (int k = 0; k < steps; k++) {
+                sets.emplace_back(down, down + ndown);
+                for (int i = 0; i < nwheels && i < ndown; i++) {
+                    double &y = sets.back()[i].pos.y;
+                    y += (belly - y)*k/steps;
+                }
+            }
+            sets.emplace_back(up, up + nup);
+        }
+
+        int Count() const { return (int)sets.size(); }
+        bool Built() const { return !sets.empty(); }
+
+        //Set for gear position `proc` (0 = down, 1 = up).
+        int Index(double proc) const {
+            if (!steps) return proc < GEAR_CONTACT_THRESHOLD ? 0 : 1;
+            return std::max(0, std::min(steps, (int)(proc*steps)));
+        }
+
+        //Whether set `i` has the wheels in it.
+        bool Wheels(int i) const { return i < Count() - 1; }
+
+        void Apply(VESSEL *v, int i) const {
+            v->SetTouchdownPoints(sets[i].data(), (DWORD)sets[i].size());
+        }
+
+    private:
+
+        int steps;
+        std::vector<std::vector<TOUCHDOWNVTX>> sets;
+};
+
+//The set a vessel has sent to Orbiter.
+class GearContact {
+
+    public:
+
+        GearContact() : current(-1) {}
+
+        //Sends the set for `proc` if it is not the one already in place. Returns true if it sent one.
+        bool Update(VESSEL *v, const TouchdownSets &sets, double proc){
+            int i = sets.Index(proc);
+            if (i == current) return false;
+            sets.Apply(v, i);
+            current = i;
+            return true;
+        }
+
+        //Makes the next Update send its set, e.g. after a scenario load.
+        void Reset(){ current = -1; }
+
+        int Current() const { return current; }
+
+    private:
+
+        int current;
+};
+
+#endif
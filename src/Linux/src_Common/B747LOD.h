@@ -0,0 +1,89 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          BOEING 747 COMMON CODE
+//
+//B747LOD.h
+//Distance levels of the airframe mesh. b747_meshgen --lods writes
+//<mesh>_lod<k>.mshb next to the airframe's compiled mesh, decimated on a
+//grid of LOD_CELL[k - 1] metres, about a pixel at LOD_DISTANCE[k - 1]
+//with a 60 degree field of view at 1080 lines. The levels keep every
+//group slot of the airframe mesh, so the animations of mesh 0 are
+//copied onto them (AnimationSet::AnimateCopies) and the livery textures
+//go to the same indices.
+//
+//The levels are added at mesh LOD_MESH_INDEX onwards, never visible,
+//and a slow system shows the one for the camera distance, switching
+//LOD_HYSTERESIS past each distance so a camera at the boundary does not
+//flip it. Without the files the airframe mesh is always drawn. The
+//distances are LOD1Distance.. in the class cfg.
+//
+//==========================================
+
+#pragma once
+
+#ifndef __B747LOD_H
+#define __B747LOD_H
+
+#include "Orbitersdk.h"
+#include "B747Mesh.h"
+#include "B747VC.h"
+
+const int LOD_LEVELS = 3;
+const float LOD_CELL[LOD_LEVELS] = {1.0f, 4.0f, 8.0f};                 //Metres
+const double LOD_DISTANCE[LOD_LEVELS] = {1000.0, 4000.0, 8000.0};      //Metres
+const double LOD_HYSTERESIS = 0.1;                                     //Fraction of the distance
+
+const UINT LOD_MESH_INDEX = 1 + VC_MESHES_MAX;     //After the airframe and the VC meshes
+
+class LODMeshes {
+
+    public:
+
+        LODMeshes() : vessel(NULL), n(0), level(0) {}
+
+        //From clbkSetClassCaps, once the airframe mesh is mesh 0. The cache must outlive the vessel.
+        void Init(VESSEL *v, MeshCache *meshes, const char *name, const double *distances = LOD_DISTANCE){
+            vessel = v;
+            level = 0;
+            for (n = 0; n < LOD_LEVELS; n++) {
+                MESHHANDLE hMesh = meshes->Load(name, n + 1);
+                if (!hMesh) break;
+                vessel->InsertMesh(hMesh, Mesh(n + 1));
+                vessel->SetMeshVisibilityMode(Mesh(n + 1), MESHVIS_NEVER);
+                distance[n] = distances[n];
+            }
+        }
+
+        //From a slow system.
+        void Update(){
+            if (!n) return;
+            VECTOR3 cam, pos;
+            oapiCameraGlobalPos(&cam);
+            vessel->GetGlobalPos(pos);
+            double d = length(cam - pos);
+            int l = level;
+            while (l < n && d > distance[l]*(1.0 + LOD_HYSTERESIS)) l++;
+            while (l > 0 && d < distance[l - 1]*(1.0 - LOD_HYSTERESIS)) l--;
+            if (l == level) return;
+            vessel->SetMeshVisibilityMode(Mesh(level), MESHVIS_NEVER);
+            vessel->SetMeshVisibilityMode(Mesh(l), MESHVIS_EXTERNAL);
+            level = l;
+        }
+
+        //Mesh index of level l, 0 for the airframe mesh itself.
+        static UINT Mesh(int l){ return l ? LOD_MESH_INDEX + l - 1 : 0; }
+
+        int Levels() const { return n; }
+        int Level() const { return level; }
+
+    private:
+
+        VESSEL *vessel;
+        int n;                          //Levels loaded
+        int level;                      //Shown
+        double distance[LOD_LEVELS];    //From the camera, where each level starts
+};
+
+#endif
@@ -0,0 +1,139 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          BOEING 747 COMMON CODE
+//
+//B747Lights.h
+//Landing, cockpit flood and cabin lights. Each module lists its
+//emitters in a table of LightSpec; they are created once, inactive, and
+//the switches only activate or deactivate them, a group at a time.
+//The ones that only light the cockpit and cabin meshes are created with
+//those meshes and deleted with them, see B747VC.h; their groups keep
+//their switch position meanwhile.
+//
+//==========================================
+
+#pragma once
+
+#ifndef __B747LIGHTS_H
+#define __B747LIGHTS_H
+
+#include <algorithm>
+#include "Orbitersdk.h"
+
+enum LightGroup{LIGHTS_LANDING, LIGHTS_COCKPIT, LIGHTS_CABIN, LIGHT_GROUP_COUNT};
+
+struct LightGroupSpec {
+    bool spot;                        //Spot lights pointing forward, otherwise point lights
+    double range, att0, att1, att2;
+    double umbra, penumbra;           //Spot lights only
+    COLOUR4 diffuse, specular, ambient;
+    bool cockpit_only;                //Only lights the cockpit and cabin meshes
+};
+
+//What LightsControl used to create.
+const LightGroupSpec LIGHT_GROUPS[LIGHT_GROUP_COUNT] = {
+    {true, 100000, 1e-3, 0, 2e-3, 25*RAD, 45*RAD, {0.9, 0.8, 1, 0}, {1.9, 0.8, 1, 0}, {0, 0, 0, 0}, false},
+    {false, 1, 0.15, 0, 0.15, 0, 0, {1, 0.508, 0.100, 0}, {1, 0.508, 0.100, 0}, {1, 0.508, 0.100, 0}, true},
+    {false, 1, 0.5, 0, 0.5, 0, 0, {1, 1, 1, 0}, {1, 1, 1, 0}, {1, 1, 1, 0}, true},
+};
+
+struct LightSpec {
+    LightGroup group;
+    VECTOR3 pos;
+};
+
+const int LIGHTS_MAX = 24;
+
+class LightGroups {
+
+    public:
+
+        LightGroups() : spec(NULL), groups(NULL), n(0), emitter{}, on{} {}
+
+        //Call from clbkSetClassCaps; creates the emitters that light the
+        //outside. The tables must outlive the vessel. `groups` replaces
+        //LIGHT_GROUPS for a class with other parameters.
+        void Create(VESSEL *v, const LightSpec *specs, int count, const LightGroupSpec *lgroups = LIGHT_GROUPS){
+            spec = specs;
+            groups = lgroups;
+            n = std::min(count, LIGHTS_MAX);
+            for(int i = 0; i < n; i++)
+                if(!groups[spec[i].group].cockpit_only) Add(v, i);
+        }
+
+        //With the cockpit and cabin meshes: creates or deletes the emitters that only light them.
+        void CreateCockpit(VESSEL *v){
+            for(int i = 0; i < n; i++)
+                if(groups[spec[i].group].cockpit_only && !emitter[i]) Add(v, i);
+        }
+
+        void DeleteCockpit(VESSEL *v){
+            for(int i = 0; i < n; i++)
+                if(groups[spec[i].group].cockpit_only && emitter[i]){
+                    v->DelLightEmitter(emitter[i]);
+                    emitter[i] = NULL;
+                }
+        }
+
+        void Set(LightGroup g, bool active){
+            if(!Has(g) || on[g] == active) return;
+            on[g] = active;
+            for(int i = 0; i < n; i++)
+                if(spec[i].group == g && emitter[i]) emitter[i]->Activate(active);
+        }
+
+        void Toggle(LightGroup g){ Set(g, !on[g]); }
+
+        bool IsOn(LightGroup g) const { return on[g]; }
+
+        bool AnyOn() const {
+            for(int g = 0; g < LIGHT_GROUP_COUNT; g++)
+                if(on[g]) return true;
+            return false;
+        }
+
+        void SetAll(bool active){
+            for(int g = 0; g < LIGHT_GROUP_COUNT; g++) Set((LightGroup)g, active);
+        }
+
+        //Scenario value of the LIGHTS line: bit g set when group g is on.
+        int GetMask() const {
+            int mask = 0;
+            for(int g = 0; g < LIGHT_GROUP_COUNT; g++)
+                if(on[g]) mask |= 1 << g;
+            return mask;
+        }
+
+        void SetMask(int mask){
+            for(int g = 0; g < LIGHT_GROUP_COUNT; g++) Set((LightGroup)g, (mask >> g) & 1);
+        }
+
+    private:
+
+        bool Has(LightGroup g) const {
+            for(int i = 0; i < n; i++)
+                if(spec[i].group == g) return true;
+            return false;
+        }
+
+        void Add(VESSEL *v, int i){
+            const LightGroupSpec &g = groups[spec[i].group];
+            if(g.spot){
+                emitter[i] = v->AddSpotLight(spec[i].pos, _V(0, 0, 1), g.range, g.att0, g.att1, g.att2, g.umbra, g.penumbra, g.diffuse, g.specular, g.ambient);
+            } else {
+                emitter[i] = v->AddPointLight(spec[i].pos, g.range, g.att0, g.att1, g.att2, g.diffuse, g.specular, g.ambient);
+            }
+            if(g.cockpit_only) emitter[i]->SetVisibility(LightEmitter::VIS_COCKPIT);
+            emitter[i]->Activate(on[spec[i].group]);
+        }
+
+        const LightSpec *spec;
+        const LightGroupSpec *groups;
+        int n;
+        LightEmitter *emitter[LIGHTS_MAX];  //NULL for a cockpit light while the cockpit is not loaded
+        bool on[LIGHT_GROUP_COUNT];
+};
+
+#endif
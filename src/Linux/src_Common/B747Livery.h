@@ -0,0 +1,278 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          BOEING 747 COMMON CODE
+//
+//B747Livery.h
+//Module-wide livery texture cache. Every vessel of a class showing the
+//same skin shares one set of textures; a vessel holds a reference to
+//its current livery and drops it when it changes skin or loses its
+//visual. Unreferenced liveries stay loaded, so cycling back to a skin
+//costs nothing, until the cache is over its budget: then they are
+//released oldest first.
+//
+//LiveryIndex lists the skins a class can show. The skin directory is
+//scanned once from InitModule, so changing skin reads no list file.
+//
+//LiveryPrefetcher reads the liveries a vessel is likely to show next on
+//a worker thread, so their files are in the OS cache when the
+//simulation thread loads them.
+//
+//==========================================
+
+#pragma once
+
+#ifndef __B747LIVERY_H
+#define __B747LIVERY_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <dirent.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <sys/stat.h>
+#include "Orbitersdk.h"
+
+const int LIVERY_TEXTURES = 5;
+
+//Texture files of a skin, in the order the modules apply them.
+const char *const LIVERY_TEXTURE_FILES[LIVERY_TEXTURES] = {
+    "Fuselage.dds", "Vertical_stabilizer.dds", "Right_wing.dds", "Left_wing.dds", "ENG1.dds"
+};
+
+//Path of a file below Textures, as the file system sees it from the Orbiter root.
+inline std::string LiveryFilePath(std::string path){
+    for (char &c : path)
+        if (c == '\\') c = '/';
+    return "Textures/" + path;
+}
+
+const size_t LIVERY_CACHE_BUDGET = 64u << 20;  //Default, bytes. Override with LiveryCacheMB in the class cfg.
+
+class LiveryCache {
+
+    public:
+
+        struct Livery {
+            std::string name;
+            SURFHANDLE tex[LIVERY_TEXTURES];
+            size_t bytes;
+            int refs;
+            uint64_t last_used;
+        };
+
+        LiveryCache() : budget(LIVERY_CACHE_BUDGET), bytes(0), clock(0) {}
+
+        void SetBudget(size_t b){
+            budget = b;
+            Trim();
+        }
+
+        //Returns skin `name` (a directory under `skindir`, which is relative
+        //to Textures and ends with a backslash), loading it on first use,
+        //and takes a reference to it.
+        Livery *Acquire(const char *skindir, const char *name){
+            std::string key = std::string(skindir) + name;
+            Livery *l = NULL;
+            for (auto &e : entries)
+                if (e->name == key) l = e.get();
+
+            if (!l) {
+                l = new Livery;
+                l->name = key;
+                l->bytes = 0;
+                l->refs = 0;
+                for (int i = 0; i < LIVERY_TEXTURES; i++) {
+                    std::string path = key + "\\" + LIVERY_TEXTURE_FILES[i];
+                    l->tex[i] = oapiLoadTexture(path.c_str());
+                    if (l->tex[i]) l->bytes += FileSize(path);
+                }
+                entries.emplace_back(l);
+                bytes += l->bytes;
+            }
+            l->refs++;
+            l->last_used = ++clock;
+            Trim();
+            return l;
+        }
+
+        void Release(Livery *l){
+            if (!l) return;
+            l->refs--;
+            Trim();
+        }
+
+        //Releases every texture. From ExitModule, once no vessel is left.
+        void Clear(){
+            for (auto &e : entries) Unload(*e);
+            entries.clear();
+            bytes = 0;
+        }
+
+        size_t Bytes() const { return bytes; }
+
+    private:
+
+        //Textures are not resident until the graphics client uploads them,
+        //so the footprint is taken from the .dds sizes.
+        static size_t FileSize(const std::string &path){
+            struct stat st;
+            return stat(LiveryFilePath(path).c_str(), &st) == 0 ? (size_t)st.st_size : 0;
+        }
+
+        static void Unload(Livery &l){
+            for (int i = 0; i < LIVERY_TEXTURES; i++)
+                if (l.tex[i]) oapiReleaseTexture(l.tex[i]);
+        }
+
+        //Drops unreferenced liveries, least recently used first, while over budget.
+        void Trim(){
+            while (bytes > budget) {
+                auto lru = entries.end();
+                for (auto it = entries.begin(); it != entries.end(); ++it)
+                    if ((*it)->refs == 0 && (lru == entries.end() || (*it)->last_used < (*lru)->last_used))
+                        lru = it;
+                if (lru == entries.end()) break;
+                Unload(**lru);
+                bytes -= (*lru)->bytes;
+                entries.erase(lru);
+            }
+        }
+
+        size_t budget;
+        size_t bytes;
+        uint64_t clock;
+        std::vector<std::unique_ptr<Livery>> entries;
+};
+
+class LiveryIndex {
+
+    public:
+
+        //Lists the directories under `skindir` (relative to Textures, ending
+        //with a backslash) holding any of LIVERY_TEXTURE_FILES, sorted by name.
+        //A livery missing some of them keeps the mesh textures for those parts.
+        int Scan(const char *skindir){
+            names.clear();
+            index.clear();
+            int incomplete = 0;
+            std::string dir = LiveryFilePath(skindir);
+            if (DIR *d = opendir(dir.c_str())) {
+                while (dirent *e = readdir(d)) {
+                    if (e->d_name[0] == '.') continue;
+                    int found = 0;
+                    for (int i = 0; i < LIVERY_TEXTURES; i++) {
+                        struct stat st;
+                        std::string path = dir + e->d_name + "/" + LIVERY_TEXTURE_FILES[i];
+                        if (stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode)) found++;
+                    }
+                    if (!found) continue;
+                    if (found < LIVERY_TEXTURES) incomplete++;
+                    names.push_back(e->d_name);
+                }
+                closedir(d);
+            }
+            std::sort(names.begin(), names.end());
+            for (int i = 0; i < Count(); i++) index[names[i]] = i;
+            oapiWriteLogV("%s: %d liveries, %d of them without some of the textures", dir.c_str(), Count(), incomplete);
+            return Count();
+        }
+
+        int Count() const { return (int)names.size(); }
+
+        const char *Name(int i) const { return names[i].c_str(); }
+
+        //Position of livery `name`, -1 if the class has no such livery.
+        int Find(const char *name) const {
+            auto it = index.find(name);
+            return it == index.end() ? -1 : it->second;
+        }
+
+        //Both wrap around. From -1 (no livery shown) Next gives the first and Prev the last.
+        int Next(int i) const { return names.empty() ? -1 : (i + 1) % Count(); }
+        int Prev(int i) const { return names.empty() ? -1 : (i <= 0 ? Count() - 1 : i - 1); }
+
+    private:
+
+        std::vector<std::string> names;
+        std::unordered_map<std::string, int> index;
+};
+
+//oapiLoadTexture takes a file name and decodes on the calling thread,
+//and the graphics client owns the result, so the decode has to stay on
+//the simulation thread. What moves to the worker is the disk read.
+class LiveryPrefetcher {
+
+    public:
+
+        LiveryPrefetcher() : stopping(false) {}
+
+        ~LiveryPrefetcher(){ Stop(); }
+
+        //Queues the files of skin `name` under `skindir`. Each livery is read once per module load.
+        void Request(const char *skindir, const char *name){
+            std::string dir = LiveryFilePath(std::string(skindir) + name);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping || !requested.insert(dir).second) return;
+            queue.push_back(dir);
+            if (!worker.joinable()) worker = std::thread(&LiveryPrefetcher::Run, this);
+            wake.notify_one();
+        }
+
+        //The liveries NextSkin and a previous-skin step would show from livery `i`.
+        void RequestNeighbours(const LiveryIndex &skins, const char *skindir, int i){
+            if (!skins.Count()) return;
+            Request(skindir, skins.Name(skins.Next(i)));
+            Request(skindir, skins.Name(skins.Prev(i)));
+        }
+
+        //From ExitModule: the worker must be gone before the module is unloaded.
+        void Stop(){
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+                queue.clear();
+            }
+            wake.notify_one();
+            if (worker.joinable()) worker.join();
+        }
+
+    private:
+
+        void Run(){
+            std::vector<char> buf(1 << 20);
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                wake.wait(lock, [this]{ return stopping || !queue.empty(); });
+                if (stopping) return;
+                std::string dir = queue.front();
+                queue.pop_front();
+                lock.unlock();
+                for (int i = 0; i < LIVERY_TEXTURES; i++) {
+                    FILE *f = fopen((dir + "/" + LIVERY_TEXTURE_FILES[i]).c_str(), "rb");
+                    if (!f) continue;
+                    while (fread(buf.data(), 1, buf.size(), f) == buf.size()) {}
+                    fclose(f);
+                }
+                lock.lock();
+            }
+        }
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::deque<std::string> queue;
+        std::unordered_set<std::string> requested;
+        bool stopping;
+        std::thread worker;
+};
+
+#endif
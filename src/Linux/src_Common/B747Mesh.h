@@ -0,0 +1,331 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          BOEING 747 COMMON CODE
+//
+//B747Mesh.h
+//Compiled meshes. Meshes/Boeing747 holds each mesh as MSHX1 text
+//(<mesh>.msh) and the binary file b747_meshgen compiles from it
+//(<mesh>.mshb). The text is 620-750 KB of ASCII numbers per airframe
+//that Orbiter tokenizes on every scenario load; the binary file is
+//mapped into memory and its groups handed to oapiAddMeshGroup with no
+//parsing, only a fixed size decode per vertex.
+//
+//A module loads its meshes through its MeshCache. The cache builds each
+//mesh once from its binary file and keeps it until ExitModule; if the
+//binary file is missing, of another format version or was compiled
+//from another revision of the text source, the cache falls back to
+//oapiLoadMeshGlobal and the text source. The distance levels of a mesh
+//(B747LOD.h) exist only compiled, so without them the cache gives NULL.
+//
+//Orbiter's oapiSetTexture only replaces the texture slots a mesh was
+//loaded with, so the groups are added to a template rather than to a
+//mesh from oapiCreateMesh. b747_meshgen writes <mesh>_materials.msh with
+//the materials and textures of the source and no groups; oapiLoadMesh
+//loads it with its textures, as for any mesh file, and the distance
+//levels use the template of their mesh.
+//
+//Binary file layout: MeshFileHeader, then ngroups MeshGroupRecord,
+//nmaterials MeshMaterialRecord, ntextures texture names of
+//MESH_TEXTURE_NAME_LEN bytes, nvertices MeshVertexRecord and nindices
+//uint16_t indices, zero padded to a multiple of 8 bytes.
+//
+//Positions stay single floats. Normals are octahedron encoded into two
+//16 bit integers (under 0.05 deg of error), with MESH_NO_NORMAL for the
+//vertices the text gives none; texture coordinates are 16 bit fractions
+//of the group's coordinate range, and indices are 16 bit, relative to
+//the group's first vertex.
+//
+//==========================================
+
+#pragma once
+
+#ifndef __B747MESH_H
+#define __B747MESH_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Orbitersdk.h"
+
+const char MESH_FILE_MAGIC[8] = {'B', '7', '4', '7', 'M', 'S', 'H', 'B'};
+const uint32_t MESH_FILE_VERSION = 1;
+const int MESH_TEXTURE_NAME_LEN = 64;
+
+struct MeshFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t ngroups, nmaterials, ntextures;
+    uint32_t nvertices, nindices;
+    uint64_t source_size;   //Bytes of the text source it was compiled from
+    int64_t source_mtime;   //and its modification time, seconds
+    uint64_t size;          //Whole file in bytes
+};
+
+struct MeshGroupRecord {
+    uint32_t first_vertex, nvertices;
+    uint32_t first_index, nindices;
+    uint32_t material, texture;     //As in the text source: 1 for the first, 0 for none
+    uint32_t flag;                  //FLAG line, handed on as the group's UsrFlag
+    uint16_t zbias, pad;
+    float uv_min[2], uv_scale[2];   //uv = uv_min + q*uv_scale
+};
+
+struct MeshMaterialRecord {
+    float diffuse[4], ambient[4], specular[4], emissive[4];
+    float power;
+};
+
+struct MeshVertexRecord {
+    float pos[3];
+    int16_t normal[2];      //Octahedron encoded
+    uint16_t uv[2];
+};
+
+static_assert(sizeof(MeshFileHeader) == 56 && sizeof(MeshGroupRecord) == 48 &&
+    sizeof(MeshMaterialRecord) == 68 && sizeof(MeshVertexRecord) == 20, "mesh file layout");
+
+const int16_t MESH_NO_NORMAL = -32768;   //Outside what OctEncode gives a normal
+
+inline void OctEncode(const float n[3], int16_t q[2]){
+    float s = std::fabs(n[0]) + std::fabs(n[1]) + std::fabs(n[2]);
+    if (s == 0.0f) {
+        q[0] = q[1] = MESH_NO_NORMAL;
+        return;
+    }
+    float x = n[0]/s, y = n[1]/s;
+    if (n[2] < 0.0f) {
+        float ox = x;
+        x = (1.0f - std::fabs(y))*(ox >= 0.0f ? 1.0f : -1.0f);
+        y = (1.0f - std::fabs(ox))*(y >= 0.0f ? 1.0f : -1.0f);
+    }
+    q[0] = (int16_t)std::lround(std::min(std::max(x, -1.0f), 1.0f)*32767.0f);
+    q[1] = (int16_t)std::lround(std::min(std::max(y, -1.0f), 1.0f)*32767.0f);
+}
+
+inline void OctDecode(const int16_t q[2], float *nx, float *ny, float *nz){
+    if (q[0] == MESH_NO_NORMAL) {
+        *nx = *ny = *nz = 0.0f;
+        return;
+    }
+    float x = q[0]*(1.0f/32767.0f), y = q[1]*(1.0f/32767.0f);
+    float z = 1.0f - std::fabs(x) - std::fabs(y);
+    if (z < 0.0f) {
+        float ox = x;
+        x = (1.0f - std::fabs(y))*(ox >= 0.0f ? 1.0f : -1.0f);
+        y = (1.0f - std::fabs(ox))*(y >= 0.0f ? 1.0f : -1.0f);
+    }
+    float r = 1.0f/std::sqrt(x*x + y*y + z*z);
+    *nx = x*r;
+    *ny = y*r;
+    *nz = z*r;
+}
+
+//One binary mesh file, mapped read only.
+class CompiledMesh {
+
+    public:
+
+        CompiledMesh() : base(NULL), len(0) {}
+        ~CompiledMesh(){ Close(); }
+
+        CompiledMesh(const CompiledMesh &) = delete;
+        CompiledMesh &operator=(const CompiledMesh &) = delete;
+
+        //Returns NULL on success, otherwise why the file was rejected. With
+        //a source, the file must have been compiled from it as it is now.
+        const char *Open(const char *fname, const char *source = NULL){
+            Close();
+            int fd = open(fname, O_RDONLY);
+            if (fd < 0) return "not found";
+            struct stat st;
+            void *p = MAP_FAILED;
+            if (fstat(fd, &st) == 0 && st.st_size > 0)
+                p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (p == MAP_FAILED) return "cannot be mapped";
+            base = (const uint8_t *)p;
+            len = st.st_size;
+
+            const char *err = Validate(base, len);
+            struct stat src;
+            if (!err && source && stat(source, &src) == 0 &&
+                ((uint64_t)src.st_size != Header().source_size || (int64_t)src.st_mtime != Header().source_mtime))
+                err = "is older than its source";
+            if (err) Close();
+            return err;
+        }
+
+        void Close(){
+            if (base) munmap((void *)base, len);
+            base = NULL;
+            len = 0;
+        }
+
+        const MeshFileHeader &Header() const { return *(const MeshFileHeader *)base; }
+        const MeshGroupRecord &Group(int i) const { return ((const MeshGroupRecord *)(base + sizeof(MeshFileHeader)))[i]; }
+        const MeshMaterialRecord &Material(int i) const { return Materials()[i]; }
+        const char *Texture(int i) const { return Textures() + i*MESH_TEXTURE_NAME_LEN; }
+        size_t Size() const { return len; }
+
+        //Group i into its own vertex and index arrays.
+        void Decode(int i, NTVERTEX *vtx, WORD *idx) const {
+            const MeshGroupRecord &g = Group(i);
+            const MeshVertexRecord *v = Vertices() + g.first_vertex;
+            for (uint32_t k = 0; k < g.nvertices; k++, v++, vtx++) {
+                vtx->x = v->pos[0];
+                vtx->y = v->pos[1];
+                vtx->z = v->pos[2];
+                OctDecode(v->normal, &vtx->nx, &vtx->ny, &vtx->nz);
+                vtx->tu = g.uv_min[0] + v->uv[0]*g.uv_scale[0];
+                vtx->tv = g.uv_min[1] + v->uv[1]*g.uv_scale[1];
+            }
+            memcpy(idx, Indices() + g.first_index, g.nindices*sizeof(WORD));
+        }
+
+        //Builds the mesh onto the template tmpl, the name oapiLoadMesh takes.
+        //Returns NULL on success, otherwise why no mesh was built.
+        const char *Create(const char *tmpl, MESHHANDLE &hMesh) const {
+            const MeshFileHeader &h = Header();
+            hMesh = oapiLoadMesh(tmpl);
+            if (!hMesh) return "has no template";
+            if (oapiMeshGroupCount(hMesh) || oapiMeshMaterialCount(hMesh) != h.nmaterials) {
+                oapiDeleteMesh(hMesh);
+                hMesh = NULL;
+                return "does not match its template";
+            }
+            for (uint32_t i = 0; i < h.ngroups; i++) {
+                const MeshGroupRecord &g = Group(i);
+                MESHGROUP mg;
+                memset(&mg, 0, sizeof(mg));
+                //The mesh keeps the arrays and frees them with delete[].
+                mg.Vtx = new NTVERTEX[g.nvertices];
+                mg.Idx = new WORD[g.nindices];
+                mg.nVtx = g.nvertices;
+                mg.nIdx = g.nindices;
+                mg.MtrlIdx = g.material ? g.material - 1 : SPEC_DEFAULT;
+                mg.TexIdx = g.texture ? g.texture - 1 : SPEC_DEFAULT;
+                mg.UsrFlag = g.flag;
+                mg.zBias = g.zbias;
+                Decode(i, mg.Vtx, mg.Idx);
+                oapiAddMeshGroup(hMesh, &mg);
+            }
+            return NULL;
+        }
+
+        static const char *Validate(const uint8_t *p, size_t size){
+            if (size < sizeof(MeshFileHeader)) return "has a bad size";
+            const MeshFileHeader *h = (const MeshFileHeader *)p;
+            if (memcmp(h->magic, MESH_FILE_MAGIC, sizeof(h->magic))) return "is not a compiled mesh";
+            if (h->version != MESH_FILE_VERSION) return "has a stale format version";
+            uint64_t body = Offset(*h, 5);
+            if (h->size != size || body > size || size - body >= 8) return "has a bad size";
+            const MeshGroupRecord *g = (const MeshGroupRecord *)(p + sizeof(MeshFileHeader));
+            for (uint32_t i = 0; i < h->ngroups; i++) {
+                if ((uint64_t)g[i].first_vertex + g[i].nvertices > h->nvertices ||
+                    (uint64_t)g[i].first_index + g[i].nindices > h->nindices ||
+                    g[i].material > h->nmaterials || g[i].texture > h->ntextures) return "has a group out of range";
+                const uint16_t *idx = (const uint16_t *)(p + Offset(*h, 4)) + g[i].first_index;
+                for (uint32_t k = 0; k < g[i].nindices; k++)
+                    if (idx[k] >= g[i].nvertices) return "has an index out of range";
+            }
+            const char *tex = (const char *)(p + Offset(*h, 2));
+            for (uint32_t i = 0; i < h->ntextures; i++)
+                if (!memchr(tex + i*MESH_TEXTURE_NAME_LEN, 0, MESH_TEXTURE_NAME_LEN)) return "has a bad texture name";
+            return NULL;
+        }
+
+        //Where section s starts: 0 groups, 1 materials, 2 textures, 3 vertices,
+        //4 indices, 5 the end of the data.
+        static uint64_t Offset(const MeshFileHeader &h, int s){
+            const uint64_t sizes[5] = {
+                (uint64_t)h.ngroups*sizeof(MeshGroupRecord), (uint64_t)h.nmaterials*sizeof(MeshMaterialRecord),
+                (uint64_t)h.ntextures*MESH_TEXTURE_NAME_LEN, (uint64_t)h.nvertices*sizeof(MeshVertexRecord),
+                (uint64_t)h.nindices*sizeof(uint16_t),
+            };
+            uint64_t o = sizeof(MeshFileHeader);
+            for (int i = 0; i < s; i++) o += sizes[i];
+            return o;
+        }
+
+    private:
+
+        const MeshMaterialRecord *Materials() const { return (const MeshMaterialRecord *)(base + Offset(Header(), 1)); }
+        const char *Textures() const { return (const char *)(base + Offset(Header(), 2)); }
+        const MeshVertexRecord *Vertices() const { return (const MeshVertexRecord *)(base + Offset(Header(), 3)); }
+        const uint16_t *Indices() const { return (const uint16_t *)(base + Offset(Header(), 4)); }
+
+        const uint8_t *base;
+        size_t len;
+};
+
+//The meshes of one module, by the name oapiLoadMeshGlobal would take.
+class MeshCache {
+
+    public:
+
+        //Meshes/<name>.<ext>, as the file system sees it from the Orbiter root.
+        static std::string FileName(const char *name, const char *ext){
+            std::string path = std::string("Meshes/") + name + "." + ext;
+            std::replace(path.begin(), path.end(), '\\', '/');
+            return path;
+        }
+
+        //The template a mesh and its distance levels are built onto.
+        static std::string TemplateName(const char *name){ return std::string(name) + "_materials"; }
+
+        //From clbkSetClassCaps or clbkLoadVC, the mesh or its distance level
+        //lod. The mesh stays until Clear.
+        MESHHANDLE Load(const char *name, int lod = 0){
+            for (const Entry &e : entries)
+                if (e.name == name && e.lod == lod) return e.mesh;
+            Entry e;
+            e.name = name;
+            e.lod = lod;
+            std::string fname = FileName(name, "mshb"), src = FileName(name, "msh");
+            if (lod) fname = FileName((std::string(name) + "_lod" + std::to_string(lod)).c_str(), "mshb");
+            CompiledMesh cm;
+            const char *err = cm.Open(fname.c_str(), src.c_str());
+            if (!err) err = cm.Create(TemplateName(name).c_str(), e.mesh);
+            if (!err) {
+                e.owned = true;
+                oapiWriteLogV("%s: %u groups read from %s", name, cm.Header().ngroups, fname.c_str());
+            } else if (lod) {
+                oapiWriteLogV("%s: %s %s, no distance level %d", name, fname.c_str(), err, lod);
+            } else {
+                oapiWriteLogV("%s: %s %s, loading %s", name, fname.c_str(), err, src.c_str());
+                e.mesh = oapiLoadMeshGlobal(name);
+            }
+            entries.push_back(std::move(e));
+            return entries.back().mesh;
+        }
+
+        //Call from ExitModule, once no vessel is left.
+        void Clear(){
+            for (Entry &e : entries)
+                if (e.owned) oapiDeleteMesh(e.mesh);
+            entries.clear();
+        }
+
+    private:
+
+        struct Entry {
+            std::string name;
+            int lod = 0;
+            MESHHANDLE mesh = NULL;
+            bool owned = false;     //Built here rather than loaded by Orbiter
+        };
+
+        std::vector<Entry> entries;
+};
+
+#endif
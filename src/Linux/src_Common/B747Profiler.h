@@ -0,0 +1,187 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          BOEING 747 COMMON CODE
+//
+//B747Profiler.h
+//Opt-in wall time profiler for the vessel callbacks. Build with
+//B747_PROFILE defined (cmake -DB747_PROFILE=ON) to enable it; without
+//it every B747_PROFILE_* macro expands to nothing.
+//
+//Each module records into its own lock-free histograms and writes
+//min/mean/p99/max per callback to Orbiter.log and to B747_profile.csv
+//(in the Orbiter root) from ExitModule.
+//
+//==========================================
+
+#pragma once
+
+#ifndef __B747PROFILER_H
+#define __B747PROFILER_H
+
+#ifdef B747_PROFILE
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include "Orbitersdk.h"
+
+namespace b747 {
+
+enum ProfiledCallback {
+    PROF_PRESTEP,
+    PROF_POSTSTEP,
+    PROF_CONSUMEKEY,
+    PROF_LOADVC,
+    PROF_VISUALCREATED,
+    PROF_CHANGELIVERY,
+    PROF_COUNT
+};
+
+inline const char *ProfiledCallbackName(int cb){
+    static const char *names[PROF_COUNT] = {
+        "clbkPreStep", "clbkPostStep", "clbkConsumeBufferedKey",
+        "clbkLoadVC", "clbkVisualCreated", "ChangeLivery"
+    };
+    return names[cb];
+}
+
+//Log-linear histogram of nanosecond durations: 8 sub-buckets per power
+//of two, so any percentile is within 12.5% of the recorded value.
+//Recording is a handful of relaxed atomic adds, safe from any thread.
+class CallbackHistogram {
+
+    public:
+
+        static const int SUB_BITS = 3;
+        static const int SUB_BUCKETS = 1 << SUB_BITS;
+        static const int NBUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+        CallbackHistogram() : count(0), total_ns(0), min_ns(UINT64_MAX), max_ns(0) {
+            for (auto &b : buckets) b.store(0, std::memory_order_relaxed);
+        }
+
+        void Record(uint64_t ns){
+            buckets[Bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+            count.fetch_add(1, std::memory_order_relaxed);
+            total_ns.fetch_add(ns, std::memory_order_relaxed);
+
+            uint64_t cur = min_ns.load(std::memory_order_relaxed);
+            while (ns < cur && !min_ns.compare_exchange_weak(cur, ns, std::memory_order_relaxed));
+            cur = max_ns.load(std::memory_order_relaxed);
+            while (ns > cur && !max_ns.compare_exchange_weak(cur, ns, std::memory_order_relaxed));
+        }
+
+        uint64_t Count() const { return count.load(std::memory_order_relaxed); }
+        uint64_t Min() const { return Count() ? min_ns.load(std::memory_order_relaxed) : 0; }
+        uint64_t Max() const { return max_ns.load(std::memory_order_relaxed); }
+        double Mean() const { return Count() ? (double)total_ns.load(std::memory_order_relaxed) / Count() : 0.0; }
+
+        //Upper bound of the bucket holding the p-th percentile, clamped to the max seen.
+        uint64_t Percentile(double p) const {
+            uint64_t n = Count();
+            if (!n) return 0;
+            uint64_t rank = (uint64_t)(p * (n - 1)) + 1, seen = 0;
+            for (int i = 0; i < NBUCKETS; i++) {
+                seen += buckets[i].load(std::memory_order_relaxed);
+                if (seen >= rank) return std::min(BucketTop(i), Max());
+            }
+            return Max();
+        }
+
+    private:
+
+        static int Bucket(uint64_t ns){
+            if (ns < SUB_BUCKETS) return (int)ns;
+            int msb = 63 - __builtin_clzll(ns);
+            int sub = (int)(ns >> (msb - SUB_BITS)) & (SUB_BUCKETS - 1);
+            return (msb - SUB_BITS + 1) * SUB_BUCKETS + sub;
+        }
+
+        static uint64_t BucketTop(int i){
+            if (i < SUB_BUCKETS) return (uint64_t)i;
+            int msb = i / SUB_BUCKETS + SUB_BITS - 1;
+            uint64_t base = (uint64_t)(SUB_BUCKETS + i % SUB_BUCKETS) << (msb - SUB_BITS);
+            return base + ((uint64_t)1 << (msb - SUB_BITS)) - 1;
+        }
+
+        std::atomic<uint64_t> buckets[NBUCKETS];
+        std::atomic<uint64_t> count, total_ns, min_ns, max_ns;
+};
+
+class ModuleProfiler {
+
+    public:
+
+        CallbackHistogram &operator[] (int cb){ return hist[cb]; }
+
+        //Writes one line per callback that ran at least once.
+        void Dump(const char *module){
+            FILE *csv = fopen("B747_profile.csv", "a");
+            if (csv && ftell(csv) == 0)
+                fprintf(csv, "module,callback,calls,min_us,mean_us,p99_us,max_us\n");
+
+            for (int i = 0; i < PROF_COUNT; i++) {
+                const CallbackHistogram &h = hist[i];
+                if (!h.Count()) continue;
+                double min = h.Min() * 1e-3, mean = h.Mean() * 1e-3, p99 = h.Percentile(0.99) * 1e-3, max = h.Max() * 1e-3;
+                oapiWriteLogV("%s profile: %-24s calls %8llu  min %9.3f us  mean %9.3f us  p99 %9.3f us  max %9.3f us",
+                    module, ProfiledCallbackName(i), (unsigned long long)h.Count(), min, mean, p99, max);
+                if (csv)
+                    fprintf(csv, "%s,%s,%llu,%.3f,%.3f,%.3f,%.3f\n",
+                        module, ProfiledCallbackName(i), (unsigned long long)h.Count(), min, mean, p99, max);
+            }
+            if (csv) fclose(csv);
+        }
+
+    private:
+
+        CallbackHistogram hist[PROF_COUNT];
+};
+
+//One profiler per module: internal linkage keeps the .so files apart,
+//even when the loader shares weak symbols between modules.
+namespace {
+
+inline ModuleProfiler &Profiler(){
+    static ModuleProfiler profiler;
+    return profiler;
+}
+
+class ProfileScope {
+
+    public:
+
+        explicit ProfileScope(int _cb) : cb(_cb), t0(std::chrono::steady_clock::now()) {}
+
+        ~ProfileScope(){
+            auto dt = std::chrono::steady_clock::now() - t0;
+            Profiler()[cb].Record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(dt).count());
+        }
+
+    private:
+
+        int cb;
+        std::chrono::steady_clock::time_point t0;
+};
+
+}
+
+}
+
+#define B747_PROFILE_CAT2(a, b) a##b
+#define B747_PROFILE_CAT(a, b) B747_PROFILE_CAT2(a, b)
+#define B747_PROFILE_SCOPE(cb) b747::ProfileScope B747_PROFILE_CAT(b747_profile_scope_, __LINE__)(b747::cb)
+#define B747_PROFILE_DUMP(module) b747::Profiler().Dump(module)
+
+#else
+
+#define B747_PROFILE_SCOPE(cb) ((void)0)
+#define B747_PROFILE_DUMP(module) ((void)0)
+
+#endif
+
+#endif
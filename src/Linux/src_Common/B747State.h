@@ -0,0 +1,33 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          BOEING 747 COMMON CODE
+//
+//B747State.h
+//Per-vessel state shared by the 747 variants. The switches used to be
+//module globals, so every vessel of a class shared them; the positions
+//are the values clbkPreStep/clbkPostStep touch on every step. Packed
+//into one cache line, a fleet step reads one line per vessel for them.
+//
+//==========================================
+
+#pragma once
+
+#ifndef __B747STATE_H
+#define __B747STATE_H
+
+struct alignas(64) B747State {
+    double engines_proc = 0.0;        //Fan rotation animation state
+    double pwr = 0.0;                 //Main thruster group level
+    double lvlcontrailengines = 0.0;  //Engine contrail level
+
+    int current_skin = -1;            //Livery shown, as a position in the module's LiveryIndex
+
+    bool parking_brake = false;
+    bool gear_down = false;           //Gear at rest down, kept by the gear's Detent hook
+};
+
+static_assert(sizeof(B747State) == 64, "B747State must fit one cache line");
+
+#endif
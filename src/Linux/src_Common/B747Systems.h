@@ -0,0 +1,99 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          BOEING 747 COMMON CODE
+//
+//B747Systems.h
+//Runs the vessel's systems at their own rates instead of every frame.
+//Each kind is described by a traits struct, and a vessel keeps them all
+//in one Systems array, the way B747Deploy.h keeps the moving parts.
+//
+//A traits struct for an owner class V gives:
+//
+//  static constexpr double RATE;                 runs per second, SYSTEM_EVERY_FRAME for every frame
+//  static unsigned int Fields(const V &);        FlightField bits Run reads, see B747Flight.h
+//  static void Run(V &, double dt, const FlightState &);
+//
+//A fixed rate system runs in steps of exactly 1/RATE seconds, as many
+//as the frame's simdt holds, so it does the same work whatever the
+//frame rate. When time acceleration would need more than
+//SYSTEM_SUBSTEPS_MAX of them in a frame, the first run takes the excess
+//in one longer step and the rest keep the fixed one.
+//
+//Every vessel of a class starts its fixed rate systems at a different
+//point of their period, spread by the golden ratio, so a fleet does
+//not run its 1 Hz work all on the same frame.
+//
+//==========================================
+
+#pragma once
+
+#ifndef __B747SYSTEMS_H
+#define __B747SYSTEMS_H
+
+#include <cmath>
+#include "Orbitersdk.h"
+#include "B747Flight.h"
+
+constexpr double SYSTEM_EVERY_FRAME = 0.0;
+
+const int SYSTEM_SUBSTEPS_MAX = 8;  //Fixed steps a system runs in one frame, at most
+
+template<class V, int N> class Systems {
+
+    public:
+
+        Systems() : phase(std::fmod(instances++*0.6180339887498949, 1.0)), period{}, acc{}, run{}, fields{} {}
+
+        //Call from the constructor for every id below N.
+        template<class Traits> void Add(int i){
+            period[i] = Traits::RATE > 0.0 ? 1.0/Traits::RATE : 0.0;
+            acc[i] = phase*period[i];
+            run[i] = &Traits::Run;
+            fields[i] = &Traits::Fields;
+        }
+
+        //From clbkPreStep, for the FlightState sample: the fields the
+        //systems that run this frame will read.
+        unsigned int Fields(const V &v, double simdt) const {
+            unsigned int need = 0;
+            for (int i = 0; i < N; i++)
+                if (period[i] == 0.0 || acc[i] + simdt >= period[i]) need |= fields[i](v);
+            return need;
+        }
+
+        //From clbkPostStep, with the same simdt.
+        void Update(V &v, double simdt, const FlightState &flight){
+            for (int i = 0; i < N; i++) {
+                if (period[i] == 0.0) {
+                    run[i](v, simdt, flight);
+                    continue;
+                }
+                acc[i] += simdt;
+                if (acc[i] < period[i]) continue;
+                int n = (int)(acc[i]/period[i]);
+                acc[i] -= n*period[i];
+                if (n > SYSTEM_SUBSTEPS_MAX) {
+                    run[i](v, (n - SYSTEM_SUBSTEPS_MAX + 1)*period[i], flight);
+                    n = SYSTEM_SUBSTEPS_MAX - 1;
+                }
+                while (n--) run[i](v, period[i], flight);
+            }
+        }
+
+    private:
+
+        typedef void (*RunFunc)(V &, double, const FlightState &);
+        typedef unsigned int (*FieldsFunc)(const V &);
+
+        static inline unsigned int instances = 0;  //Vessels of the class created so far
+
+        double phase;          //Where in their period this vessel's systems start, 0 to 1
+        double period[N];      //Seconds, 0 for every frame
+        double acc[N];         //Time since the last run
+        RunFunc run[N];
+        FieldsFunc fields[N];
+};
+
+#endif
@@ -0,0 +1,91 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          BOEING 747 COMMON CODE
+//
+//B747VC.h
+//Virtual cockpit resources: the cockpit and first class cabin meshes
+//and the lights that only shine on them. The graphics client copies
+//every mesh of a vessel into its visual, so each AI 747 at an airport
+//used to carry the 1.9 MB of cockpit and cabin nobody boards. They are
+//now added on the vessel's first clbkLoadVC, at the mesh indices the
+//animation files use, and removed once the camera has been out of the
+//vessel's cockpit for VCReleaseTime seconds (class cfg, default 60).
+//
+//==========================================
+
+#pragma once
+
+#ifndef __B747VC_H
+#define __B747VC_H
+
+#include <algorithm>
+#include "Orbitersdk.h"
+#include "B747Lights.h"
+#include "B747Mesh.h"
+
+const double VC_RELEASE_TIME = 60.0;
+
+const int VC_MESHES_MAX = 4;
+
+struct VCMeshSpec {
+    const char *name;
+    UINT index;             //Mesh index the Animations files give it
+};
+
+class VCResources {
+
+    public:
+
+        VCResources() : vessel(NULL), cache(NULL), spec(NULL), n(0), release_time(VC_RELEASE_TIME), loaded(false), idle(0.0) {}
+
+        //Call from clbkSetClassCaps. The table and the cache must outlive the vessel.
+        void Init(VESSEL *v, MeshCache *meshes, const VCMeshSpec *specs, int count, double release = VC_RELEASE_TIME){
+            vessel = v;
+            cache = meshes;
+            spec = specs;
+            n = std::min(count, VC_MESHES_MAX);
+            release_time = release;
+        }
+
+        //From clbkLoadVC, before the MFDs are registered on the cockpit mesh.
+        void Load(LightGroups &lights){
+            idle = 0.0;
+            if (loaded) return;
+            for (int i = 0; i < n; i++) {
+                vessel->InsertMesh(cache->Load(spec[i].name), spec[i].index);
+                vessel->SetMeshVisibilityMode(spec[i].index, MESHVIS_VC);
+            }
+            lights.CreateCockpit(vessel);
+            loaded = true;
+        }
+
+        //From a slow system, with whether the camera is in this vessel's cockpit.
+        void Update(bool in_vc, double dt, LightGroups &lights){
+            if (!loaded) return;
+            if (in_vc) {
+                idle = 0.0;
+                return;
+            }
+            idle += dt;
+            if (idle < release_time) return;
+            for (int i = 0; i < n; i++) vessel->DelMesh(spec[i].index);
+            lights.DeleteCockpit(vessel);
+            loaded = false;
+        }
+
+        bool Loaded() const { return loaded; }
+
+    private:
+
+        VESSEL *vessel;
+        MeshCache *cache;
+        const VCMeshSpec *spec;
+        int n;
+        double release_time;    //Seconds out of the cockpit before the release
+        bool loaded;
+        double idle;            //Seconds out of the cockpit so far
+};
+
+#endif
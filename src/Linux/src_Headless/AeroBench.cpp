@@ -0,0 +1,148 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          HEADLESS ORBITER STAND-IN
+//
+//AeroBench.cpp
+//Compares the original airfoil curves (B747VLiftCurve/B747HLiftCurve)
+//with the AeroTable lookups the modules use: maximum error over a
+//dense sweep and random samples, and evaluation cost per sample.
+//Exits with 1 if any error exceeds AERO_TABLE_TOL_*.
+//
+//==========================================
+
+#include "B747Aero.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+struct Sample {
+    double aoa, M;
+};
+
+struct MaxError {
+    double cl = 0.0, cm = 0.0, cd = 0.0;
+    Sample at_cd = {0, 0};
+
+    void Add(const Sample &s, double cl0, double cm0, double cd0, double cl1, double cm1, double cd1){
+        cl = std::max(cl, std::fabs(cl1 - cl0));
+        cm = std::max(cm, std::fabs(cm1 - cm0));
+        if (std::fabs(cd1 - cd0) > cd) {
+            cd = std::fabs(cd1 - cd0);
+            at_cd = s;
+        }
+    }
+    bool Pass() const { return cl <= AERO_TABLE_TOL_CL && cm <= AERO_TABLE_TOL_CM && cd <= AERO_TABLE_TOL_CD; }
+};
+
+static double Now(){
+    using namespace std::chrono;
+    return duration<double, std::nano>(steady_clock::now().time_since_epoch()).count();
+}
+
+static MaxError Compare(AeroCurveFunc curve, double A, const AeroTable &table, const std::vector<Sample> &samples){
+    MaxError e;
+    for (const Sample &s : samples) {
+        double cl0, cm0, cd0, cl1, cm1, cd1;
+        curve(s.aoa, s.M, A, &cl0, &cm0, &cd0);
+        table.Lookup(s.aoa, s.M, 0.0, &cl1, &cm1, &cd1);
+        e.Add(s, cl0, cm0, cd0, cl1, cm1, cd1);
+    }
+    return e;
+}
+
+//ns per sample. The sum keeps the compiler from dropping the calls.
+static double TimeCurve(AeroCurveFunc curve, double A, const std::vector<Sample> &samples, double &sum){
+    double t0 = Now();
+    for (const Sample &s : samples) {
+        double cl, cm, cd;
+        curve(s.aoa, s.M, A, &cl, &cm, &cd);
+        sum += cl + cm + cd;
+    }
+    return (Now() - t0)/samples.size();
+}
+
+static double TimeTable(const AeroTable &table, const std::vector<Sample> &samples, double &sum){
+    double t0 = Now();
+    for (const Sample &s : samples) {
+        double cl, cm, cd;
+        table.Lookup(s.aoa, s.M, 0.0, &cl, &cm, &cd);
+        sum += cl + cm + cd;
+    }
+    return (Now() - t0)/samples.size();
+}
+
+int main(int argc, char **argv){
+    size_t n = 4000000;
+    double mmax = 1.2;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--samples") && i + 1 < argc) n = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--max-mach") && i + 1 < argc) mmax = atof(argv[++i]);
+        else {
+            fprintf(stderr, "usage: b747_aerobench [--samples N] [--max-mach M]\n");
+            return 2;
+        }
+    }
+
+    //Dense sweep: 0.05 deg x 0.005 Mach over the whole table.
+    std::vector<Sample> sweep;
+    for (int i = -3600; i <= 3600; i++)
+        for (int j = 0; j <= 400; j++)
+            sweep.push_back({i*0.05*RAD, j*0.005});
+
+    //Random flight conditions, as the benchmark input.
+    std::mt19937_64 rng(747);
+    std::uniform_real_distribution<double> daoa(-PI, PI), dmach(0.0, mmax);
+    std::vector<Sample> samples(n);
+    for (Sample &s : samples) s = {daoa(rng), dmach(rng)};
+
+    //A slowly varying flight path, closer to what one vessel sees per step.
+    std::vector<Sample> path(n);
+    for (size_t i = 0; i < n; i++) {
+        double t = (double)i/n;
+        path[i] = {(5.0 + 12.0*sin(40.0*PI*t))*RAD, mmax*0.5*(1.0 - cos(6.0*PI*t))};
+    }
+
+    struct {
+        const char *name;
+        AeroCurveFunc curve;
+        double A;
+        AeroTable table;
+    } airfoils[] = {
+        {"VLift", B747VLiftCurve, 7.0, {}},
+        {"HLift", B747HLiftCurve, 6.1156, {}},
+    };
+
+    int rc = 0;
+    double sum = 0.0;
+    printf("tolerance: cl %g, cm %g, cd %g\n", AERO_TABLE_TOL_CL, AERO_TABLE_TOL_CM, AERO_TABLE_TOL_CD);
+    for (auto &af : airfoils) {
+        double t0 = Now();
+        af.table.Sample(af.curve, af.A);
+        double t_build = (Now() - t0)*1e-3;
+
+        MaxError es = Compare(af.curve, af.A, af.table, sweep);
+        MaxError er = Compare(af.curve, af.A, af.table, samples);
+
+        double t_curve = TimeCurve(af.curve, af.A, samples, sum);
+        double t_table = TimeTable(af.table, samples, sum);
+        double t_curve_path = TimeCurve(af.curve, af.A, path, sum);
+        double t_table_path = TimeTable(af.table, path, sum);
+
+        printf("%s: %u x %u nodes, built in %.1f us\n", af.name, af.table.Grid().naoa, af.table.Grid().nmach, t_build);
+        printf("  sweep  max error cl %.2e cm %.2e cd %.2e (aoa %.2f deg, M %.3f)\n",
+            es.cl, es.cm, es.cd, es.at_cd.aoa*DEG, es.at_cd.M);
+        printf("  random max error cl %.2e cm %.2e cd %.2e\n", er.cl, er.cm, er.cd);
+        printf("  %zu random samples: curve %.2f ns, table %.2f ns, speedup %.1fx\n", n, t_curve, t_table, t_curve/t_table);
+        printf("  %zu path samples:   curve %.2f ns, table %.2f ns, speedup %.1fx\n", n, t_curve_path, t_table_path, t_curve_path/t_table_path);
+        if (!es.Pass() || !er.Pass()) {
+            printf("  FAIL: error above tolerance\n");
+            rc = 1;
+        }
+    }
+    printf("checksum %g\n", sum);
+    return rc;
+}
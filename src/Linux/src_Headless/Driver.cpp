@@ -0,0 +1,600 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          HEADLESS ORBITER STAND-IN
+//
+//Driver.cpp
+//Loads vessel modules built against the stand-in and steps them at
+//a fixed rate without the simulator:
+//ovcInit -> clbkSetClassCaps -> clbkLoadStateEx -> clbkPostCreation
+//-> clbkVisualCreated -> (clbkPreStep, clbkPostStep) x N -> ovcExit.
+//Reports per-callback cost and the API calls made per step.
+//
+//==========================================
+
+#include "Headless.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <fstream>
+#include <malloc.h>
+#include <strings.h>
+#include <unistd.h>
+
+using namespace headless;
+
+typedef void (*InitModuleFunc)(MODULEHANDLE);
+typedef void (*ExitModuleFunc)(MODULEHANDLE);
+typedef VESSEL *(*ovcInitFunc)(OBJHANDLE, int);
+typedef void (*ovcExitFunc)(VESSEL *);
+
+struct KeyEvent {
+    double t;
+    int key;
+    int modkey;     //OAPI_KEY_LCONTROL, LSHIFT or LALT held with the key, 0 for none
+    int target;     //Vessel index, -1 for every vessel
+};
+
+struct Options {
+    double seconds = 60.0;
+    double rate = 60.0;
+    int vessels = 1;
+    std::vector<int> fleet;
+    bool visual = true;
+    bool vc = false;
+    double leave_vc = -1.0;
+    double camera_distance = 0.0;
+    bool save = false;
+    bool dump_anims = false;
+    bool expect_lod = false;
+    double throttle = 0.0;
+    double steady_after = 0.0;
+    Environment env;
+    std::string cfg;
+    std::vector<std::string> state;
+    std::vector<KeyEvent> keys;
+    std::vector<int> expect_zero;
+    std::string csv;
+    std::vector<std::string> modules;
+};
+
+struct Timer {
+    double total = 0.0, max = 0.0;
+    uint64_t n = 0;
+
+    void Add(double us){
+        total += us;
+        max = std::max(max, us);
+        n++;
+    }
+    double Mean() const { return n ? total/n : 0.0; }
+};
+
+static double Now(){
+    using namespace std::chrono;
+    return duration<double, std::micro>(steady_clock::now().time_since_epoch()).count();
+}
+
+static const struct { const char *name; int key; } keynames[] = {
+    {"A", OAPI_KEY_A}, {"B", OAPI_KEY_B}, {"C", OAPI_KEY_C}, {"D", OAPI_KEY_D},
+    {"E", OAPI_KEY_E}, {"F", OAPI_KEY_F}, {"G", OAPI_KEY_G}, {"H", OAPI_KEY_H},
+    {"I", OAPI_KEY_I}, {"J", OAPI_KEY_J}, {"K", OAPI_KEY_K}, {"L", OAPI_KEY_L},
+    {"M", OAPI_KEY_M}, {"N", OAPI_KEY_N}, {"O", OAPI_KEY_O}, {"P", OAPI_KEY_P},
+    {"Q", OAPI_KEY_Q}, {"R", OAPI_KEY_R}, {"S", OAPI_KEY_S}, {"T", OAPI_KEY_T},
+    {"U", OAPI_KEY_U}, {"V", OAPI_KEY_V}, {"W", OAPI_KEY_W}, {"X", OAPI_KEY_X},
+    {"Y", OAPI_KEY_Y}, {"Z", OAPI_KEY_Z},
+    {"1", OAPI_KEY_1}, {"2", OAPI_KEY_2}, {"3", OAPI_KEY_3}, {"4", OAPI_KEY_4},
+    {"5", OAPI_KEY_5}, {"6", OAPI_KEY_6}, {"7", OAPI_KEY_7}, {"8", OAPI_KEY_8},
+    {"9", OAPI_KEY_9}, {"0", OAPI_KEY_0},
+    {"NUMPADENTER", OAPI_KEY_NUMPADENTER}, {"SPACE", OAPI_KEY_SPACE},
+    {"COMMA", OAPI_KEY_COMMA}, {"PERIOD", OAPI_KEY_PERIOD},
+};
+
+static bool ParseKey(const char *arg, KeyEvent &ev){
+    char name[32] = "", mod[16] = "";
+    std::string spec = arg;
+    ev.target = -1;
+    size_t at = spec.find('@');
+    if (at != std::string::npos) {
+        ev.target = atoi(spec.c_str() + at + 1) - 1;
+        if (ev.target < 0) return false;
+        spec.resize(at);
+    }
+    if (sscanf(spec.c_str(), "%lf:%31[^:]:%15s", &ev.t, name, mod) < 2) return false;
+    if (!mod[0]) ev.modkey = 0;
+    else if (!strcasecmp(mod, "ctrl")) ev.modkey = OAPI_KEY_LCONTROL;
+    else if (!strcasecmp(mod, "shift")) ev.modkey = OAPI_KEY_LSHIFT;
+    else if (!strcasecmp(mod, "alt")) ev.modkey = OAPI_KEY_LALT;
+    else return false;
+    for (auto &k : keynames) {
+        if (!strcasecmp(k.name, name)) {
+            ev.key = k.key;
+            return true;
+        }
+    }
+    return false;
+}
+
+//Comma separated API names, e.g. CreateThrusterGroup,DelThrusterGroup
+static bool ParseApiList(const char *arg, std::vector<int> &apis){
+    std::string list = arg;
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t end = list.find(',', pos);
+        if (end == std::string::npos) end = list.size();
+        std::string name = list.substr(pos, end - pos);
+        int i = 0;
+        while (i < API_COUNT && strcasecmp(ApiName(i), name.c_str())) i++;
+        if (i == API_COUNT) return false;
+        apis.push_back(i);
+        pos = end + 1;
+    }
+    return true;
+}
+
+//Comma separated fleet sizes, e.g. 1,10,100,500
+static bool ParseFleet(const char *arg, std::vector<int> &sizes){
+    for (const char *p = arg; *p; ) {
+        char *end;
+        long n = strtol(p, &end, 10);
+        if (end == p || n < 1) return false;
+        sizes.push_back((int)n);
+        p = *end == ',' ? end + 1 : end;
+        if (*end && *end != ',') return false;
+    }
+    return !sizes.empty();
+}
+
+//Heap bytes in use, as seen by malloc.
+static size_t HeapInUse(){
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+}
+
+//Reads a vessel block. For a .scn file the first ship in BEGIN_SHIPS is used.
+static bool ReadState(const char *fname, std::vector<std::string> &lines){
+    std::ifstream in(fname);
+    if (!in) return false;
+    std::vector<std::string> all;
+    std::string line;
+    bool scn = false;
+    while (std::getline(in, line)) {
+        if (line.find("BEGIN_SHIPS") != std::string::npos) scn = true;
+        all.push_back(line);
+    }
+    if (!scn) {
+        lines = all;
+        return true;
+    }
+    bool inships = false, inship = false;
+    for (const std::string &l : all) {
+        if (!inships) {
+            inships = l.find("BEGIN_SHIPS") != std::string::npos;
+        } else if (!inship) {
+            inship = l.find(':') != std::string::npos;
+        } else {
+            lines.push_back(l);
+            if (l.find("END") != std::string::npos && l.find_first_not_of(" \t") == l.find("END")) break;
+        }
+    }
+    return true;
+}
+
+//Animation names are not known to the vessel, so they come out as anim<handle>.
+static void DumpAnimations(const Vessel &v){
+    for (size_t a = 0; a < v.animations.size(); a++) {
+        const Animation &anim = v.animations[a];
+        if (!anim.defined) continue;
+        printf("ANIM anim%zu %g\n", a, anim.state);
+        for (const AnimationComponent &c : anim.comps) {
+            const MGROUP_TRANSFORM *t = c.trans;
+            if (t->Type() == MGROUP_TRANSFORM::ROTATE) {
+                const MGROUP_ROTATE *r = static_cast<const MGROUP_ROTATE *>(t);
+                printf("ROTATE %u %g %g  %.9g %.9g %.9g  %.9g %.9g %.9g  %g ", t->mesh, c.state0, c.state1,
+                    r->ref.x, r->ref.y, r->ref.z, r->axis.x, r->axis.y, r->axis.z, std::round(r->angle*DEG*1e4)/1e4);
+            } else if (t->Type() == MGROUP_TRANSFORM::TRANSLATE) {
+                const MGROUP_TRANSLATE *tr = static_cast<const MGROUP_TRANSLATE *>(t);
+                printf("TRANSLATE %u %g %g  %.9g %.9g %.9g ", t->mesh, c.state0, c.state1, tr->shift.x, tr->shift.y, tr->shift.z);
+            } else if (t->Type() == MGROUP_TRANSFORM::SCALE) {
+                const MGROUP_SCALE *sc = static_cast<const MGROUP_SCALE *>(t);
+                printf("SCALE %u %g %g  %.9g %.9g %.9g  %.9g %.9g %.9g ", t->mesh, c.state0, c.state1,
+                    sc->ref.x, sc->ref.y, sc->ref.z, sc->scale.x, sc->scale.y, sc->scale.z);
+            } else continue;
+            for (UINT g = 0; g < t->ngrp; g++) printf(" %u", t->grp[g]);
+            printf("\n");
+        }
+    }
+}
+
+static void Usage(){
+    fprintf(stderr,
+        "usage: b747_headless [options] <module.so>...\n"
+        "  --root DIR         Orbiter root with Config/, Meshes/, Textures/ (default .)\n"
+        "  --seconds N        simulated seconds per module (default 60)\n"
+        "  --rate HZ          fixed step rate (default 60)\n"
+        "  --vessels N        instances per module (default 1)\n"
+        "  --fleet N[,N]      run each module once per fleet size, e.g. 1,10,100,500\n"
+        "  --cfg FILE         class config (relative to Config/) passed to clbkSetClassCaps\n"
+        "  --state FILE       vessel block or .scn passed to clbkLoadStateEx\n"
+        "  --key T:KEY[:ctrl|shift|alt][@I]  press KEY at simulated time T, e.g. 1:G or 2:A:ctrl;\n"
+        "                     @I sends it to vessel I only (1-based) instead of all\n"
+        "  --mach M --altitude A --groundspeed V --aoa DEG  flight conditions\n"
+        "  --throttle X       main thruster group level applied every step\n"
+        "  --steady-after T   count API calls only from simulated time T on\n"
+        "  --expect-zero API[,API]  fail if any listed API is called after --steady-after\n"
+        "  --no-visual        do not create visuals\n"
+        "  --vc               focus vessel in virtual cockpit view\n"
+        "  --leave-vc T       switch the camera to the outside view at T seconds\n"
+        "  --camera-distance D  external camera D m behind the focus vessel (default 0)\n"
+        "  --expect-lod       fail unless fewer exterior triangles are drawn at the end than after\n"
+        "                     create, i.e. the distance levels load (with --camera-distance)\n"
+        "  --save             print the saved state of the first vessel\n"
+        "  --dump-anims       print the animations of the first vessel in the\n"
+        "                     Config/Boeing747/Animations text format\n"
+        "  --csv FILE         append one row per run: class,vessels,steps,rate,pre_mean,pre_max,\n"
+        "                     post_mean,post_max,aero_mean,aero_max,api_calls,step_us,object_bytes,heap_bytes\n"
+        "  --log              echo Orbiter.log lines to stderr\n");
+}
+
+static bool ParseOptions(int argc, char **argv, Options &opt){
+    Context &ctx = GetContext();
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        bool more = i + 1 < argc;
+        if (!strcmp(a, "--root") && more) ctx.root = argv[++i];
+        else if (!strcmp(a, "--seconds") && more) opt.seconds = atof(argv[++i]);
+        else if (!strcmp(a, "--rate") && more) opt.rate = atof(argv[++i]);
+        else if (!strcmp(a, "--vessels") && more) opt.vessels = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(a, "--mach") && more) opt.env.mach = atof(argv[++i]);
+        else if (!strcmp(a, "--altitude") && more) opt.env.altitude = atof(argv[++i]);
+        else if (!strcmp(a, "--groundspeed") && more) opt.env.groundspeed = atof(argv[++i]);
+        else if (!strcmp(a, "--aoa") && more) opt.env.aoa = atof(argv[++i])*RAD;
+        else if (!strcmp(a, "--throttle") && more) opt.throttle = atof(argv[++i]);
+        else if (!strcmp(a, "--camera-distance") && more) opt.camera_distance = atof(argv[++i]);
+        else if (!strcmp(a, "--steady-after") && more) opt.steady_after = atof(argv[++i]);
+        else if (!strcmp(a, "--csv") && more) opt.csv = argv[++i];
+        else if (!strcmp(a, "--cfg") && more) opt.cfg = argv[++i];
+        else if (!strcmp(a, "--no-visual")) opt.visual = false;
+        else if (!strcmp(a, "--vc")) opt.vc = true;
+        else if (!strcmp(a, "--leave-vc") && more) opt.leave_vc = atof(argv[++i]);
+        else if (!strcmp(a, "--save")) opt.save = true;
+        else if (!strcmp(a, "--dump-anims")) opt.dump_anims = true;
+        else if (!strcmp(a, "--expect-lod")) opt.expect_lod = true;
+        else if (!strcmp(a, "--log")) ctx.echo_log = true;
+        else if (!strcmp(a, "--state") && more) {
+            if (!ReadState(argv[++i], opt.state)) {
+                fprintf(stderr, "cannot read state file %s\n", argv[i]);
+                return false;
+            }
+        } else if (!strcmp(a, "--key") && more) {
+            KeyEvent ev;
+            if (!ParseKey(argv[++i], ev)) {
+                fprintf(stderr, "bad key event %s\n", argv[i]);
+                return false;
+            }
+            opt.keys.push_back(ev);
+        } else if (!strcmp(a, "--fleet") && more) {
+            if (!ParseFleet(argv[++i], opt.fleet)) {
+                fprintf(stderr, "bad fleet sizes %s\n", argv[i]);
+                return false;
+            }
+        } else if (!strcmp(a, "--expect-zero") && more) {
+            if (!ParseApiList(argv[++i], opt.expect_zero)) {
+                fprintf(stderr, "bad API list %s\n", argv[i]);
+                return false;
+            }
+        } else if (a[0] == '-') {
+            return false;
+        } else {
+            opt.modules.push_back(a);
+        }
+    }
+    if (opt.env.groundspeed > 0.0 && opt.env.airspeed == 0.0) opt.env.airspeed = opt.env.groundspeed;
+    if (opt.env.mach == 0.0) opt.env.mach = opt.env.airspeed/340.3;
+    if (opt.env.airspeed == 0.0) opt.env.airspeed = opt.env.mach*340.3;
+    opt.env.density = 1.225*exp(-opt.env.altitude/8500.0);
+    return !opt.modules.empty() && opt.rate > 0.0;
+}
+
+//Class name from the module file: BIN/libBoeing747SP.so -> Boeing747SP
+static std::string ClassName(const std::string &path){
+    std::string name = path.substr(path.find_last_of('/') + 1);
+    if (!name.compare(0, 3, "lib")) name = name.substr(3);
+    return name.substr(0, name.find('.'));
+}
+
+static int RunModule(const Options &opt, const std::string &path){
+    Context &ctx = GetContext();
+    std::string cls = ClassName(path);
+
+    void *hModule = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!hModule) {
+        fprintf(stderr, "%s\n", dlerror());
+        return 1;
+    }
+    auto InitModule = (InitModuleFunc)dlsym(hModule, "InitModule");
+    auto ExitModule = (ExitModuleFunc)dlsym(hModule, "ExitModule");
+    auto ovcInit = (ovcInitFunc)dlsym(hModule, "ovcInit");
+    auto ovcExit = (ovcExitFunc)dlsym(hModule, "ovcExit");
+    if (!ovcInit || !ovcExit) {
+        fprintf(stderr, "%s: ovcInit/ovcExit not exported\n", path.c_str());
+        dlclose(hModule);
+        return 1;
+    }
+
+    ctx.simt = 0.0;
+    ctx.simdt = 1.0/opt.rate;
+    ctx.cockpit_mode = opt.vc ? COCKPIT_VIRTUAL : COCKPIT_GENERIC;
+    ctx.camera_internal = opt.vc;
+    ctx.global.Reset();
+
+    double t0 = Now();
+    if (InitModule) InitModule(hModule);
+    double t_init = Now() - t0;
+
+    t0 = Now();
+    size_t heap0 = HeapInUse();
+    std::vector<std::unique_ptr<Vessel>> fleet;
+    for (int i = 0; i < opt.vessels; i++) {
+        char name[256];
+        snprintf(name, sizeof(name), "%s-%d", cls.c_str(), i + 1);
+        Vessel *v = new Vessel(name, cls);
+        fleet.emplace_back(v);
+        v->env = opt.env;
+        v->env.gpos = _V(100.0*i, 0, 0);
+        SetCurrent(v);
+        ovcInit(v, 1);
+        VESSEL2 *vs = static_cast<VESSEL2 *>(v->iface);
+        FILEHANDLE cfg = opt.cfg.empty() ? nullptr : oapiOpenFile(opt.cfg.c_str(), FILE_IN, CONFIG);
+        vs->clbkSetClassCaps(cfg);
+        if (cfg) oapiCloseFile(cfg, FILE_IN);
+        if (!opt.state.empty()) {
+            FILEHANDLE scn = OpenScenarioIn(opt.state);
+            vs->clbkLoadStateEx(scn, nullptr);
+            CloseScenario(scn);
+        }
+        vs->clbkPostCreation();
+        SetCurrent(nullptr);
+    }
+    ctx.focus = fleet.front().get();
+    ctx.camera_gpos = fleet.front()->env.gpos - _V(opt.camera_distance, 0, 0);
+    if (opt.visual)
+        for (auto &v : fleet) v->CreateVisual();
+    if (opt.vc) {
+        SetCurrent(fleet.front().get());
+        static_cast<VESSEL2 *>(fleet.front()->iface)->clbkLoadVC(0);
+        SetCurrent(nullptr);
+    }
+    double t_create = Now() - t0;
+    size_t heap_per_vessel = (HeapInUse() - std::min(heap0, HeapInUse()))/fleet.size();
+    size_t object_size = malloc_usable_size(fleet.front()->iface);
+    size_t meshes_create = ctx.visual_meshes_live, mesh_bytes_create = ctx.visual_mesh_bytes_live;
+    uint64_t triangles_create = 0, draws_create = 0, transforms_create = 0;
+    for (auto &v : fleet) {
+        triangles_create += v->ExteriorTriangles();
+        draws_create += v->ExteriorDraws();
+        transforms_create += v->ExteriorTransforms();
+    }
+
+    for (auto &v : fleet) {
+        v->counters.Reset();
+        v->touchdown_sets = 0;
+    }
+    ctx.global.Reset();
+
+    Timer pre, post, aero, keys;
+    char kstate[256];
+    long nsteps = (long)(opt.seconds*opt.rate + 0.5);
+    size_t nextkey = 0;
+    std::vector<KeyEvent> events = opt.keys;
+    std::sort(events.begin(), events.end(), [](const KeyEvent &a, const KeyEvent &b){ return a.t < b.t; });
+
+    bool steady = opt.steady_after <= 0.0;
+    long steady_steps = nsteps;
+    long gear_transitions = 0;  //G presses delivered, each starts or reverses a gear transition
+    uint64_t pre_calls = 0, post_calls = 0;  //API calls made from inside each callback
+
+    for (long step = 0; step < nsteps; step++) {
+        ctx.simt += ctx.simdt;
+        double mjd = 51982.0 + ctx.simt/86400.0;
+
+        if (opt.leave_vc >= 0.0 && ctx.simt >= opt.leave_vc && ctx.camera_internal) {
+            ctx.cockpit_mode = COCKPIT_GENERIC;
+            ctx.camera_internal = false;
+        }
+
+        if (!steady && ctx.simt > opt.steady_after) {
+            for (auto &v : fleet) v->counters.Reset();
+            ctx.global.Reset();
+            pre_calls = post_calls = 0;
+            steady = true;
+            steady_steps = nsteps - step;
+        }
+
+        while (nextkey < events.size() && events[nextkey].t <= ctx.simt) {
+            const KeyEvent &ev = events[nextkey++];
+            memset(kstate, 0, sizeof(kstate));
+            if (ev.modkey) kstate[ev.modkey] = (char)0x80;
+            kstate[ev.key] = (char)0x80;
+            for (size_t i = 0; i < fleet.size(); i++) {
+                if (ev.target >= 0 && (size_t)ev.target != i) continue;
+                if (ev.key == OAPI_KEY_G && !ev.modkey) gear_transitions++;
+                Vessel *v = fleet[i].get();
+                SetCurrent(v);
+                double t = Now();
+                static_cast<VESSEL2 *>(v->iface)->clbkConsumeBufferedKey(ev.key, true, kstate);
+                keys.Add(Now() - t);
+            }
+        }
+
+        for (auto &v : fleet) {
+            if (opt.throttle > 0.0)
+                if (ThrusterGroup *g = v->FindGroup(THGROUP_MAIN))
+                    for (Thruster *th : g->thrusters) th->level = opt.throttle;
+            SetCurrent(v.get());
+            uint64_t c = v->counters.Total();
+            double t = Now();
+            static_cast<VESSEL2 *>(v->iface)->clbkPreStep(ctx.simt, ctx.simdt, mjd);
+            pre.Add(Now() - t);
+            pre_calls += v->counters.Total() - c;
+        }
+        for (auto &v : fleet) {
+            SetCurrent(nullptr);
+            double t = Now();
+            v->Integrate(ctx.simdt);
+            v->EvaluateAirfoils();
+            aero.Add(Now() - t);
+        }
+        for (auto &v : fleet) {
+            SetCurrent(v.get());
+            uint64_t c = v->counters.Total();
+            double t = Now();
+            static_cast<VESSEL2 *>(v->iface)->clbkPostStep(ctx.simt, ctx.simdt, mjd);
+            post.Add(Now() - t);
+            post_calls += v->counters.Total() - c;
+        }
+        SetCurrent(nullptr);
+    }
+
+    Counters calls;
+    for (auto &v : fleet) calls += v->counters;
+
+    if (opt.dump_anims) DumpAnimations(*fleet.front());
+
+    if (opt.save) {
+        FILEHANDLE scn = OpenScenarioOut();
+        SetCurrent(fleet.front().get());
+        static_cast<VESSEL2 *>(fleet.front()->iface)->clbkSaveState(scn);
+        SetCurrent(nullptr);
+        printf("%s:%s\n%sEND\n", fleet.front()->name.c_str(), cls.c_str(), CloseScenario(scn).c_str());
+    }
+
+    size_t groups = 0, lights = 0, lights_active = 0;
+    uint64_t touchdown_sets = 0;
+    for (auto &v : fleet) {
+        touchdown_sets += v->touchdown_sets;
+        groups += v->groups.size();
+        lights += v->lights.size();
+        for (auto &le : v->lights) lights_active += le->IsActive();
+    }
+
+    size_t meshes_end = ctx.visual_meshes_live, mesh_bytes_end = ctx.visual_mesh_bytes_live;
+    uint64_t triangles_end = 0, draws_end = 0, transforms_end = 0;
+    for (auto &v : fleet) {
+        triangles_end += v->ExteriorTriangles();
+        draws_end += v->ExteriorDraws();
+        transforms_end += v->ExteriorTransforms();
+    }
+
+    t0 = Now();
+    for (auto &v : fleet) {
+        v->DestroyVisual();
+        SetCurrent(v.get());
+        ovcExit(v->iface);
+        SetCurrent(nullptr);
+        v->iface = nullptr;
+    }
+    fleet.clear();
+    if (ExitModule) ExitModule(hModule);
+    double t_exit = Now() - t0;
+
+    if (!steady) steady_steps = 0;
+    double persteps = steady_steps > 0 ? 1.0/((double)steady_steps*opt.vessels) : 0.0;
+    printf("%s: %d vessel(s), %ld steps at %g Hz\n", cls.c_str(), opt.vessels, nsteps, opt.rate);
+    printf("  InitModule   %10.1f us\n", t_init);
+    printf("  create       %10.1f us\n", t_create);
+    printf("  exit         %10.1f us\n", t_exit);
+    printf("  PreStep      mean %8.3f us  max %8.1f us\n", pre.Mean(), pre.max);
+    printf("  PostStep     mean %8.3f us  max %8.1f us\n", post.Mean(), post.max);
+    printf("  airfoils     mean %8.3f us  max %8.1f us\n", aero.Mean(), aero.max);
+    double step_us = nsteps > 0 ? (pre.total + aero.total + post.total)/nsteps : 0.0;
+    printf("  fleet step   %10.1f us, %8.3f us per vessel\n", step_us, step_us/opt.vessels);
+    printf("  memory       vessel object %zu bytes, heap per vessel %.1f KiB\n", object_size, heap_per_vessel/1024.0);
+    printf("  visual meshes per vessel: %.1f (%.1f KiB) after create, %.1f (%.1f KiB) at end\n",
+        (double)meshes_create/opt.vessels, mesh_bytes_create/1024.0/opt.vessels,
+        (double)meshes_end/opt.vessels, mesh_bytes_end/1024.0/opt.vessels);
+    printf("  exterior triangles per vessel: %.0f after create, %.0f at end\n",
+        (double)triangles_create/opt.vessels, (double)triangles_end/opt.vessels);
+    printf("  exterior draw calls per vessel: %.0f after create, %.0f at end\n",
+        (double)draws_create/opt.vessels, (double)draws_end/opt.vessels);
+    printf("  exterior vertex cache ACMR: %.3f after create, %.3f at end\n",
+        (double)transforms_create/std::max<uint64_t>(1, triangles_create),
+        (double)transforms_end/std::max<uint64_t>(1, triangles_end));
+    if (keys.n) printf("  ConsumeKey   mean %8.3f us  max %8.1f us\n", keys.Mean(), keys.max);
+    if (opt.steady_after > 0.0) printf("  steady state from t = %g s, %ld steps\n", opt.steady_after, steady_steps);
+    printf("  API calls per vessel step %.2f:", calls.Total()*persteps);
+    for (int i = 0; i < API_COUNT; i++)
+        if (calls.calls[i]) printf(" %s %.2f", ApiName(i), calls.calls[i]*persteps);
+    printf("\n");
+    printf("  API calls by callback per vessel step: PreStep %.2f, PostStep %.2f\n", pre_calls*persteps, post_calls*persteps);
+    if (gear_transitions)
+        printf("  touchdown    %llu SetTouchdownPoints over %ld gear transition(s), %.1f per transition\n",
+            (unsigned long long)touchdown_sets, gear_transitions, (double)touchdown_sets/gear_transitions);
+    printf("  thruster groups at end %zu, light emitters at end %zu (%zu active)\n", groups, lights, lights_active);
+    printf("  textures live %zu (%zu KiB), peak %zu (%zu KiB), files left open %zu\n",
+        ctx.textures_live, ctx.texture_bytes_live/1024, ctx.textures_peak, ctx.texture_bytes_peak/1024, ctx.files_open);
+
+    if (!opt.csv.empty()) {
+        FILE *f = fopen(opt.csv.c_str(), "a");
+        if (f) {
+            fprintf(f, "%s,%d,%ld,%g,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.2f,%.1f,%zu,%zu\n", cls.c_str(), opt.vessels, nsteps, opt.rate,
+                pre.Mean(), pre.max, post.Mean(), post.max, aero.Mean(), aero.max, calls.Total()*persteps,
+                step_us, object_size, heap_per_vessel);
+            fclose(f);
+        }
+    }
+
+    int rc = 0;
+    for (int api : opt.expect_zero) {
+        if (calls.calls[api]) {
+            printf("  FAIL: %s called %llu time(s) in steady state\n", ApiName(api), (unsigned long long)calls.calls[api]);
+            rc = 1;
+        }
+    }
+    if (opt.expect_lod && triangles_end >= triangles_create) {
+        printf("  FAIL: %.0f exterior triangles per vessel at end, no distance level drawn\n", (double)triangles_end/opt.vessels);
+        rc = 1;
+    }
+
+    dlclose(hModule);
+    return rc;
+}
+
+static std::string Absolute(const std::string &path){
+    if (path.empty() || path[0] == '/') return path;
+    char cwd[4096];
+    return getcwd(cwd, sizeof(cwd)) ? std::string(cwd) + "/" + path : path;
+}
+
+int main(int argc, char **argv){
+    Options opt;
+    if (!ParseOptions(argc, argv, opt)) {
+        Usage();
+        return 2;
+    }
+
+    //Orbiter runs with its root as working directory; modules open files relative to it.
+    Context &ctx = GetContext();
+    for (std::string &m : opt.modules) m = Absolute(m);
+    opt.csv = Absolute(opt.csv);
+    if (chdir(ctx.root.c_str()) != 0) {
+        fprintf(stderr, "cannot enter %s\n", ctx.root.c_str());
+        return 2;
+    }
+    ctx.root = ".";
+
+    int rc = 0;
+    if (opt.fleet.empty()) opt.fleet.push_back(opt.vessels);
+    for (const std::string &m : opt.modules) {
+        for (int n : opt.fleet) {
+            opt.vessels = n;
+            rc |= RunModule(opt, m);
+        }
+    }
+    return rc;
+}
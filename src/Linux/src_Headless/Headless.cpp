@@ -0,0 +1,1139 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          HEADLESS ORBITER STAND-IN
+//
+//Headless.cpp
+//Implementation of the VESSEL/oapi* subset. Every vessel call is
+//recorded in the headless::Vessel behind its OBJHANDLE and charged
+//to the API counters, so the driver can report what a module does
+//per simulation step.
+//
+//==========================================
+
+#include "Headless.h"
+#include "XRSound.h"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <strings.h>
+
+namespace headless {
+
+static const char *api_names[API_COUNT] = {
+#define HEADLESS_API_NAME(name) #name,
+    HEADLESS_API_CALLS(HEADLESS_API_NAME)
+#undef HEADLESS_API_NAME
+};
+
+const char *ApiName(int api){
+    return (api >= 0 && api < API_COUNT) ? api_names[api] : "?";
+}
+
+uint64_t Counters::Total() const {
+    uint64_t n = 0;
+    for (auto c : calls) n += c;
+    return n;
+}
+
+Counters &Counters::operator+= (const Counters &o){
+    for (int i = 0; i < API_COUNT; i++) calls[i] += o.calls[i];
+    return *this;
+}
+
+static Context g_context;
+static thread_local Vessel *g_current = nullptr;
+
+Context &GetContext(){ return g_context; }
+Vessel *Current(){ return g_current; }
+void SetCurrent(Vessel *v){ g_current = v; }
+
+static inline void Count(Vessel *v, Api api){
+    if (v) v->counters.calls[api]++;
+    g_context.global.calls[api]++;
+}
+
+static inline void Count(Api api){
+    Count(g_current, api);
+}
+
+static inline Vessel *V(OBJHANDLE hObj){
+    return static_cast<Vessel *>(hObj);
+}
+
+std::string ResolvePath(const char *dir, const char *fname, const char *ext){
+    std::string path = g_context.root;
+    if (dir && *dir) { path += '/'; path += dir; }
+    path += '/';
+    path += fname;
+    if (ext) path += ext;
+    std::replace(path.begin(), path.end(), '\\', '/');
+    return path;
+}
+
+//Textures: the file is read into memory so load cost and footprint are real.
+
+struct Texture {
+    std::string path;
+    std::vector<char> data;
+    int refs = 0;           //Meshes holding it, for the textures of mesh files
+};
+
+static Texture *ReadTexture(const char *fname){
+    std::string path = ResolvePath("Textures", fname);
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return nullptr;
+    Texture *tex = new Texture;
+    tex->path = path;
+    //One read, so the cost measured is the file system's rather than a byte-wise copy.
+    tex->data.resize((size_t)in.tellg());
+    in.seekg(0);
+    in.read(tex->data.data(), tex->data.size());
+    g_context.textures_live++;
+    g_context.texture_bytes_live += tex->data.size();
+    g_context.textures_peak = std::max(g_context.textures_peak, g_context.textures_live);
+    g_context.texture_bytes_peak = std::max(g_context.texture_bytes_peak, g_context.texture_bytes_live);
+    return tex;
+}
+
+static void FreeTexture(Texture *tex){
+    g_context.textures_live--;
+    g_context.texture_bytes_live -= tex->data.size();
+    delete tex;
+}
+
+//The textures of mesh files are shared by name, as the graphics client's
+//texture repository does, so meshes built onto one template hold one copy.
+static std::map<std::string, Texture *> g_mesh_textures;
+
+static Texture *AcquireTexture(const char *fname){
+    auto it = g_mesh_textures.find(ResolvePath("Textures", fname));
+    Texture *tex = it != g_mesh_textures.end() ? it->second : ReadTexture(fname);
+    if (tex && !tex->refs++) g_mesh_textures[tex->path] = tex;
+    return tex;
+}
+
+static void ReleaseTexture(Texture *tex){
+    if (--tex->refs) return;
+    g_mesh_textures.erase(tex->path);
+    FreeTexture(tex);
+}
+
+//Meshes: parsed for size only, the stand-in has no renderer. A vessel
+//keeps its own copy of a mesh that is not global, as the simulator does,
+//so the module may delete its template after AddMesh.
+
+struct Mesh {
+    std::string name;
+    size_t bytes = 0;
+    UINT ngroups = 0, nvertices = 0, ntriangles = 0;
+    UINT ndrawn = 0;                //Triangles of the groups not flagged 0x2
+    UINT ndraws = 0;                //and those of them with triangles, a draw call each
+    UINT ntransformed = 0;          //Vertices CacheMisses counts for those triangles
+    UINT nmaterials = 0;
+    std::vector<SURFHANDLE> textures;
+    std::vector<Texture *> loaded;  //Acquired with the mesh file, whatever the module sets
+    bool global = false;
+};
+
+static std::map<std::string, Mesh *> g_global_meshes;
+
+//Vertices a 16 entry FIFO post-transform cache transforms for a group's
+//triangles, counted as b747_meshgen --acmr does.
+static UINT CacheMisses(const WORD *idx, size_t n){
+    WORD fifo[16];
+    size_t len = 0, head = 0;
+    UINT misses = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (std::find(fifo, fifo + len, idx[i]) != fifo + len) continue;
+        misses++;
+        if (len < 16) fifo[len++] = idx[i];
+        else {
+            fifo[head] = idx[i];
+            head = (head + 1) % 16;
+        }
+    }
+    return misses;
+}
+
+static Mesh *ParseMesh(const char *fname){
+    std::string path = ResolvePath("Meshes", fname, ".msh");
+    std::ifstream in(path);
+    if (!in) {
+        oapiWriteLogV("Headless: mesh not found: %s", path.c_str());
+        return nullptr;
+    }
+    Mesh *mesh = new Mesh;
+    mesh->name = fname;
+    std::string line;
+    UINT flag = 0;
+    while (std::getline(in, line)) {
+        mesh->bytes += line.size() + 1;
+        UINT nv, nt;
+        sscanf(line.c_str(), "FLAG %x", &flag);
+        sscanf(line.c_str(), "MATERIALS %u", &mesh->nmaterials);
+        //The loader reads the textures the groups use along with the mesh.
+        if (sscanf(line.c_str(), "TEXTURES %u", &nt) == 1) {
+            for (UINT i = 0; i < nt && std::getline(in, line); i++) {
+                mesh->bytes += line.size() + 1;
+                char name[256];
+                if (sscanf(line.c_str(), "%255s", name) != 1) continue;
+                Texture *tex = AcquireTexture(name);
+                mesh->textures.push_back(tex);
+                if (tex) mesh->loaded.push_back(tex);
+            }
+        }
+        if (sscanf(line.c_str(), "GEOM %u %u", &nv, &nt) == 2) {
+            mesh->ngroups++;
+            mesh->nvertices += nv;
+            mesh->ntriangles += nt;
+            if (!(flag & 2)) mesh->ndrawn += nt;
+            if (!(flag & 2) && nt) mesh->ndraws++;
+            //Vertex and index records are read as numbers, like the loader does.
+            std::vector<WORD> idx;
+            idx.reserve((size_t)nt * 3);
+            for (UINT i = 0; i < nv + nt && std::getline(in, line); i++) {
+                mesh->bytes += line.size() + 1;
+                const char *p = line.c_str();
+                char *end;
+                for (int k = 0; ; k++) {
+                    double x = strtod(p, &end);
+                    if (end == p) break;
+                    if (i >= nv && k < 3) idx.push_back((WORD)x);
+                    p = end;
+                }
+            }
+            if (!(flag & 2)) mesh->ntransformed += CacheMisses(idx.data(), idx.size());
+            flag = 0;
+        }
+    }
+    mesh->bytes += (size_t)mesh->nvertices * 32 + (size_t)mesh->ntriangles * 6;
+    g_context.meshes_live++;
+    g_context.mesh_bytes_live += mesh->bytes;
+    return mesh;
+}
+
+static void FreeMesh(Mesh *mesh){
+    for (Texture *tex : mesh->loaded) ReleaseTexture(tex);
+    g_context.meshes_live--;
+    g_context.mesh_bytes_live -= mesh->bytes;
+    delete mesh;
+}
+
+//What a mesh slot holds for hMesh: the global mesh itself, otherwise a copy.
+static MESHHANDLE SlotMesh(MESHHANDLE hMesh){
+    Mesh *mesh = static_cast<Mesh *>(hMesh);
+    if (!mesh || mesh->global) return mesh;
+    g_context.meshes_live++;
+    g_context.mesh_bytes_live += mesh->bytes;
+    Mesh *copy = new Mesh(*mesh);
+    copy->loaded.clear();
+    return copy;
+}
+
+static void FreeSlot(MeshSlot &m){
+    Mesh *mesh = static_cast<Mesh *>(m.hMesh);
+    if (m.used && mesh && !mesh->global) FreeMesh(mesh);
+    m = MeshSlot{nullptr, MESHVIS_NEVER, false};
+}
+
+//A visual's copy of a mesh, as the graphics client makes one for every
+//mesh slot of the vessel when the visual is created or the slot is filled.
+static void SetDevMesh(DevMesh &dm, MESHHANDLE hMesh){
+    if (dm.hMesh) {
+        g_context.visual_meshes_live--;
+        g_context.visual_mesh_bytes_live -= dm.buffers.size();
+    }
+    dm.hMesh = hMesh;
+    dm.buffers.clear();
+    dm.buffers.shrink_to_fit();
+    dm.textures.assign(16, nullptr);
+    if (Mesh *mesh = static_cast<Mesh *>(hMesh)) {
+        dm.buffers.assign((size_t)mesh->nvertices * 32 + (size_t)mesh->ntriangles * 6, 0);
+        g_context.visual_meshes_live++;
+        g_context.visual_mesh_bytes_live += dm.buffers.size();
+    }
+}
+
+//Keeps a vessel's visual in step with a change of its mesh slot idx.
+static void UpdateVisualMesh(Vessel *v, UINT idx){
+    if (!v->visual) return;
+    auto &dev = v->visual->meshes;
+    if (idx >= dev.size()) dev.resize(idx + 1, DevMesh{nullptr, std::vector<SURFHANDLE>(16, nullptr), {}});
+    SetDevMesh(dev[idx], v->meshes[idx].used ? v->meshes[idx].hMesh : nullptr);
+}
+
+
+//Files: configuration files are read whole; scenario handles are in memory.
+
+struct File {
+    FileAccessMode mode;
+    std::vector<std::string> lines;
+    size_t next = 0;
+    std::string out;
+    std::vector<char> linebuf;
+    bool scenario = false;
+};
+
+static void TrackFileOpen(){
+    g_context.files_open++;
+    g_context.files_open_peak = std::max(g_context.files_open_peak, g_context.files_open);
+}
+
+FILEHANDLE OpenScenarioIn(const std::vector<std::string> &lines){
+    File *f = new File;
+    f->mode = FILE_IN;
+    f->lines = lines;
+    f->scenario = true;
+    return f;
+}
+
+FILEHANDLE OpenScenarioOut(){
+    File *f = new File;
+    f->mode = FILE_OUT;
+    f->scenario = true;
+    return f;
+}
+
+std::string CloseScenario(FILEHANDLE fh){
+    File *f = static_cast<File *>(fh);
+    std::string out = std::move(f->out);
+    delete f;
+    return out;
+}
+
+static std::string Trim(const std::string &s){
+    size_t b = s.find_first_not_of(" \t\r\n");
+    if (b == std::string::npos) return "";
+    size_t e = s.find_last_not_of(" \t\r\n");
+    return s.substr(b, e - b + 1);
+}
+
+//Finds "ITEM = value" in a configuration file, case-insensitive on the item.
+static bool FindItem(FILEHANDLE fh, const char *item, std::string &val){
+    File *f = static_cast<File *>(fh);
+    if (!f) return false;
+    size_t len = strlen(item);
+    for (const std::string &line : f->lines) {
+        std::string l = Trim(line);
+        if (l.size() <= len || strncasecmp(l.c_str(), item, len)) continue;
+        std::string rest = Trim(l.substr(len));
+        if (rest.empty() || rest[0] != '=') continue;
+        val = Trim(rest.substr(1));
+        return true;
+    }
+    return false;
+}
+
+//XRSound stand-in: remembers what was loaded and is playing.
+
+class HeadlessXRSound : public XRSound {
+
+    public:
+
+        explicit HeadlessXRSound(Vessel *v) : vessel(v) {}
+
+        bool IsPresent() const override { return true; }
+
+        bool LoadWav(const int soundID, const char *pSoundFilespec, const PlaybackType playbackType) override {
+            loaded[soundID] = pSoundFilespec ? pSoundFilespec : "";
+            return true;
+        }
+
+        bool PlayWav(const int soundID, const bool bLoop, const float volume) override {
+            Count(vessel, API_PlayWav);
+            if (!loaded.count(soundID)) return false;
+            playing[soundID] = true;
+            return true;
+        }
+
+        bool StopWav(const int soundID) override {
+            Count(vessel, API_StopWav);
+            playing[soundID] = false;
+            return true;
+        }
+
+        bool IsWavPlaying(const int soundID) const override {
+            auto it = playing.find(soundID);
+            return it != playing.end() && it->second;
+        }
+
+        bool SetDefaultSoundEnabled(const DefaultSoundID soundID, const bool bEnabled) override {
+            defaults[soundID] = bEnabled;
+            return true;
+        }
+
+        bool GetDefaultSoundEnabled(const DefaultSoundID soundID) const override {
+            auto it = defaults.find(soundID);
+            return it == defaults.end() || it->second;
+        }
+
+        Vessel *vessel;
+
+    private:
+
+        std::map<int, std::string> loaded;
+        std::map<int, bool> playing;
+        std::map<int, bool> defaults;
+};
+
+//Modules never delete their XRSound instance; the vessel record owns it.
+static std::multimap<Vessel *, std::unique_ptr<XRSound>> g_sounds;
+
+//Vessel record
+
+Vessel::Vessel(const std::string &_name, const std::string &_className)
+    : name(_name), className(_className) {}
+
+Vessel::~Vessel(){
+    DestroyVisual();
+    g_sounds.erase(this);
+    for (MeshSlot &m : meshes) FreeSlot(m);
+}
+
+ThrusterGroup *Vessel::FindGroup(THGROUP_HANDLE thg) const {
+    for (auto &g : groups)
+        if (g.get() == thg) return g.get();
+    return nullptr;
+}
+
+ThrusterGroup *Vessel::FindGroup(THGROUP_TYPE type) const {
+    for (auto &g : groups)
+        if (g->type == type) return g.get();
+    return nullptr;
+}
+
+void Vessel::Integrate(double dt){
+    for (auto &th : thrusters) {
+        if (!th->prop || th->level <= 0.0 || th->isp <= 0.0) continue;
+        double dm = th->maxth * th->level / (th->isp * th->prop->efficiency) * dt;
+        th->prop->mass = std::max(0.0, th->prop->mass - dm);
+    }
+}
+
+void Vessel::EvaluateAirfoils(){
+    //Sea-level viscosity; good enough for a Reynolds number of the right order.
+    const double mu = 1.79e-5;
+    for (const Airfoil &af : airfoils) {
+        double cl, cm, cd;
+        double angle = af.align == LIFT_VERTICAL ? env.aoa : env.slip;
+        double Re = env.density * env.airspeed * af.c / mu;
+        af.cf(iface, angle, env.mach, Re, af.context, &cl, &cm, &cd);
+    }
+}
+
+VISHANDLE Vessel::CreateVisual(){
+    if (visual) return visual.get();
+    visual.reset(new Visual);
+    visual->meshes.resize(meshes.size(), DevMesh{nullptr, {}, {}});
+    for (UINT i = 0; i < meshes.size(); i++) UpdateVisualMesh(this, i);
+    VISHANDLE vis = visual.get();
+    if (iface) {
+        SetCurrent(this);
+        static_cast<VESSEL2 *>(iface)->clbkVisualCreated(vis, 1);
+        SetCurrent(nullptr);
+    }
+    return vis;
+}
+
+void Vessel::DestroyVisual(){
+    if (!visual) return;
+    if (iface) {
+        SetCurrent(this);
+        static_cast<VESSEL2 *>(iface)->clbkVisualDestroyed(visual.get(), 0);
+        SetCurrent(nullptr);
+    }
+    for (DevMesh &dm : visual->meshes) SetDevMesh(dm, nullptr);
+    visual.reset();
+}
+
+UINT Vessel::ExteriorTriangles() const {
+    UINT n = 0;
+    for (const MeshSlot &m : meshes)
+        if (m.used && m.hMesh && (m.visibility & MESHVIS_EXTERNAL)) n += static_cast<const Mesh *>(m.hMesh)->ndrawn;
+    return n;
+}
+
+UINT Vessel::ExteriorDraws() const {
+    UINT n = 0;
+    for (const MeshSlot &m : meshes)
+        if (m.used && m.hMesh && (m.visibility & MESHVIS_EXTERNAL)) n += static_cast<const Mesh *>(m.hMesh)->ndraws;
+    return n;
+}
+
+UINT Vessel::ExteriorTransforms() const {
+    UINT n = 0;
+    for (const MeshSlot &m : meshes)
+        if (m.used && m.hMesh && (m.visibility & MESHVIS_EXTERNAL)) n += static_cast<const Mesh *>(m.hMesh)->ntransformed;
+    return n;
+}
+
+}
+
+using namespace headless;
+
+//Light emitters
+
+LightEmitter::LightEmitter()
+    : ltype(LT_NONE), visibility(VIS_EXTERNAL), active(true), intensity(1.0),
+      pos{0, 0, 0}, dir{0, 0, 1}, col_diff{1, 1, 1, 0}, col_spec{1, 1, 1, 0}, col_ambi{0, 0, 0, 0},
+      range(0), att0(0), att1(0), att2(0), umbra(0), penumbra(0) {}
+
+LightEmitter::~LightEmitter(){}
+
+bool LightEmitter::Activate(bool act){
+    Count(API_ActivateLightEmitter);
+    active = act;
+    return active;
+}
+
+double LightEmitter::SetIntensity(double in){
+    double old = intensity;
+    intensity = in;
+    return old;
+}
+
+//XRSound
+
+XRSound *XRSound::CreateInstance(VESSEL *pVessel){
+    Vessel *v = pVessel ? V(pVessel->GetHandle()) : nullptr;
+    XRSound *snd = new HeadlessXRSound(v);
+    g_sounds.emplace(v, std::unique_ptr<XRSound>(snd));
+    return snd;
+}
+
+//Logging
+
+void oapiWriteLog(const char *line){
+    FILE *f = fopen(g_context.logfile.c_str(), "a");
+    if (f) {
+        fprintf(f, "%s\n", line);
+        fclose(f);
+    }
+    if (g_context.echo_log) fprintf(stderr, "%s\n", line);
+}
+
+void oapiWriteLogV(const char *format, ...){
+    char buf[1024];
+    va_list ap;
+    va_start(ap, format);
+    vsnprintf(buf, sizeof(buf), format, ap);
+    va_end(ap);
+    oapiWriteLog(buf);
+}
+
+//Simulation state
+
+double oapiGetSimTime(){ return g_context.simt; }
+double oapiGetSimStep(){ return g_context.simdt; }
+double oapiGetTimeAcceleration(){ return g_context.warp; }
+OBJHANDLE oapiGetFocusObject(){ return g_context.focus; }
+int oapiCockpitMode(){ return g_context.cockpit_mode; }
+bool oapiCameraInternal(){ return g_context.camera_internal; }
+OBJHANDLE oapiCameraTarget(){ return g_context.focus; }
+void oapiCameraGlobalPos(VECTOR3 *gpos){ *gpos = g_context.camera_gpos; }
+
+void oapiGetGlobalPos(OBJHANDLE hObj, VECTOR3 *pos){
+    *pos = hObj ? V(hObj)->env.gpos : _V(0, 0, 0);
+}
+
+//Aerodynamics helpers, same formulas as the simulator.
+
+double oapiGetInducedDrag(double cl, double A, double e){
+    return cl*cl/(PI*A*e);
+}
+
+double oapiGetWaveDrag(double M, double M1, double M2, double M3, double cmax){
+    if (M < M1) return 0.0;
+    if (M < M2) return cmax*(M - M1)/(M2 - M1);
+    if (M < M3) return cmax;
+    return cmax*std::sqrt((M3*M3 - 1.0)/(M*M - 1.0));
+}
+
+//Meshes and textures
+
+MESHHANDLE oapiLoadMesh(const char *fname){
+    Count(API_LoadMesh);
+    return ParseMesh(fname);
+}
+
+//As in Orbiter, the mesh takes the group's arrays, which the caller
+//allocated with new[]. A group must use the materials and textures
+//the mesh was loaded with.
+DWORD oapiAddMeshGroup(MESHHANDLE hMesh, MESHGROUP *grp){
+    Count(API_AddMeshGroup);
+    Mesh *mesh = static_cast<Mesh *>(hMesh);
+    if (!mesh || !grp) return (DWORD)-1;
+    if ((grp->MtrlIdx != SPEC_DEFAULT && grp->MtrlIdx >= mesh->nmaterials) ||
+        (grp->TexIdx != SPEC_DEFAULT && grp->TexIdx >= mesh->textures.size()))
+        oapiWriteLogV("Headless: group %u of %s has no material or texture %u/%u", mesh->ngroups, mesh->name.c_str(), grp->MtrlIdx, grp->TexIdx);
+    size_t bytes = (size_t)grp->nVtx * sizeof(NTVERTEX) + (size_t)grp->nIdx * sizeof(WORD) + sizeof(MESHGROUP);
+    mesh->nvertices += grp->nVtx;
+    mesh->ntriangles += grp->nIdx/3;
+    if (!(grp->UsrFlag & 2)) mesh->ndrawn += grp->nIdx/3;
+    if (!(grp->UsrFlag & 2) && grp->nIdx) mesh->ndraws++;
+    if (!(grp->UsrFlag & 2)) mesh->ntransformed += CacheMisses(grp->Idx, grp->nIdx);
+    mesh->bytes += bytes;
+    g_context.mesh_bytes_live += bytes;
+    delete[] grp->Vtx;
+    delete[] grp->Idx;
+    return mesh->ngroups++;
+}
+
+DWORD oapiMeshGroupCount(MESHHANDLE hMesh){
+    Mesh *mesh = static_cast<Mesh *>(hMesh);
+    return mesh ? mesh->ngroups : 0;
+}
+
+DWORD oapiMeshMaterialCount(MESHHANDLE hMesh){
+    Mesh *mesh = static_cast<Mesh *>(hMesh);
+    return mesh ? mesh->nmaterials : 0;
+}
+
+MESHHANDLE oapiLoadMeshGlobal(const char *fname){
+    Count(API_LoadMesh);
+    auto it = g_global_meshes.find(fname);
+    if (it != g_global_meshes.end()) return it->second;
+    Mesh *mesh = ParseMesh(fname);
+    if (mesh) {
+        mesh->global = true;
+        g_global_meshes[fname] = mesh;
+    }
+    return mesh;
+}
+
+void oapiDeleteMesh(MESHHANDLE hMesh){
+    Mesh *mesh = static_cast<Mesh *>(hMesh);
+    if (mesh && !mesh->global) FreeMesh(mesh);
+}
+
+SURFHANDLE oapiLoadTexture(const char *fname, bool dynamic){
+    Count(API_LoadTexture);
+    return ReadTexture(fname);
+}
+
+void oapiReleaseTexture(SURFHANDLE hTex){
+    Count(API_ReleaseTexture);
+    Texture *tex = static_cast<Texture *>(hTex);
+    if (tex) FreeTexture(tex);
+}
+
+//As in Orbiter, only the textures the mesh was loaded with can be replaced.
+bool oapiSetTexture(MESHHANDLE hMesh, DWORD texidx, SURFHANDLE tex){
+    Count(API_SetTexture);
+    Mesh *mesh = static_cast<Mesh *>(hMesh);
+    if (!mesh || texidx >= mesh->textures.size()) return false;
+    mesh->textures[texidx] = tex;
+    return true;
+}
+
+bool oapiSetTexture(DEVMESHHANDLE hMesh, DWORD texidx, SURFHANDLE tex){
+    Count(API_SetTexture);
+    DevMesh *dm = reinterpret_cast<DevMesh *>(hMesh);
+    if (!dm) return false;
+    if (texidx >= dm->textures.size()) dm->textures.resize(texidx + 1, nullptr);
+    dm->textures[texidx] = tex;
+    return true;
+}
+
+SURFHANDLE oapiRegisterExhaustTexture(const char *name){
+    static int dummy;
+    return &dummy;
+}
+
+//Virtual cockpit
+
+void oapiVCRegisterMFD(int mfd, const VCMFDSPEC *spec){
+    Count(API_VCRegisterMFD);
+}
+
+void oapiVCSetNeighbours(int left, int right, int top, int bottom){}
+
+//Files
+
+FILEHANDLE oapiOpenFile(const char *fname, FileAccessMode mode, PathRoot root){
+    static const char *dirs[] = {"", "Config", "Scenarios", "Textures", "Textures2", "Meshes", "Modules"};
+    Count(API_OpenFile);
+    std::ifstream in;
+    if (mode == FILE_IN || mode == FILE_IN_ZEROONFAIL) {
+        in.open(ResolvePath(dirs[root], fname));
+        if (!in && mode == FILE_IN_ZEROONFAIL) return nullptr;
+    }
+    File *f = new File;
+    f->mode = mode;
+    std::string line;
+    while (in && std::getline(in, line)) f->lines.push_back(line);
+    TrackFileOpen();
+    return f;
+}
+
+void oapiCloseFile(FILEHANDLE fh, FileAccessMode mode){
+    Count(API_CloseFile);
+    File *f = static_cast<File *>(fh);
+    if (!f) return;
+    g_context.files_open--;
+    delete f;
+}
+
+bool oapiReadItem_string(FILEHANDLE f, const char *item, char *val){
+    std::string s;
+    if (!FindItem(f, item, s)) return false;
+    strcpy(val, s.c_str());
+    return true;
+}
+
+bool oapiReadItem_int(FILEHANDLE f, const char *item, int &val){
+    std::string s;
+    if (!FindItem(f, item, s)) return false;
+    return sscanf(s.c_str(), "%d", &val) == 1;
+}
+
+bool oapiReadItem_float(FILEHANDLE f, const char *item, double &val){
+    std::string s;
+    if (!FindItem(f, item, s)) return false;
+    return sscanf(s.c_str(), "%lf", &val) == 1;
+}
+
+bool oapiReadItem_bool(FILEHANDLE f, const char *item, bool &val){
+    std::string s;
+    if (!FindItem(f, item, s)) return false;
+    val = !strcasecmp(s.c_str(), "TRUE");
+    return true;
+}
+
+bool oapiReadScenario_nextline(FILEHANDLE scn, char *&line){
+    File *f = static_cast<File *>(scn);
+    while (f && f->next < f->lines.size()) {
+        std::string l = Trim(f->lines[f->next++]);
+        if (l.empty()) continue;
+        if (!strcasecmp(l.c_str(), "END")) return false;
+        f->linebuf.assign(l.begin(), l.end());
+        f->linebuf.push_back('\0');
+        line = f->linebuf.data();
+        return true;
+    }
+    return false;
+}
+
+void oapiWriteScenario_string(FILEHANDLE scn, const char *item, const char *string){
+    File *f = static_cast<File *>(scn);
+    f->out += "  ";
+    f->out += item;
+    f->out += ' ';
+    f->out += string;
+    f->out += '\n';
+}
+
+void oapiWriteScenario_int(FILEHANDLE scn, const char *item, int i){
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%d", i);
+    oapiWriteScenario_string(scn, item, buf);
+}
+
+void oapiWriteScenario_float(FILEHANDLE scn, const char *item, double d){
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%g", d);
+    oapiWriteScenario_string(scn, item, buf);
+}
+
+//VESSEL
+
+VESSEL::VESSEL(OBJHANDLE hVessel, int fmodel) : hObj(hVessel), flightmodel(fmodel) {
+    V(hVessel)->iface = this;
+}
+
+VESSEL::~VESSEL(){}
+
+const char *VESSEL::GetName() const { return V(hObj)->name.c_str(); }
+const char *VESSEL::GetClassName() const { return V(hObj)->className.c_str(); }
+
+void VESSEL::SetSize(double size) const { V(hObj)->size = size; }
+double VESSEL::GetSize() const { return V(hObj)->size; }
+void VESSEL::SetEmptyMass(double m) const { V(hObj)->emptymass = m; }
+double VESSEL::GetEmptyMass() const { return V(hObj)->emptymass; }
+void VESSEL::SetCrossSections(const VECTOR3 &cs) const {}
+void VESSEL::SetPMI(const VECTOR3 &pmi) const {}
+void VESSEL::SetRotDrag(const VECTOR3 &rd) const {}
+void VESSEL::SetMaxWheelbrakeForce(double f) const {}
+
+void VESSEL::SetWheelbrakeLevel(double level, int which, bool permanent) const {
+    Count(V(hObj), API_SetWheelbrakeLevel);
+    V(hObj)->wheelbrake = level;
+}
+
+void VESSEL::SetNosewheelSteering(bool activate) const {
+    Count(V(hObj), API_SetNosewheelSteering);
+    V(hObj)->nosewheelsteering = activate;
+}
+
+void VESSEL::SetTouchdownPoints(const TOUCHDOWNVTX *tdvtx, DWORD ntdvtx) const {
+    Count(V(hObj), API_SetTouchdownPoints);
+    V(hObj)->touchdown.assign(tdvtx, tdvtx + ntdvtx);
+    V(hObj)->touchdown_sets++;
+}
+
+double VESSEL::GetMachNumber() const { Count(V(hObj), API_GetMachNumber); return V(hObj)->env.mach; }
+double VESSEL::GetAltitude() const { Count(V(hObj), API_GetAltitude); return V(hObj)->env.altitude; }
+double VESSEL::GetGroundspeed() const { Count(V(hObj), API_GetGroundspeed); return V(hObj)->env.groundspeed; }
+double VESSEL::GetAirspeed() const { Count(V(hObj), API_GetAirspeed); return V(hObj)->env.airspeed; }
+double VESSEL::GetAOA() const { Count(V(hObj), API_GetAOA); return V(hObj)->env.aoa; }
+double VESSEL::GetSlipAngle() const { return V(hObj)->env.slip; }
+double VESSEL::GetBank() const { Count(V(hObj), API_GetBank); return V(hObj)->env.bank; }
+double VESSEL::GetPitch() const { return V(hObj)->env.pitch; }
+double VESSEL::GetAtmDensity() const { return V(hObj)->env.density; }
+
+double VESSEL::GetDynPressure() const {
+    Count(V(hObj), API_GetDynPressure);
+    const Environment &env = V(hObj)->env;
+    return 0.5*env.density*env.airspeed*env.airspeed;
+}
+
+double VESSEL::GetFuelMass() const {
+    Count(V(hObj), API_GetFuelMass);
+    double m = 0.0;
+    for (auto &p : V(hObj)->propellants) m += p->mass;
+    return m;
+}
+
+double VESSEL::GetMass() const {
+    double m = V(hObj)->emptymass;
+    for (auto &p : V(hObj)->propellants) m += p->mass;
+    return m;
+}
+
+void VESSEL::GetGlobalPos(VECTOR3 &pos) const { pos = V(hObj)->env.gpos; }
+
+//Propellant and thrusters
+
+PROPELLANT_HANDLE VESSEL::CreatePropellantResource(double maxmass, double mass, double efficiency) const {
+    Propellant *p = new Propellant{maxmass, mass < 0.0 ? maxmass : mass, efficiency};
+    V(hObj)->propellants.emplace_back(p);
+    return p;
+}
+
+double VESSEL::GetPropellantMass(PROPELLANT_HANDLE ph) const {
+    return ph ? static_cast<Propellant *>(ph)->mass : 0.0;
+}
+
+double VESSEL::GetPropellantMaxMass(PROPELLANT_HANDLE ph) const {
+    return ph ? static_cast<Propellant *>(ph)->maxmass : 0.0;
+}
+
+THRUSTER_HANDLE VESSEL::CreateThruster(const VECTOR3 &pos, const VECTOR3 &dir, double maxth0, PROPELLANT_HANDLE hp, double isp0, double isp_ref, double p_ref) const {
+    Count(V(hObj), API_CreateThruster);
+    Thruster *th = new Thruster{pos, dir, maxth0, isp0, static_cast<Propellant *>(hp), 0.0};
+    V(hObj)->thrusters.emplace_back(th);
+    return th;
+}
+
+//Modules occasionally pass a group handle here; unknown handles read as 0.
+static Thruster *FindThruster(Vessel *v, THRUSTER_HANDLE th){
+    for (auto &t : v->thrusters)
+        if (t.get() == th) return t.get();
+    return nullptr;
+}
+
+double VESSEL::GetThrusterLevel(THRUSTER_HANDLE th) const {
+    Count(V(hObj), API_GetThrusterLevel);
+    Thruster *t = FindThruster(V(hObj), th);
+    return t ? t->level : 0.0;
+}
+
+void VESSEL::SetThrusterLevel(THRUSTER_HANDLE th, double level) const {
+    Thruster *t = FindThruster(V(hObj), th);
+    if (t) t->level = std::clamp(level, 0.0, 1.0);
+}
+
+THGROUP_HANDLE VESSEL::CreateThrusterGroup(THRUSTER_HANDLE *th, int nth, THGROUP_TYPE thgt) const {
+    Count(V(hObj), API_CreateThrusterGroup);
+    ThrusterGroup *g = new ThrusterGroup;
+    g->type = thgt;
+    for (int i = 0; i < nth; i++) g->thrusters.push_back(static_cast<Thruster *>(th[i]));
+    //A new group of a standard type replaces the previous one, which is left dangling.
+    V(hObj)->groups.emplace_back(g);
+    return g;
+}
+
+bool VESSEL::DelThrusterGroup(THGROUP_HANDLE thg, bool delth) const {
+    Count(V(hObj), API_DelThrusterGroup);
+    auto &groups = V(hObj)->groups;
+    for (auto it = groups.begin(); it != groups.end(); ++it) {
+        if (it->get() == thg) {
+            for (Thruster *t : (*it)->thrusters) t->level = 0.0;
+            groups.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool VESSEL::DelThrusterGroup(THGROUP_TYPE thgt, bool delth) const {
+    ThrusterGroup *g = V(hObj)->FindGroup(thgt);
+    return DelThrusterGroup(g, delth);
+}
+
+THGROUP_HANDLE VESSEL::GetThrusterGroupHandle(THGROUP_TYPE thgt) const {
+    auto &groups = V(hObj)->groups;
+    for (auto it = groups.rbegin(); it != groups.rend(); ++it)
+        if ((*it)->type == thgt) return it->get();
+    return nullptr;
+}
+
+static double GroupLevel(const ThrusterGroup *g){
+    if (!g || g->thrusters.empty()) return 0.0;
+    double lvl = 0.0;
+    for (const Thruster *t : g->thrusters) lvl += t->level;
+    return lvl/g->thrusters.size();
+}
+
+double VESSEL::GetThrusterGroupLevel(THGROUP_HANDLE thg) const {
+    Count(V(hObj), API_GetThrusterGroupLevel);
+    return GroupLevel(V(hObj)->FindGroup(thg));
+}
+
+double VESSEL::GetThrusterGroupLevel(THGROUP_TYPE thgt) const {
+    return GetThrusterGroupLevel(GetThrusterGroupHandle(thgt));
+}
+
+void VESSEL::SetThrusterGroupLevel(THGROUP_HANDLE thg, double level) const {
+    Count(V(hObj), API_SetThrusterGroupLevel);
+    ThrusterGroup *g = V(hObj)->FindGroup(thg);
+    if (!g) return;
+    for (Thruster *t : g->thrusters) t->level = std::clamp(level, 0.0, 1.0);
+}
+
+void VESSEL::SetThrusterGroupLevel(THGROUP_TYPE thgt, double level) const {
+    SetThrusterGroupLevel(GetThrusterGroupHandle(thgt), level);
+}
+
+UINT VESSEL::AddExhaust(THRUSTER_HANDLE th, double lscale, double wscale, const VECTOR3 &pos, const VECTOR3 &dir, SURFHANDLE tex) const {
+    return 0;
+}
+
+PSTREAM_HANDLE VESSEL::AddExhaustStream(THRUSTER_HANDLE th, const VECTOR3 &pos, PARTICLESTREAMSPEC *pss) const {
+    static int dummy;
+    return &dummy;
+}
+
+PSTREAM_HANDLE VESSEL::AddParticleStream(PARTICLESTREAMSPEC *pss, const VECTOR3 &pos, const VECTOR3 &dir, double *lvl) const {
+    static int dummy;
+    return &dummy;
+}
+
+//Aerodynamics
+
+AIRFOILHANDLE VESSEL::CreateAirfoil3(AIRFOIL_ORIENTATION align, const VECTOR3 &ref, AirfoilCoeffFuncEx cf, void *context, double c, double S, double A) const {
+    auto &airfoils = V(hObj)->airfoils;
+    airfoils.push_back(Airfoil{align, ref, cf, context, c, S, A});
+    return reinterpret_cast<AIRFOILHANDLE>(airfoils.size());
+}
+
+CTRLSURFHANDLE VESSEL::CreateControlSurface3(AIRCTRL_TYPE type, double area, double dCl, const VECTOR3 &ref, int axis, double delay, UINT anim) const {
+    static int dummy;
+    return &dummy;
+}
+
+double VESSEL::GetControlSurfaceLevel(AIRCTRL_TYPE type) const {
+    Count(V(hObj), API_GetControlSurfaceLevel);
+    return (type >= 0 && type < 6) ? V(hObj)->env.ctrl_level[type] : 0.0;
+}
+
+//Docking
+
+DOCKHANDLE VESSEL::CreateDock(const VECTOR3 &pos, const VECTOR3 &dir, const VECTOR3 &rot) const {
+    static int dummy;
+    return &dummy;
+}
+
+void VESSEL::SetDockParams(const VECTOR3 &pos, const VECTOR3 &dir, const VECTOR3 &rot) const {}
+void VESSEL::SetDockParams(DOCKHANDLE dock, const VECTOR3 &pos, const VECTOR3 &dir, const VECTOR3 &rot) const {}
+
+//Meshes
+
+UINT VESSEL::AddMesh(MESHHANDLE hMesh, const VECTOR3 *ofs) const {
+    Count(V(hObj), API_AddMesh);
+    auto &meshes = V(hObj)->meshes;
+    for (UINT i = 0; i < meshes.size(); i++) {
+        if (!meshes[i].used) {
+            meshes[i] = MeshSlot{SlotMesh(hMesh), MESHVIS_EXTERNAL, true};
+            UpdateVisualMesh(V(hObj), i);
+            return i;
+        }
+    }
+    meshes.push_back(MeshSlot{SlotMesh(hMesh), MESHVIS_EXTERNAL, true});
+    UpdateVisualMesh(V(hObj), (UINT)meshes.size() - 1);
+    return (UINT)meshes.size() - 1;
+}
+
+UINT VESSEL::AddMesh(const char *meshname, const VECTOR3 *ofs) const {
+    return AddMesh(oapiLoadMeshGlobal(meshname), ofs);
+}
+
+UINT VESSEL::InsertMesh(MESHHANDLE hMesh, UINT idx, const VECTOR3 *ofs) const {
+    Count(V(hObj), API_AddMesh);
+    auto &meshes = V(hObj)->meshes;
+    if (idx >= meshes.size()) meshes.resize(idx + 1, MeshSlot{nullptr, MESHVIS_NEVER, false});
+    FreeSlot(meshes[idx]);
+    meshes[idx] = MeshSlot{SlotMesh(hMesh), MESHVIS_EXTERNAL, true};
+    UpdateVisualMesh(V(hObj), idx);
+    return idx;
+}
+
+bool VESSEL::DelMesh(UINT idx, bool retain_anim) const {
+    Count(V(hObj), API_DelMesh);
+    auto &meshes = V(hObj)->meshes;
+    if (idx >= meshes.size() || !meshes[idx].used) return false;
+    FreeSlot(meshes[idx]);
+    UpdateVisualMesh(V(hObj), idx);
+    return true;
+}
+
+void VESSEL::SetMeshVisibilityMode(UINT idx, WORD mode) const {
+    Count(V(hObj), API_SetMeshVisibilityMode);
+    auto &meshes = V(hObj)->meshes;
+    if (idx < meshes.size()) meshes[idx].visibility = mode;
+}
+
+DEVMESHHANDLE VESSEL::GetDevMesh(VISHANDLE vis, UINT idx) const {
+    Count(V(hObj), API_GetDevMesh);
+    Visual *visual = static_cast<Visual *>(vis);
+    if (!visual || idx >= visual->meshes.size()) return nullptr;
+    return reinterpret_cast<DEVMESHHANDLE>(&visual->meshes[idx]);
+}
+
+//Animations
+
+UINT VESSEL::CreateAnimation(double initial_state) const {
+    Count(V(hObj), API_CreateAnimation);
+    auto &anims = V(hObj)->animations;
+    anims.emplace_back();
+    anims.back().state = initial_state;
+    return (UINT)anims.size() - 1;
+}
+
+bool VESSEL::DelAnimation(UINT anim) const {
+    auto &anims = V(hObj)->animations;
+    if (anim >= anims.size() || !anims[anim].defined) return false;
+    anims[anim].defined = false;
+    anims[anim].comps.clear();
+    return true;
+}
+
+ANIMATIONCOMPONENT_HANDLE VESSEL::AddAnimationComponent(UINT anim, double state0, double state1, MGROUP_TRANSFORM *trans, ANIMATIONCOMPONENT_HANDLE parent) const {
+    Count(V(hObj), API_AddAnimationComponent);
+    auto &anims = V(hObj)->animations;
+    if (anim >= anims.size()) return nullptr;
+    anims[anim].comps.push_back(AnimationComponent{state0, state1, trans});
+    return trans;
+}
+
+bool VESSEL::SetAnimation(UINT anim, double state) const {
+    Count(V(hObj), API_SetAnimation);
+    auto &anims = V(hObj)->animations;
+    if (anim >= anims.size()) return false;
+    anims[anim].state = state;
+    return true;
+}
+
+double VESSEL::GetAnimation(UINT anim) const {
+    Count(V(hObj), API_GetAnimation);
+    auto &anims = V(hObj)->animations;
+    return anim < anims.size() ? anims[anim].state : 0.0;
+}
+
+//Lights
+
+void VESSEL::AddBeacon(BEACONLIGHTSPEC *bs){
+    V(hObj)->beacons.push_back(bs);
+}
+
+bool VESSEL::DelBeacon(BEACONLIGHTSPEC *bs){
+    auto &beacons = V(hObj)->beacons;
+    auto it = std::find(beacons.begin(), beacons.end(), bs);
+    if (it == beacons.end()) return false;
+    beacons.erase(it);
+    return true;
+}
+
+LightEmitter *VESSEL::AddPointLight(const VECTOR3 &pos, double range, double att0, double att1, double att2, COLOUR4 diffuse, COLOUR4 specular, COLOUR4 ambient) const {
+    Count(V(hObj), API_AddLightEmitter);
+    LightEmitter *le = new LightEmitter;
+    le->ltype = LightEmitter::LT_POINT;
+    le->pos = pos;
+    le->range = range;
+    le->att0 = att0; le->att1 = att1; le->att2 = att2;
+    le->col_diff = diffuse; le->col_spec = specular; le->col_ambi = ambient;
+    V(hObj)->lights.emplace_back(le);
+    return le;
+}
+
+LightEmitter *VESSEL::AddSpotLight(const VECTOR3 &pos, const VECTOR3 &dir, double range, double att0, double att1, double att2, double umbra, double penumbra, COLOUR4 diffuse, COLOUR4 specular, COLOUR4 ambient) const {
+    Count(V(hObj), API_AddLightEmitter);
+    LightEmitter *le = new LightEmitter;
+    le->ltype = LightEmitter::LT_SPOT;
+    le->pos = pos;
+    le->dir = dir;
+    le->range = range;
+    le->att0 = att0; le->att1 = att1; le->att2 = att2;
+    le->umbra = umbra; le->penumbra = penumbra;
+    le->col_diff = diffuse; le->col_spec = specular; le->col_ambi = ambient;
+    V(hObj)->lights.emplace_back(le);
+    return le;
+}
+
+bool VESSEL::DelLightEmitter(LightEmitter *le) const {
+    Count(V(hObj), API_DelLightEmitter);
+    auto &lights = V(hObj)->lights;
+    for (auto it = lights.begin(); it != lights.end(); ++it) {
+        if (it->get() == le) {
+            lights.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+//Camera
+
+void VESSEL::SetCameraOffset(const VECTOR3 &co) const {}
+void VESSEL::SetCameraDefaultDirection(const VECTOR3 &cd) const {}
+void VESSEL::SetCameraRotationRange(double left, double right, double up, double down) const {}
+
+//Scenario state
+
+void VESSEL::SaveDefaultState(FILEHANDLE scn) const {
+    oapiWriteScenario_string(scn, "STATUS", "Landed Earth");
+}
+
+void VESSEL::ParseScenarioLineEx(char *line, void *status) const {}
+
+//VESSEL2 default callbacks
+
+VESSEL2::VESSEL2(OBJHANDLE hVessel, int fmodel) : VESSEL(hVessel, fmodel) {}
+
+void VESSEL2::clbkSetClassCaps(FILEHANDLE cfg){}
+void VESSEL2::clbkSaveState(FILEHANDLE scn){ SaveDefaultState(scn); }
+
+void VESSEL2::clbkLoadStateEx(FILEHANDLE scn, void *status){
+    char *line;
+    while (oapiReadScenario_nextline(scn, line)) ParseScenarioLineEx(line, status);
+}
+
+void VESSEL2::clbkPostCreation(){}
+void VESSEL2::clbkFocusChanged(bool getfocus, OBJHANDLE hNewVessel, OBJHANDLE hOldVessel){}
+void VESSEL2::clbkPreStep(double simt, double simdt, double mjd){}
+void VESSEL2::clbkPostStep(double simt, double simdt, double mjd){}
+void VESSEL2::clbkVisualCreated(VISHANDLE vis, int refcount){}
+void VESSEL2::clbkVisualDestroyed(VISHANDLE vis, int refcount){}
+int VESSEL2::clbkConsumeBufferedKey(int key, bool down, char *kstate){ return 0; }
+bool VESSEL2::clbkLoadVC(int id){ return false; }
+
+VESSEL3::VESSEL3(OBJHANDLE hVessel, int fmodel) : VESSEL2(hVessel, fmodel) {}
+
+VESSEL4::VESSEL4(OBJHANDLE hVessel, int fmodel) : VESSEL3(hVessel, fmodel) {}
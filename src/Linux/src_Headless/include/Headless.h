@@ -0,0 +1,246 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          HEADLESS ORBITER STAND-IN
+//
+//Headless.h
+//Driver-side view of the stand-in: the vessel records behind each
+//OBJHANDLE, the simulated environment and the API call counters.
+//Vessel modules never include this file.
+//
+//==========================================
+
+#pragma once
+
+#ifndef __HEADLESS_H
+#define __HEADLESS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Orbitersdk.h"
+
+namespace headless {
+
+//API calls counted per vessel. Keep the list sorted by subsystem.
+#define HEADLESS_API_CALLS(X) \
+    X(SetTouchdownPoints) \
+    X(SetNosewheelSteering) \
+    X(SetWheelbrakeLevel) \
+    X(GetMachNumber) \
+    X(GetAltitude) \
+    X(GetGroundspeed) \
+    X(GetAirspeed) \
+    X(GetAOA) \
+    X(GetBank) \
+    X(GetDynPressure) \
+    X(GetControlSurfaceLevel) \
+    X(GetFuelMass) \
+    X(CreateThruster) \
+    X(GetThrusterLevel) \
+    X(CreateThrusterGroup) \
+    X(DelThrusterGroup) \
+    X(GetThrusterGroupLevel) \
+    X(SetThrusterGroupLevel) \
+    X(CreateAnimation) \
+    X(AddAnimationComponent) \
+    X(SetAnimation) \
+    X(GetAnimation) \
+    X(AddMesh) \
+    X(DelMesh) \
+    X(SetMeshVisibilityMode) \
+    X(GetDevMesh) \
+    X(AddLightEmitter) \
+    X(DelLightEmitter) \
+    X(ActivateLightEmitter) \
+    X(LoadTexture) \
+    X(ReleaseTexture) \
+    X(SetTexture) \
+    X(LoadMesh) \
+    X(AddMeshGroup) \
+    X(OpenFile) \
+    X(CloseFile) \
+    X(VCRegisterMFD) \
+    X(PlayWav) \
+    X(StopWav)
+
+enum Api {
+#define HEADLESS_API_ENUM(name) API_##name,
+    HEADLESS_API_CALLS(HEADLESS_API_ENUM)
+#undef HEADLESS_API_ENUM
+    API_COUNT
+};
+
+const char *ApiName(int api);
+
+struct Counters {
+    uint64_t calls[API_COUNT] = {};
+
+    void Reset() { for (auto &c : calls) c = 0; }
+    uint64_t Total() const;
+    Counters &operator+= (const Counters &o);
+};
+
+//Flight conditions the driver imposes on a vessel.
+struct Environment {
+    double mach = 0.0;
+    double altitude = 0.0;
+    double groundspeed = 0.0;
+    double airspeed = 0.0;
+    double aoa = 0.0;
+    double slip = 0.0;
+    double bank = 0.0;
+    double pitch = 0.0;
+    double density = 1.225;
+    double ctrl_level[6] = {};        //GetControlSurfaceLevel, by AIRCTRL_TYPE
+    VECTOR3 gpos = {0, 0, 0};
+};
+
+struct AnimationComponent {
+    double state0, state1;
+    MGROUP_TRANSFORM *trans;
+};
+
+struct Animation {
+    double state = 0.0;
+    bool defined = true;
+    std::vector<AnimationComponent> comps;
+};
+
+struct Propellant {
+    double maxmass, mass, efficiency;
+};
+
+struct Thruster {
+    VECTOR3 pos, dir;
+    double maxth, isp;
+    Propellant *prop;
+    double level;
+};
+
+struct ThrusterGroup {
+    THGROUP_TYPE type;
+    std::vector<Thruster *> thrusters;
+};
+
+struct Airfoil {
+    AIRFOIL_ORIENTATION align;
+    VECTOR3 ref;
+    AirfoilCoeffFuncEx cf;
+    void *context;
+    double c, S, A;
+};
+
+struct MeshSlot {
+    MESHHANDLE hMesh;
+    WORD visibility;
+    bool used;
+};
+
+struct DevMesh {
+    MESHHANDLE hMesh;
+    std::vector<SURFHANDLE> textures;
+    std::vector<char> buffers;   //The vertex and index copy the client keeps per visual
+};
+
+struct Visual {
+    std::vector<DevMesh> meshes;
+};
+
+//Record behind one OBJHANDLE.
+struct Vessel {
+    Vessel(const std::string &name, const std::string &className);
+    ~Vessel();
+
+    std::string name;
+    std::string className;
+    VESSEL *iface = nullptr;
+    Environment env;
+    Counters counters;
+
+    double size = 0.0, emptymass = 0.0;
+    double wheelbrake = 0.0;
+    bool nosewheelsteering = false;
+    std::vector<TOUCHDOWNVTX> touchdown;
+    uint64_t touchdown_sets = 0;      //SetTouchdownPoints calls, not reset by --steady-after
+
+    std::vector<std::unique_ptr<Propellant>> propellants;
+    std::vector<std::unique_ptr<Thruster>> thrusters;
+    std::vector<std::unique_ptr<ThrusterGroup>> groups;
+    std::vector<Airfoil> airfoils;
+    std::vector<Animation> animations;
+    std::vector<MeshSlot> meshes;
+    std::vector<BEACONLIGHTSPEC *> beacons;
+    std::vector<std::unique_ptr<LightEmitter>> lights;
+    std::unique_ptr<Visual> visual;
+
+    ThrusterGroup *FindGroup(THGROUP_HANDLE thg) const;
+    ThrusterGroup *FindGroup(THGROUP_TYPE type) const;
+
+    //Advances propellant consumption by dt seconds.
+    void Integrate(double dt);
+
+    //Evaluates every airfoil callback once, as the simulator does per step.
+    void EvaluateAirfoils();
+
+    //Creates or drops the visual and calls the matching vessel callbacks.
+    VISHANDLE CreateVisual();
+    void DestroyVisual();
+
+    //Triangles drawn from outside: those of the meshes shown there, less
+    //the groups flagged not to render.
+    UINT ExteriorTriangles() const;
+
+    //Draw calls for them, one per group with triangles to draw.
+    UINT ExteriorDraws() const;
+
+    //Vertices a 16 entry FIFO vertex cache transforms to draw them.
+    UINT ExteriorTransforms() const;
+};
+
+//Process-wide simulation state.
+struct Context {
+    std::string root = ".";
+    std::string logfile = "Orbiter.log";
+    bool echo_log = false;
+
+    double simt = 0.0;
+    double simdt = 0.0;
+    double warp = 1.0;
+
+    OBJHANDLE focus = nullptr;
+    int cockpit_mode = COCKPIT_GENERIC;
+    bool camera_internal = false;
+    VECTOR3 camera_gpos = {0, 0, 0};
+
+    //Resource accounting
+    size_t textures_live = 0, textures_peak = 0;
+    size_t texture_bytes_live = 0, texture_bytes_peak = 0;
+    size_t meshes_live = 0;
+    size_t mesh_bytes_live = 0;
+    size_t visual_meshes_live = 0;
+    size_t visual_mesh_bytes_live = 0;
+    size_t files_open = 0, files_open_peak = 0;
+    Counters global;
+};
+
+Context &GetContext();
+
+//Vessel currently executing a callback; API counters are charged to it.
+Vessel *Current();
+void SetCurrent(Vessel *v);
+
+//Resolves a path relative to the Orbiter root. Backslashes become slashes.
+std::string ResolvePath(const char *dir, const char *fname, const char *ext = nullptr);
+
+//In-memory scenario handles for clbkLoadStateEx/clbkSaveState.
+FILEHANDLE OpenScenarioIn(const std::vector<std::string> &lines);
+FILEHANDLE OpenScenarioOut();
+std::string CloseScenario(FILEHANDLE f);
+
+}
+
+#endif
@@ -0,0 +1,399 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          HEADLESS ORBITER STAND-IN
+//
+//OrbiterAPI.h
+//Subset of the Orbiter API types and oapi* functions used by the
+//Boeing 747 modules, so they can be built and stepped without the
+//simulator. Signatures follow the Orbitersdk headers.
+//
+//==========================================
+
+#pragma once
+
+#ifndef __ORBITERAPI_H
+#define __ORBITERAPI_H
+
+#include <cstdint>
+#include <cmath>
+
+#define DLLCLBK extern "C" __attribute__((visibility("default")))
+#define OAPIFUNC __attribute__((visibility("default")))
+
+typedef uint8_t BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef unsigned int UINT;
+
+const double PI = 3.14159265358979323846;
+const double PI05 = 1.57079632679489661923;
+const double PI2 = 6.28318530717958647693;
+const double RAD = PI/180.0;
+const double DEG = 180.0/PI;
+const double G = 6.67259e-11;
+
+//Handles
+typedef void *OBJHANDLE;
+typedef void *VISHANDLE;
+typedef void *MESHHANDLE;
+typedef struct DEVMESH *DEVMESHHANDLE;  //A distinct type, as in the SDK, so oapiSetTexture can take either
+typedef void *SURFHANDLE;
+typedef void *FILEHANDLE;
+typedef void *MODULEHANDLE;
+typedef void *THRUSTER_HANDLE;
+typedef void *THGROUP_HANDLE;
+typedef void *PROPELLANT_HANDLE;
+typedef void *AIRFOILHANDLE;
+typedef void *CTRLSURFHANDLE;
+typedef void *DOCKHANDLE;
+typedef void *PSTREAM_HANDLE;
+typedef void *ANIMATIONCOMPONENT_HANDLE;
+
+//Vectors and colours
+typedef union {
+    double data[3];
+    struct { double x, y, z; };
+} VECTOR3;
+
+inline VECTOR3 _V(double x, double y, double z){
+    VECTOR3 v = {x, y, z};
+    return v;
+}
+
+inline VECTOR3 operator+ (const VECTOR3 &a, const VECTOR3 &b){ return _V(a.x+b.x, a.y+b.y, a.z+b.z); }
+inline VECTOR3 operator- (const VECTOR3 &a, const VECTOR3 &b){ return _V(a.x-b.x, a.y-b.y, a.z-b.z); }
+inline VECTOR3 operator* (const VECTOR3 &a, double f){ return _V(a.x*f, a.y*f, a.z*f); }
+inline double dotp(const VECTOR3 &a, const VECTOR3 &b){ return a.x*b.x + a.y*b.y + a.z*b.z; }
+inline double length(const VECTOR3 &a){ return std::sqrt(dotp(a, a)); }
+inline double dist(const VECTOR3 &a, const VECTOR3 &b){ return length(a - b); }
+
+typedef struct {
+    float r, g, b, a;
+} COLOUR4;
+
+//Mesh groups, for the groups added with oapiAddMeshGroup
+#define SPEC_DEFAULT ((DWORD)(-1))
+#define MAXTEX 1
+
+typedef struct {
+    float x, y, z;
+    float nx, ny, nz;
+    float tu, tv;
+} NTVERTEX;
+
+typedef struct {
+    NTVERTEX *Vtx;
+    WORD *Idx;
+    DWORD nVtx;
+    DWORD nIdx;
+    DWORD MtrlIdx;
+    DWORD TexIdx;
+    DWORD UsrFlag;
+    WORD zBias;
+    WORD Flags;
+    DWORD TexIdxEx[MAXTEX];
+    float TexMixEx[MAXTEX];
+} MESHGROUP;
+
+typedef struct {
+    COLOUR4 diffuse;
+    COLOUR4 ambient;
+    COLOUR4 specular;
+    COLOUR4 emissive;
+    float power;
+} MATERIAL;
+
+//Scenario and configuration files
+enum FileAccessMode { FILE_IN, FILE_OUT, FILE_APP, FILE_IN_ZEROONFAIL };
+enum PathRoot { ROOT, CONFIG, SCENARIOS, TEXTURES, TEXTURES2, MESHES, MODULES };
+
+//Touchdown points
+typedef struct {
+    VECTOR3 pos;
+    double stiffness;
+    double damping;
+    double mu;
+    double mu_lng;
+} TOUCHDOWNVTX;
+
+//Beacons
+#define BEACONSHAPE_COMPACT 0
+#define BEACONSHAPE_DIFFUSE 1
+#define BEACONSHAPE_STAR 2
+
+typedef struct {
+    DWORD shape;
+    VECTOR3 *pos;
+    VECTOR3 *col;
+    double size;
+    double falloff;
+    double period;
+    double duration;
+    double tofs;
+    bool active;
+} BEACONLIGHTSPEC;
+
+//Particle streams
+typedef struct {
+    DWORD flags;
+    double srcsize;
+    double srcrate;
+    double v0;
+    double srcspread;
+    double lifetime;
+    double growthrate;
+    double atmslowdown;
+    enum LTYPE { EMISSIVE, DIFFUSE } ltype;
+    enum LEVELMAP { LVL_FLAT, LVL_LIN, LVL_SQRT, LVL_PLIN, LVL_PSQRT } levelmap;
+    double lmin, lmax;
+    enum ATMSMAP { ATM_FLAT, ATM_PLIN, ATM_PLOG } atmsmap;
+    double amin, amax;
+    SURFHANDLE tex;
+} PARTICLESTREAMSPEC;
+
+//Virtual cockpit MFDs
+typedef struct {
+    DWORD nmesh;
+    DWORD ngroup;
+} VCMFDSPEC;
+
+#define MFD_LEFT 0
+#define MFD_RIGHT 1
+#define MAXMFD 12
+
+//Mesh visibility
+#define MESHVIS_NEVER 0x00
+#define MESHVIS_EXTERNAL 0x01
+#define MESHVIS_COCKPIT 0x02
+#define MESHVIS_ALWAYS (MESHVIS_EXTERNAL | MESHVIS_COCKPIT)
+#define MESHVIS_VC 0x04
+#define MESHVIS_EXTPASS 0x10
+
+//Cockpit modes
+#define COCKPIT_GENERIC 1
+#define COCKPIT_PANELS 2
+#define COCKPIT_VIRTUAL 3
+
+//Airfoils and control surfaces
+enum AIRFOIL_ORIENTATION { LIFT_VERTICAL, LIFT_HORIZONTAL };
+
+enum AIRCTRL_TYPE {
+    AIRCTRL_ELEVATOR, AIRCTRL_RUDDER, AIRCTRL_AILERON, AIRCTRL_FLAP,
+    AIRCTRL_ELEVATORTRIM, AIRCTRL_RUDDERTRIM
+};
+
+#define AIRCTRL_AXIS_AUTO 0
+#define AIRCTRL_AXIS_YPOS 1
+#define AIRCTRL_AXIS_YNEG 2
+#define AIRCTRL_AXIS_XPOS 3
+#define AIRCTRL_AXIS_XNEG 4
+
+class VESSEL;
+typedef void (*AirfoilCoeffFuncEx)(VESSEL *v, double aoa, double M, double Re, void *context, double *cl, double *cm, double *cd);
+
+//Thruster groups
+enum THGROUP_TYPE {
+    THGROUP_MAIN, THGROUP_RETRO, THGROUP_HOVER,
+    THGROUP_ATT_PITCHUP, THGROUP_ATT_PITCHDOWN, THGROUP_ATT_YAWLEFT, THGROUP_ATT_YAWRIGHT,
+    THGROUP_ATT_BANKLEFT, THGROUP_ATT_BANKRIGHT, THGROUP_ATT_RIGHT, THGROUP_ATT_LEFT,
+    THGROUP_ATT_UP, THGROUP_ATT_DOWN, THGROUP_ATT_FORWARD, THGROUP_ATT_BACK,
+    THGROUP_USER = 0x40
+};
+
+//Light emitters
+class OAPIFUNC LightEmitter {
+    public:
+        enum TYPE { LT_NONE, LT_POINT, LT_SPOT, LT_DIRECTIONAL };
+        enum VISIBILITY { VIS_EXTERNAL = 1, VIS_COCKPIT = 2, VIS_ALWAYS = 3 };
+
+        LightEmitter();
+        virtual ~LightEmitter();
+
+        TYPE GetType() const { return ltype; }
+        bool Activate(bool act);
+        bool IsActive() const { return active; }
+        void SetVisibility(VISIBILITY vis) { visibility = vis; }
+        VISIBILITY GetVisibility() const { return visibility; }
+        double GetIntensity() const { return intensity; }
+        double SetIntensity(double in);
+
+    protected:
+        TYPE ltype;
+        VISIBILITY visibility;
+        bool active;
+        double intensity;
+        VECTOR3 pos;
+        VECTOR3 dir;
+        COLOUR4 col_diff, col_spec, col_ambi;
+        double range;
+        double att0, att1, att2;
+        double umbra, penumbra;
+
+        friend class VESSEL;
+};
+
+//Keyboard
+#define OAPI_KEY_ESCAPE      0x01
+#define OAPI_KEY_1           0x02
+#define OAPI_KEY_2           0x03
+#define OAPI_KEY_3           0x04
+#define OAPI_KEY_4           0x05
+#define OAPI_KEY_5           0x06
+#define OAPI_KEY_6           0x07
+#define OAPI_KEY_7           0x08
+#define OAPI_KEY_8           0x09
+#define OAPI_KEY_9           0x0A
+#define OAPI_KEY_0           0x0B
+#define OAPI_KEY_MINUS       0x0C
+#define OAPI_KEY_EQUALS      0x0D
+#define OAPI_KEY_BACK        0x0E
+#define OAPI_KEY_TAB         0x0F
+#define OAPI_KEY_Q           0x10
+#define OAPI_KEY_W           0x11
+#define OAPI_KEY_E           0x12
+#define OAPI_KEY_R           0x13
+#define OAPI_KEY_T           0x14
+#define OAPI_KEY_Y           0x15
+#define OAPI_KEY_U           0x16
+#define OAPI_KEY_I           0x17
+#define OAPI_KEY_O           0x18
+#define OAPI_KEY_P           0x19
+#define OAPI_KEY_LBRACKET    0x1A
+#define OAPI_KEY_RBRACKET    0x1B
+#define OAPI_KEY_RETURN      0x1C
+#define OAPI_KEY_LCONTROL    0x1D
+#define OAPI_KEY_A           0x1E
+#define OAPI_KEY_S           0x1F
+#define OAPI_KEY_D           0x20
+#define OAPI_KEY_F           0x21
+#define OAPI_KEY_G           0x22
+#define OAPI_KEY_H           0x23
+#define OAPI_KEY_J           0x24
+#define OAPI_KEY_K           0x25
+#define OAPI_KEY_L           0x26
+#define OAPI_KEY_SEMICOLON   0x27
+#define OAPI_KEY_APOSTROPHE  0x28
+#define OAPI_KEY_GRAVE       0x29
+#define OAPI_KEY_LSHIFT      0x2A
+#define OAPI_KEY_BACKSLASH   0x2B
+#define OAPI_KEY_Z           0x2C
+#define OAPI_KEY_X           0x2D
+#define OAPI_KEY_C           0x2E
+#define OAPI_KEY_V           0x2F
+#define OAPI_KEY_B           0x30
+#define OAPI_KEY_N           0x31
+#define OAPI_KEY_M           0x32
+#define OAPI_KEY_COMMA       0x33
+#define OAPI_KEY_PERIOD      0x34
+#define OAPI_KEY_SLASH       0x35
+#define OAPI_KEY_RSHIFT      0x36
+#define OAPI_KEY_MULTIPLY    0x37
+#define OAPI_KEY_LALT        0x38
+#define OAPI_KEY_SPACE       0x39
+#define OAPI_KEY_CAPITAL     0x3A
+#define OAPI_KEY_F1          0x3B
+#define OAPI_KEY_F2          0x3C
+#define OAPI_KEY_F3          0x3D
+#define OAPI_KEY_F4          0x3E
+#define OAPI_KEY_F5          0x3F
+#define OAPI_KEY_F6          0x40
+#define OAPI_KEY_F7          0x41
+#define OAPI_KEY_F8          0x42
+#define OAPI_KEY_F9          0x43
+#define OAPI_KEY_F10         0x44
+#define OAPI_KEY_NUMLOCK     0x45
+#define OAPI_KEY_SCROLL      0x46
+#define OAPI_KEY_NUMPAD7     0x47
+#define OAPI_KEY_NUMPAD8     0x48
+#define OAPI_KEY_NUMPAD9     0x49
+#define OAPI_KEY_SUBTRACT    0x4A
+#define OAPI_KEY_NUMPAD4     0x4B
+#define OAPI_KEY_NUMPAD5     0x4C
+#define OAPI_KEY_NUMPAD6     0x4D
+#define OAPI_KEY_ADD         0x4E
+#define OAPI_KEY_NUMPAD1     0x4F
+#define OAPI_KEY_NUMPAD2     0x50
+#define OAPI_KEY_NUMPAD3     0x51
+#define OAPI_KEY_NUMPAD0     0x52
+#define OAPI_KEY_DECIMAL     0x53
+#define OAPI_KEY_F11         0x57
+#define OAPI_KEY_F12         0x58
+#define OAPI_KEY_NUMPADENTER 0x9C
+#define OAPI_KEY_RCONTROL    0x9D
+#define OAPI_KEY_DIVIDE      0xB5
+#define OAPI_KEY_RALT        0xB8
+#define OAPI_KEY_HOME        0xC7
+#define OAPI_KEY_UP          0xC8
+#define OAPI_KEY_PRIOR       0xC9
+#define OAPI_KEY_LEFT        0xCB
+#define OAPI_KEY_RIGHT       0xCD
+#define OAPI_KEY_END         0xCF
+#define OAPI_KEY_DOWN        0xD0
+#define OAPI_KEY_NEXT        0xD1
+#define OAPI_KEY_INSERT      0xD2
+#define OAPI_KEY_DELETE      0xD3
+
+#define KEYDOWN(buf, key) (buf[key] & 0x80)
+#define KEYMOD_LSHIFT(buf) (KEYDOWN(buf, OAPI_KEY_LSHIFT))
+#define KEYMOD_RSHIFT(buf) (KEYDOWN(buf, OAPI_KEY_RSHIFT))
+#define KEYMOD_SHIFT(buf) (KEYMOD_LSHIFT(buf) || KEYMOD_RSHIFT(buf))
+#define KEYMOD_LCONTROL(buf) (KEYDOWN(buf, OAPI_KEY_LCONTROL))
+#define KEYMOD_RCONTROL(buf) (KEYDOWN(buf, OAPI_KEY_RCONTROL))
+#define KEYMOD_CONTROL(buf) (KEYMOD_LCONTROL(buf) || KEYMOD_RCONTROL(buf))
+#define KEYMOD_LALT(buf) (KEYDOWN(buf, OAPI_KEY_LALT))
+#define KEYMOD_RALT(buf) (KEYDOWN(buf, OAPI_KEY_RALT))
+#define KEYMOD_ALT(buf) (KEYMOD_LALT(buf) || KEYMOD_RALT(buf))
+
+//oapi* functions
+
+//Logging
+OAPIFUNC void oapiWriteLog(const char *line);
+OAPIFUNC void oapiWriteLogV(const char *format, ...);
+
+//Simulation state
+OAPIFUNC double oapiGetSimTime();
+OAPIFUNC double oapiGetSimStep();
+OAPIFUNC double oapiGetTimeAcceleration();
+OAPIFUNC OBJHANDLE oapiGetFocusObject();
+OAPIFUNC int oapiCockpitMode();
+OAPIFUNC bool oapiCameraInternal();
+OAPIFUNC OBJHANDLE oapiCameraTarget();
+OAPIFUNC void oapiCameraGlobalPos(VECTOR3 *gpos);
+OAPIFUNC void oapiGetGlobalPos(OBJHANDLE hObj, VECTOR3 *pos);
+
+//Aerodynamics helpers
+OAPIFUNC double oapiGetInducedDrag(double cl, double A, double e);
+OAPIFUNC double oapiGetWaveDrag(double M, double M1, double M2, double M3, double cmax);
+
+//Meshes and textures
+OAPIFUNC MESHHANDLE oapiLoadMesh(const char *fname);
+OAPIFUNC MESHHANDLE oapiLoadMeshGlobal(const char *fname);
+OAPIFUNC DWORD oapiAddMeshGroup(MESHHANDLE hMesh, MESHGROUP *grp);
+OAPIFUNC DWORD oapiMeshGroupCount(MESHHANDLE hMesh);
+OAPIFUNC DWORD oapiMeshMaterialCount(MESHHANDLE hMesh);
+OAPIFUNC void oapiDeleteMesh(MESHHANDLE hMesh);
+OAPIFUNC SURFHANDLE oapiLoadTexture(const char *fname, bool dynamic = false);
+OAPIFUNC void oapiReleaseTexture(SURFHANDLE hTex);
+OAPIFUNC bool oapiSetTexture(MESHHANDLE hMesh, DWORD texidx, SURFHANDLE tex);
+OAPIFUNC bool oapiSetTexture(DEVMESHHANDLE hMesh, DWORD texidx, SURFHANDLE tex);
+OAPIFUNC SURFHANDLE oapiRegisterExhaustTexture(const char *name);
+
+//Virtual cockpit
+OAPIFUNC void oapiVCRegisterMFD(int mfd, const VCMFDSPEC *spec);
+OAPIFUNC void oapiVCSetNeighbours(int left, int right, int top, int bottom);
+
+//Files
+OAPIFUNC FILEHANDLE oapiOpenFile(const char *fname, FileAccessMode mode, PathRoot root = ROOT);
+OAPIFUNC void oapiCloseFile(FILEHANDLE f, FileAccessMode mode);
+OAPIFUNC bool oapiReadItem_string(FILEHANDLE f, const char *item, char *val);
+OAPIFUNC bool oapiReadItem_int(FILEHANDLE f, const char *item, int &val);
+OAPIFUNC bool oapiReadItem_float(FILEHANDLE f, const char *item, double &val);
+OAPIFUNC bool oapiReadItem_bool(FILEHANDLE f, const char *item, bool &val);
+OAPIFUNC bool oapiReadScenario_nextline(FILEHANDLE scn, char *&line);
+OAPIFUNC void oapiWriteScenario_string(FILEHANDLE scn, const char *item, const char *string);
+OAPIFUNC void oapiWriteScenario_int(FILEHANDLE scn, const char *item, int i);
+OAPIFUNC void oapiWriteScenario_float(FILEHANDLE scn, const char *item, double d);
+
+#endif
@@ -0,0 +1,20 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          HEADLESS ORBITER STAND-IN
+//
+//Orbitersdk.h
+//Umbrella header, same role as the one shipped with Orbitersdk.
+//
+//==========================================
+
+#pragma once
+
+#ifndef __ORBITERSDK_H
+#define __ORBITERSDK_H
+
+#include "OrbiterAPI.h"
+#include "VesselAPI.h"
+
+#endif
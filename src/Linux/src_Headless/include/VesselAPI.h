@@ -0,0 +1,208 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          HEADLESS ORBITER STAND-IN
+//
+//VesselAPI.h
+//VESSEL/VESSEL2/VESSEL3/VESSEL4 interface subset used by the
+//Boeing 747 modules. Every call lands in the headless vessel
+//record that the OBJHANDLE points to.
+//
+//==========================================
+
+#pragma once
+
+#ifndef __VESSELAPI_H
+#define __VESSELAPI_H
+
+#include "OrbiterAPI.h"
+
+//Animation transforms
+
+class OAPIFUNC MGROUP_TRANSFORM {
+    public:
+        enum TYPE { NULLTRANSFORM, ROTATE, TRANSLATE, SCALE };
+
+        MGROUP_TRANSFORM() : mesh(0), grp(0), ngrp(0) {}
+        MGROUP_TRANSFORM(UINT _mesh, UINT *_grp, UINT _ngrp) : mesh(_mesh), grp(_grp), ngrp(_ngrp) {}
+        virtual ~MGROUP_TRANSFORM() {}
+        virtual TYPE Type() const { return NULLTRANSFORM; }
+
+        UINT mesh;
+        UINT *grp;
+        UINT ngrp;
+};
+
+class OAPIFUNC MGROUP_ROTATE : public MGROUP_TRANSFORM {
+    public:
+        MGROUP_ROTATE(UINT _mesh, UINT *_grp, UINT _ngrp, const VECTOR3 &_ref, const VECTOR3 &_axis, float _angle)
+            : MGROUP_TRANSFORM(_mesh, _grp, _ngrp), ref(_ref), axis(_axis), angle(_angle) {}
+        TYPE Type() const override { return ROTATE; }
+
+        VECTOR3 ref;
+        VECTOR3 axis;
+        float angle;
+};
+
+class OAPIFUNC MGROUP_TRANSLATE : public MGROUP_TRANSFORM {
+    public:
+        MGROUP_TRANSLATE(UINT _mesh, UINT *_grp, UINT _ngrp, const VECTOR3 &_shift)
+            : MGROUP_TRANSFORM(_mesh, _grp, _ngrp), shift(_shift) {}
+        TYPE Type() const override { return TRANSLATE; }
+
+        VECTOR3 shift;
+};
+
+class OAPIFUNC MGROUP_SCALE : public MGROUP_TRANSFORM {
+    public:
+        MGROUP_SCALE(UINT _mesh, UINT *_grp, UINT _ngrp, const VECTOR3 &_ref, const VECTOR3 &_scale)
+            : MGROUP_TRANSFORM(_mesh, _grp, _ngrp), ref(_ref), scale(_scale) {}
+        TYPE Type() const override { return SCALE; }
+
+        VECTOR3 ref;
+        VECTOR3 scale;
+};
+
+//VESSEL class interface
+
+class OAPIFUNC VESSEL {
+
+    public:
+
+        VESSEL(OBJHANDLE hVessel, int fmodel = 1);
+        virtual ~VESSEL();
+
+        OBJHANDLE GetHandle() const { return hObj; }
+        const char *GetName() const;
+        const char *GetClassName() const;
+        int GetFlightModel() const { return flightmodel; }
+
+        //Physical parameters
+        void SetSize(double size) const;
+        double GetSize() const;
+        void SetEmptyMass(double m) const;
+        double GetEmptyMass() const;
+        void SetCrossSections(const VECTOR3 &cs) const;
+        void SetPMI(const VECTOR3 &pmi) const;
+        void SetRotDrag(const VECTOR3 &rd) const;
+        void SetMaxWheelbrakeForce(double f) const;
+        void SetWheelbrakeLevel(double level, int which = 0, bool permanent = true) const;
+        void SetNosewheelSteering(bool activate) const;
+        void SetTouchdownPoints(const TOUCHDOWNVTX *tdvtx, DWORD ntdvtx) const;
+
+        //Flight state
+        double GetMachNumber() const;
+        double GetAltitude() const;
+        double GetGroundspeed() const;
+        double GetAirspeed() const;
+        double GetAOA() const;
+        double GetSlipAngle() const;
+        double GetBank() const;
+        double GetPitch() const;
+        double GetDynPressure() const;
+        double GetAtmDensity() const;
+        double GetMass() const;
+        double GetFuelMass() const;
+        void GetGlobalPos(VECTOR3 &pos) const;
+
+        //Propellant and thrusters
+        PROPELLANT_HANDLE CreatePropellantResource(double maxmass, double mass = -1.0, double efficiency = 1.0) const;
+        double GetPropellantMass(PROPELLANT_HANDLE ph) const;
+        double GetPropellantMaxMass(PROPELLANT_HANDLE ph) const;
+        THRUSTER_HANDLE CreateThruster(const VECTOR3 &pos, const VECTOR3 &dir, double maxth0, PROPELLANT_HANDLE hp = NULL, double isp0 = 0.0, double isp_ref = 0.0, double p_ref = 101.4e3) const;
+        double GetThrusterLevel(THRUSTER_HANDLE th) const;
+        void SetThrusterLevel(THRUSTER_HANDLE th, double level) const;
+        THGROUP_HANDLE CreateThrusterGroup(THRUSTER_HANDLE *th, int nth, THGROUP_TYPE thgt) const;
+        bool DelThrusterGroup(THGROUP_HANDLE thg, bool delth = false) const;
+        bool DelThrusterGroup(THGROUP_TYPE thgt, bool delth = false) const;
+        THGROUP_HANDLE GetThrusterGroupHandle(THGROUP_TYPE thgt) const;
+        double GetThrusterGroupLevel(THGROUP_HANDLE thg) const;
+        double GetThrusterGroupLevel(THGROUP_TYPE thgt) const;
+        void SetThrusterGroupLevel(THGROUP_HANDLE thg, double level) const;
+        void SetThrusterGroupLevel(THGROUP_TYPE thgt, double level) const;
+        UINT AddExhaust(THRUSTER_HANDLE th, double lscale, double wscale, const VECTOR3 &pos, const VECTOR3 &dir, SURFHANDLE tex = 0) const;
+        PSTREAM_HANDLE AddExhaustStream(THRUSTER_HANDLE th, const VECTOR3 &pos, PARTICLESTREAMSPEC *pss = 0) const;
+        PSTREAM_HANDLE AddParticleStream(PARTICLESTREAMSPEC *pss, const VECTOR3 &pos, const VECTOR3 &dir, double *lvl) const;
+
+        //Aerodynamics
+        AIRFOILHANDLE CreateAirfoil3(AIRFOIL_ORIENTATION align, const VECTOR3 &ref, AirfoilCoeffFuncEx cf, void *context, double c, double S, double A) const;
+        double GetControlSurfaceLevel(AIRCTRL_TYPE type) const;
+        CTRLSURFHANDLE CreateControlSurface3(AIRCTRL_TYPE type, double area, double dCl, const VECTOR3 &ref, int axis = AIRCTRL_AXIS_AUTO, double delay = 1.0, UINT anim = (UINT)-1) const;
+
+        //Docking
+        DOCKHANDLE CreateDock(const VECTOR3 &pos, const VECTOR3 &dir, const VECTOR3 &rot) const;
+        void SetDockParams(const VECTOR3 &pos, const VECTOR3 &dir, const VECTOR3 &rot) const;
+        void SetDockParams(DOCKHANDLE dock, const VECTOR3 &pos, const VECTOR3 &dir, const VECTOR3 &rot) const;
+
+        //Meshes
+        UINT AddMesh(MESHHANDLE hMesh, const VECTOR3 *ofs = 0) const;
+        UINT AddMesh(const char *meshname, const VECTOR3 *ofs = 0) const;
+        UINT InsertMesh(MESHHANDLE hMesh, UINT idx, const VECTOR3 *ofs = 0) const;
+        bool DelMesh(UINT idx, bool retain_anim = false) const;
+        void SetMeshVisibilityMode(UINT idx, WORD mode) const;
+        DEVMESHHANDLE GetDevMesh(VISHANDLE vis, UINT idx) const;
+
+        //Animations
+        UINT CreateAnimation(double initial_state) const;
+        bool DelAnimation(UINT anim) const;
+        ANIMATIONCOMPONENT_HANDLE AddAnimationComponent(UINT anim, double state0, double state1, MGROUP_TRANSFORM *trans, ANIMATIONCOMPONENT_HANDLE parent = NULL) const;
+        bool SetAnimation(UINT anim, double state) const;
+        double GetAnimation(UINT anim) const;
+
+        //Lights
+        void AddBeacon(BEACONLIGHTSPEC *bs);
+        bool DelBeacon(BEACONLIGHTSPEC *bs);
+        LightEmitter *AddPointLight(const VECTOR3 &pos, double range, double att0, double att1, double att2, COLOUR4 diffuse, COLOUR4 specular, COLOUR4 ambient) const;
+        LightEmitter *AddSpotLight(const VECTOR3 &pos, const VECTOR3 &dir, double range, double att0, double att1, double att2, double umbra, double penumbra, COLOUR4 diffuse, COLOUR4 specular, COLOUR4 ambient) const;
+        bool DelLightEmitter(LightEmitter *le) const;
+
+        //Camera
+        void SetCameraOffset(const VECTOR3 &co) const;
+        void SetCameraDefaultDirection(const VECTOR3 &cd) const;
+        void SetCameraRotationRange(double left, double right, double up, double down) const;
+
+        //Scenario state
+        void SaveDefaultState(FILEHANDLE scn) const;
+        void ParseScenarioLineEx(char *line, void *status) const;
+
+    private:
+
+        OBJHANDLE hObj;
+        int flightmodel;
+};
+
+class OAPIFUNC VESSEL2 : public VESSEL {
+
+    public:
+
+        VESSEL2(OBJHANDLE hVessel, int fmodel = 1);
+
+        virtual void clbkSetClassCaps(FILEHANDLE cfg);
+        virtual void clbkSaveState(FILEHANDLE scn);
+        virtual void clbkLoadStateEx(FILEHANDLE scn, void *status);
+        virtual void clbkPostCreation();
+        virtual void clbkFocusChanged(bool getfocus, OBJHANDLE hNewVessel, OBJHANDLE hOldVessel);
+        virtual void clbkPreStep(double simt, double simdt, double mjd);
+        virtual void clbkPostStep(double simt, double simdt, double mjd);
+        virtual void clbkVisualCreated(VISHANDLE vis, int refcount);
+        virtual void clbkVisualDestroyed(VISHANDLE vis, int refcount);
+        virtual int clbkConsumeBufferedKey(int key, bool down, char *kstate);
+        virtual bool clbkLoadVC(int id);
+};
+
+class OAPIFUNC VESSEL3 : public VESSEL2 {
+
+    public:
+
+        VESSEL3(OBJHANDLE hVessel, int fmodel = 1);
+};
+
+class OAPIFUNC VESSEL4 : public VESSEL3 {
+
+    public:
+
+        VESSEL4(OBJHANDLE hVessel, int fmodel = 1);
+};
+
+#endif
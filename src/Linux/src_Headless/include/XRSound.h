@@ -0,0 +1,51 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          HEADLESS ORBITER STAND-IN
+//
+//XRSound.h
+//XRSound interface subset used by the Boeing 747 modules. The
+//headless implementation only records which sounds were loaded
+//and played.
+//
+//==========================================
+
+#pragma once
+
+#ifndef __XRSOUND_H
+#define __XRSOUND_H
+
+#include "OrbiterAPI.h"
+
+class VESSEL;
+
+class OAPIFUNC XRSound {
+
+    public:
+
+        enum PlaybackType { InternalOnly, BothViewFar, BothViewMedium, BothViewClose, Radio, Wind, Global };
+
+        enum DefaultSoundID {
+            AudioGreeting = 10000, SwitchOn, SwitchOff, Off, Rotation, Translation,
+            Docking, Undocking, FlightWind, ReentryWind, LandingWind, Touchdown,
+            MainEngines, RetroEngines, HoverEngines, RCSSustain, RCSAttackPlusSustain,
+            Crash, MetalCrunch, WheelChirp, TiresRolling, WheelStop, DockingCallout,
+            UndockingCallout, FuelResupply, FuelCrossfeed, FuelDump, LOXResupply,
+            SubsonicCallout, SonicBoom, MachCallout, DefaultSoundCount
+        };
+
+        static XRSound *CreateInstance(VESSEL *pVessel);
+
+        virtual ~XRSound() {}
+
+        virtual bool IsPresent() const = 0;
+        virtual bool LoadWav(const int soundID, const char *pSoundFilespec, const PlaybackType playbackType) = 0;
+        virtual bool PlayWav(const int soundID, const bool bLoop = false, const float volume = 1.0f) = 0;
+        virtual bool StopWav(const int soundID) = 0;
+        virtual bool IsWavPlaying(const int soundID) const = 0;
+        virtual bool SetDefaultSoundEnabled(const DefaultSoundID soundID, const bool bEnabled) = 0;
+        virtual bool GetDefaultSoundEnabled(const DefaultSoundID soundID) const = 0;
+};
+
+#endif
@@ -0,0 +1,144 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          BOEING 747 TOOLS
+//
+//AeroGen.cpp
+//Writes the aero table file the modules map at InitModule (see
+//B747Aero.h for the format):
+//
+//  b747_aerogen [--out DIR] [--re MIN:STEP:N] [--ratios VA:HA]
+//
+//writes DIR/B747.aero. Every 747 variant has the same wing (VA 7.0) and
+//stabiliser (HA 6.1156) aspect ratios and lift curves, so they share
+//the file. The ratios are recorded in it, and a module whose ratios
+//differ ignores it, so a change to the *_LIFT_A constants must be
+//mirrored here or given with --ratios. --re samples N Reynolds layers
+//from log10(Re) = MIN in steps of STEP; the curves ignore Re, so the
+//default is a single layer.
+//
+//  b747_aerogen --check FILE...
+//
+//maps each file as the modules do and reports why it would be rejected.
+//
+//==========================================
+
+#include "B747Aero.h"
+#include <cerrno>
+#include <cstdlib>
+#include <string>
+#include <sys/stat.h>
+
+//The *_VLIFT_A and *_HLIFT_A of every 747 module.
+const double VLIFT_A = 7.0, HLIFT_A = 6.1156;
+
+static size_t Align(size_t n){
+    return (n + 15) & ~(size_t)15;
+}
+
+static bool MakeDirs(const std::string &dir){
+    for (size_t pos = 1; pos <= dir.size(); pos++) {
+        if (pos < dir.size() && dir[pos] != '/') continue;
+        std::string sub = dir.substr(0, pos);
+        if (mkdir(sub.c_str(), 0755) != 0 && errno != EEXIST) return false;
+    }
+    return true;
+}
+
+static bool Write(const std::string &path, double vlift_A, double hlift_A, const AeroTable *tables[AERO_TABLE_COUNT]){
+    size_t size = Align(sizeof(AeroFileHeader) + AERO_TABLE_COUNT*sizeof(AeroGrid));
+    AeroGrid grids[AERO_TABLE_COUNT];
+    for (int t = 0; t < AERO_TABLE_COUNT; t++) {
+        grids[t] = tables[t]->Grid();
+        grids[t].offset = size;
+        size = Align(size + tables[t]->NodeCount()*sizeof(AeroNode));
+    }
+
+    std::vector<uint8_t> buf(size, 0);
+    AeroFileHeader *h = (AeroFileHeader *)buf.data();
+    memcpy(h->magic, AERO_FILE_MAGIC, sizeof(h->magic));
+    h->version = AERO_FILE_VERSION;
+    h->ntables = AERO_TABLE_COUNT;
+    h->size = size;
+    h->vlift_A = vlift_A;
+    h->hlift_A = hlift_A;
+    memcpy(buf.data() + sizeof(AeroFileHeader), grids, sizeof(grids));
+    for (int t = 0; t < AERO_TABLE_COUNT; t++)
+        memcpy(buf.data() + grids[t].offset, tables[t]->Nodes(), tables[t]->NodeCount()*sizeof(AeroNode));
+    h->checksum = AeroChecksum(buf.data() + 16, size - 16);
+
+    //Write to a temporary name first so a module never maps a half-written file.
+    std::string tmp = path + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = fwrite(buf.data(), 1, size, f) == size;
+    ok = fclose(f) == 0 && ok;
+    return ok && rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+static int Check(const char *fname){
+    AeroPolars polars;
+    const char *err = polars.Map(fname);
+    if (err) {
+        printf("%s %s\n", fname, err);
+        return 1;
+    }
+    const AeroGrid &g = polars.vlift.Grid();
+    const AeroFileHeader *h = polars.Header();
+    printf("%s ok: %u aoa x %u Mach x %u Re nodes per table, A = %g/%g\n", fname, g.naoa, g.nmach, g.nre, h->vlift_A, h->hlift_A);
+    return 0;
+}
+
+static void Usage(){
+    fprintf(stderr,
+        "usage: b747_aerogen [--out DIR] [--re MIN:STEP:N] [--ratios VA:HA]\n"
+        "       b747_aerogen --check FILE...\n");
+}
+
+int main(int argc, char **argv){
+    std::string out = "Config/Boeing747/Aero";
+    AeroGrid grid = AeroTable::DefaultGrid();
+    double vlift_A = VLIFT_A, hlift_A = HLIFT_A;
+    bool check = false;
+    int rc = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if (!strcmp(a, "--out") && i + 1 < argc) out = argv[++i];
+        else if (!strcmp(a, "--check")) check = true;
+        else if (!strcmp(a, "--re") && i + 1 < argc) {
+            if (sscanf(argv[++i], "%lf:%lf:%u", &grid.log10re_min, &grid.log10re_step, &grid.nre) != 3 ||
+                grid.nre < 1 || (grid.nre > 1 && grid.log10re_step <= 0.0)) {
+                Usage();
+                return 2;
+            }
+        } else if (!strcmp(a, "--ratios") && i + 1 < argc) {
+            if (sscanf(argv[++i], "%lf:%lf", &vlift_A, &hlift_A) != 2) {
+                Usage();
+                return 2;
+            }
+        } else if (check && a[0] != '-') {
+            rc |= Check(a);
+        } else {
+            Usage();
+            return 2;
+        }
+    }
+    if (check) return rc;
+
+    if (!MakeDirs(out)) {
+        fprintf(stderr, "cannot create %s\n", out.c_str());
+        return 1;
+    }
+    AeroTable vlift, hlift;
+    vlift.Sample(B747VLiftCurve, vlift_A, grid);
+    hlift.Sample(B747HLiftCurve, hlift_A, grid);
+    const AeroTable *tables[AERO_TABLE_COUNT] = {&vlift, &hlift};
+    std::string path = out + "/" + AERO_FILE_NAME + ".aero";
+    if (!Write(path, vlift_A, hlift_A, tables)) {
+        fprintf(stderr, "cannot write %s\n", path.c_str());
+        return 1;
+    }
+    return 0;
+}
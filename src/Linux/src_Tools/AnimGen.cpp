@@ -0,0 +1,127 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          BOEING 747 TOOLS
+//
+//AnimGen.cpp
+//Compiles the animation text sources into the binary files the modules
+//read at InitModule (see B747Anim.h for both formats):
+//
+//  b747_animgen [--dir DIR] [AIRFRAME]...
+//
+//reads DIR/<airframe>.txt and writes DIR/<airframe>.anim, for every 747
+//variant if no airframe is given. DIR defaults to
+//Config/Boeing747/Animations.
+//
+//  b747_animgen --check FILE...
+//
+//reads each binary file as the modules do and reports why it would be
+//rejected.
+//
+//==========================================
+
+#include "B747Anim.h"
+#include <string>
+
+//Names match the ones each module passes to AnimationSet::Load.
+static const char *const airframes[] = {
+    "B747SP", "B747100", "B747400", "B7478", "B747AAC",
+    "B747LCF", "B747SCA", "B747ST", "B747YAL1", "B747SOFIA",
+};
+
+static bool Write(const std::string &path, const AnimationSet &set, const struct stat &src){
+    const std::vector<AnimRecord> &anims = set.Animations();
+    const std::vector<AnimComponent> &comps = set.Components();
+    const std::vector<uint32_t> &groups = set.Groups();
+
+    AnimFileHeader h = {};
+    memcpy(h.magic, ANIM_FILE_MAGIC, sizeof(h.magic));
+    h.version = ANIM_FILE_VERSION;
+    h.nanims = (uint32_t)anims.size();
+    h.ncomps = (uint32_t)comps.size();
+    h.ngroups = (uint32_t)groups.size();
+    h.source_size = src.st_size;
+    h.source_mtime = src.st_mtime;
+    size_t body = sizeof(h) + anims.size()*sizeof(AnimRecord) + comps.size()*sizeof(AnimComponent) + groups.size()*sizeof(uint32_t);
+    h.size = (body + 7)/8*8;
+
+    std::vector<uint8_t> buf(h.size, 0);
+    uint8_t *p = buf.data();
+    memcpy(p, &h, sizeof(h));
+    p += sizeof(h);
+    if (!anims.empty()) memcpy(p, anims.data(), anims.size()*sizeof(AnimRecord));
+    p += anims.size()*sizeof(AnimRecord);
+    if (!comps.empty()) memcpy(p, comps.data(), comps.size()*sizeof(AnimComponent));
+    p += comps.size()*sizeof(AnimComponent);
+    if (!groups.empty()) memcpy(p, groups.data(), groups.size()*sizeof(uint32_t));
+
+    //Write to a temporary name first so a module never reads a half-written file.
+    std::string tmp = path + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+    ok = fclose(f) == 0 && ok;
+    return ok && rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+static int Check(const char *fname){
+    AnimationSet set;
+    const char *err = set.Read(fname);
+    if (err) {
+        printf("%s %s\n", fname, err);
+        return 1;
+    }
+    printf("%s ok: %d animations, %zu components, %zu groups\n", fname, set.Count(), set.Components().size(), set.Groups().size());
+    return 0;
+}
+
+static int Compile(const std::string &dir, const char *airframe){
+    std::string src = dir + "/" + airframe + ".txt";
+    std::string out = dir + "/" + airframe + ".anim";
+    AnimationSet set;
+    struct stat st;
+    const char *err = set.Parse(src.c_str());
+    if (!err && stat(src.c_str(), &st) != 0) err = "cannot stat";
+    if (err) {
+        fprintf(stderr, "%s: %s\n", src.c_str(), err);
+        return 1;
+    }
+    if (!Write(out, set, st)) {
+        fprintf(stderr, "cannot write %s\n", out.c_str());
+        return 1;
+    }
+    return 0;
+}
+
+static void Usage(){
+    fprintf(stderr,
+        "usage: b747_animgen [--dir DIR] [AIRFRAME]...\n"
+        "       b747_animgen --check FILE...\n");
+}
+
+int main(int argc, char **argv){
+    std::string dir = "Config/Boeing747/Animations";
+    std::vector<const char *> list;
+    bool check = false;
+    int rc = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if (!strcmp(a, "--dir") && i + 1 < argc) dir = argv[++i];
+        else if (!strcmp(a, "--check")) check = true;
+        else if (a[0] == '-') {
+            Usage();
+            return 2;
+        } else if (check) {
+            rc |= Check(a);
+        } else {
+            list.push_back(a);
+        }
+    }
+    if (check) return rc;
+    if (list.empty()) list.assign(std::begin(airframes), std::end(airframes));
+
+    for (const char *airframe : list) rc |= Compile(dir, airframe);
+    return rc;
+}
@@ -0,0 +1,252 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          BOEING 747 TOOLS
+//
+//MeshCheck.cpp
+//Checks the group numbers the modules and animation sources use
+//against the meshes they refer to. The *definitions.h headers are
+//Blender exports whose <name>_Id constants must be the index of the
+//group labelled <name>; an animation component's groups must exist in
+//the mesh it names. Either mistake animates the wrong group without
+//any error in the simulator.
+//
+//  b747_meshcheck [--meshes DIR] [--anims DIR] [--threads N] [--report] [HEADER[=MESH]]...
+//
+//parses every mesh involved concurrently from DIR (default
+//Meshes/Boeing747), then checks each HEADER against MESH, by default the
+//mesh its include guard names (__<mesh>_H), and with --anims every
+//airframe's <airframe>.txt in that directory against the meshes of its
+//module. --report lists every group: vertices, triangles, bounding box,
+//material and texture. Exits with 1 if any check fails.
+//
+//==========================================
+
+#include "B747Anim.h"
+#include "MeshText.h"
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <thread>
+
+//Meshes of each airframe by mesh index, as the module adds them.
+struct AirframeMeshes {
+    const char *airframe;
+    const char *mesh[3];
+};
+
+static const AirframeMeshes airframes[] = {
+    {"B747SP", {"Boeing_747SP", "Boeing_747_cockpit", "Boeing_747_first_class"}},
+    {"B747100", {"Boeing_747_100", "Boeing_747_cockpit", "Boeing_747_first_class"}},
+    {"B747400", {"Boeing_747_400", "Boeing_747_cockpit", "Boeing_747_first_class"}},
+    {"B7478", {"Boeing_747_8", "Boeing_747_cockpit", "Boeing_747_first_class"}},
+    {"B747AAC", {"Boeing_747_AAC", "Boeing_747_cockpit", NULL}},
+    {"B747LCF", {"Boeing_747_LCF", "Boeing_747_cockpit", NULL}},
+    {"B747SCA", {"Boeing_747_SCA", "Boeing_747_cockpit", NULL}},
+    {"B747ST", {"Boeing_747_Supertanker", "Boeing_747_cockpit", NULL}},
+    {"B747YAL1", {"Boeing_747_YAL1", "Boeing_747_cockpit", NULL}},
+    {"B747SOFIA", {"Boeing_747SOFIA", "Boeing_747_cockpit", NULL}},
+};
+
+struct GroupId {
+    std::string name;
+    unsigned int id;
+    int line;
+};
+
+struct Header {
+    std::string path, mesh;
+    std::vector<GroupId> ids;
+};
+
+struct ParsedMesh {
+    TextMesh text;
+    const char *err = NULL;
+    double us = 0.0;
+};
+
+static double Now(){
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//Reads the _Id constants and the include guard of a definitions header.
+static bool ReadHeader(Header &h){
+    FILE *f = fopen(h.path.c_str(), "r");
+    if (!f) return false;
+    char line[512], name[256];
+    unsigned int id;
+    int lineno = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        if (sscanf(line, " const UINT %255s = %u;", name, &id) == 2) {
+            size_t len = strlen(name);
+            if (len > 3 && !strcmp(name + len - 3, "_Id")) h.ids.push_back({std::string(name, len - 3), id, lineno});
+        } else if (h.mesh.empty() && sscanf(line, " #ifndef __%255s", name) == 1) {
+            size_t len = strlen(name);
+            if (len > 2 && !strcmp(name + len - 2, "_H")) h.mesh = std::string(name, len - 2);
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+static void Report(const std::string &name, const TextMesh &m){
+    for (size_t i = 0; i < m.groups.size(); i++) {
+        const TextGroup &g = m.groups[i];
+        printf("  %-14s %3zu %-32s %6zu vtx %6zu tri  (%8.3f %8.3f %8.3f)-(%8.3f %8.3f %8.3f)  %-24s %s\n",
+            name.c_str(), i, g.label.c_str(), g.vtx.size(), g.idx.size()/3,
+            g.lo[0], g.lo[1], g.lo[2], g.hi[0], g.hi[1], g.hi[2],
+            g.material ? m.material_names[g.material - 1].c_str() : "-",
+            g.texture ? m.textures[g.texture - 1].c_str() : "-");
+    }
+}
+
+static void Usage(){
+    fprintf(stderr, "usage: b747_meshcheck [--meshes DIR] [--anims DIR] [--threads N] [--report] [HEADER[=MESH]]...\n");
+}
+
+int main(int argc, char **argv){
+    std::string dir = "Meshes/Boeing747", anims;
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+    bool report = false;
+    std::vector<Header> headers;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if (!strcmp(a, "--meshes") && i + 1 < argc) dir = argv[++i];
+        else if (!strcmp(a, "--anims") && i + 1 < argc) anims = argv[++i];
+        else if (!strcmp(a, "--threads") && i + 1 < argc) threads = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(a, "--report")) report = true;
+        else if (a[0] == '-') {
+            Usage();
+            return 2;
+        } else {
+            Header h;
+            const char *eq = strchr(a, '=');
+            h.path = eq ? std::string(a, eq - a) : a;
+            if (eq) h.mesh = eq + 1;
+            headers.push_back(h);
+        }
+    }
+    if (headers.empty() && anims.empty()) {
+        Usage();
+        return 2;
+    }
+
+    double t0 = Now();
+    int failures = 0;
+
+    //Every mesh the checks need, parsed once each, several at a time.
+    std::map<std::string, ParsedMesh> meshes;
+    for (Header &h : headers) {
+        if (!ReadHeader(h)) {
+            printf("FAIL %s: not found\n", h.path.c_str());
+            failures++;
+            continue;
+        }
+        if (h.mesh.empty()) {
+            printf("FAIL %s: no include guard names its mesh, give HEADER=MESH\n", h.path.c_str());
+            failures++;
+            continue;
+        }
+        meshes[h.mesh];
+    }
+    if (!anims.empty())
+        for (const AirframeMeshes &af : airframes)
+            for (const char *m : af.mesh)
+                if (m) meshes[m];
+
+    std::vector<std::pair<const std::string, ParsedMesh> *> work;
+    for (auto &m : meshes) work.push_back(&m);
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> pool;
+    for (unsigned int t = 0; t < std::min<size_t>(threads, work.size()); t++)
+        pool.emplace_back([&](){
+            for (size_t i; (i = next++) < work.size();) {
+                ParsedMesh &pm = work[i]->second;
+                std::string path = dir + "/" + work[i]->first + ".msh";
+                double t = Now();
+                pm.err = pm.text.Parse(path.c_str());
+                pm.us = Now() - t;
+            }
+        });
+    for (std::thread &t : pool) t.join();
+    double t_parse = Now() - t0;
+
+    for (auto &m : meshes) {
+        const ParsedMesh &pm = m.second;
+        if (pm.err) {
+            printf("FAIL %s/%s.msh: %s\n", dir.c_str(), m.first.c_str(), pm.err);
+            failures++;
+            continue;
+        }
+        size_t nv = 0, nt = 0;
+        for (const TextGroup &g : pm.text.groups) {
+            nv += g.vtx.size();
+            nt += g.idx.size()/3;
+        }
+        printf("%-24s %3zu groups %6zu vertices %6zu triangles %3zu materials %3zu textures %8.1f ms\n", m.first.c_str(),
+            pm.text.groups.size(), nv, nt, pm.text.materials.size(), pm.text.textures.size(), pm.us/1000.0);
+        if (report) Report(m.first, pm.text);
+    }
+
+    //Every _Id must be the index of the group with its label.
+    size_t nids = 0;
+    for (const Header &h : headers) {
+        auto it = meshes.find(h.mesh);
+        if (it == meshes.end() || it->second.err) continue;
+        const std::vector<TextGroup> &groups = it->second.text.groups;
+        for (const GroupId &gid : h.ids) {
+            nids++;
+            if (gid.id < groups.size() && groups[gid.id].label == gid.name) continue;
+            int actual = -1;
+            for (size_t i = 0; i < groups.size(); i++)
+                if (groups[i].label == gid.name) actual = (int)i;
+            printf("FAIL %s:%d: %s_Id = %u is ", h.path.c_str(), gid.line, gid.name.c_str(), gid.id);
+            if (gid.id < groups.size()) printf("group '%s' of %s", groups[gid.id].label.c_str(), h.mesh.c_str());
+            else printf("past the %zu groups of %s", groups.size(), h.mesh.c_str());
+            if (actual >= 0) printf(", %s is group %d\n", gid.name.c_str(), actual);
+            else printf(", which has no group %s\n", gid.name.c_str());
+            failures++;
+        }
+    }
+
+    //Every animation component must name groups its mesh has.
+    size_t ncomps = 0;
+    if (!anims.empty())
+        for (const AirframeMeshes &af : airframes) {
+            std::string src = anims + "/" + af.airframe + ".txt";
+            AnimationSet set;
+            if (const char *err = set.Parse(src.c_str())) {
+                printf("FAIL %s: %s\n", src.c_str(), err);
+                failures++;
+                continue;
+            }
+            const std::vector<uint32_t> &groups = set.Groups();
+            for (const AnimRecord &a : set.Animations())
+                for (uint32_t c = a.first; c < a.first + a.count; c++) {
+                    const AnimComponent &comp = set.Components()[c];
+                    ncomps++;
+                    const char *mesh = comp.mesh < 3 ? af.mesh[comp.mesh] : NULL;
+                    if (!mesh) {
+                        printf("FAIL %s: animation %s uses mesh %u, which the module does not add\n", src.c_str(), a.name, comp.mesh);
+                        failures++;
+                        continue;
+                    }
+                    const ParsedMesh &pm = meshes[mesh];
+                    if (pm.err) continue;
+                    for (uint32_t g = comp.first; g < comp.first + comp.count; g++)
+                        if (groups[g] >= pm.text.groups.size()) {
+                            printf("FAIL %s: animation %s uses group %u, past the %zu groups of %s\n",
+                                src.c_str(), a.name, groups[g], pm.text.groups.size(), mesh);
+                            failures++;
+                        }
+                }
+        }
+
+    printf("%zu ids in %zu headers and %zu animation components against %zu meshes: %d failure(s), "
+        "%.1f ms (%.1f ms parsing on %u threads)\n", nids, headers.size(), ncomps, meshes.size(), failures,
+        (Now() - t0)/1000.0, t_parse/1000.0, threads);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,654 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          BOEING 747 TOOLS
+//
+//MeshGen.cpp
+//Compiles the MSHX1 text meshes into the binary files the modules map
+//at load time (see B747Mesh.h for the format):
+//
+//  b747_meshgen [--dir DIR] [--merge ANIMS] [--lods N] [MESH]...
+//
+//reads DIR/<mesh>.msh and writes DIR/<mesh>.mshb, for every .msh in DIR
+//if no mesh is given. DIR defaults to Meshes/Boeing747. It also writes
+//the template the modules build the mesh onto, DIR/<mesh>_materials.msh:
+//the MATERIALS and TEXTURES of the source, copied as they are, and no
+//groups.
+//
+//With --merge, the groups no animation of mesh 0 in the source ANIMS
+//moves and that render alike (same MATERIAL, TEXTURE, FLAG and ZBIAS,
+//opaque material) are merged into the first of them, so the client
+//draws them in one call. A merged group keeps its slot, empty and
+//flagged not to render, so the group numbers the *definitions.h headers
+//and the animation sources give stay those of the text mesh, which the
+//modules fall back to without the compiled file.
+//
+//With --lods N it also writes the N distance levels B747LOD.h draws
+//far from the camera, DIR/<mesh>_lod<k>.mshb. Each keeps every group
+//slot, so the same animations move it, with the group decimated by
+//vertex clustering on a grid of LOD_CELL[k - 1] metres and the groups
+//only seen from inside the cabin left empty.
+//
+//Every group's triangles are then reordered for the post-transform
+//vertex cache (Forsyth's linear-speed algorithm, for a 32 entry cache)
+//and its vertices renumbered in the order the triangles first use them.
+//
+//  b747_meshgen --acmr [--dir DIR] [MESH]...
+//
+//reports every group's average cache miss ratio (vertices transformed
+//per triangle, with a 16 entry FIFO cache) before and after.
+//
+//  b747_meshgen --check FILE...
+//
+//reads each binary file as the modules do and reports why it would be
+//rejected.
+//
+//  b747_meshgen --bench [--dir DIR] [--runs N]
+//
+//times parsing every text mesh in DIR against mapping and decoding its
+//binary file, best of N runs (default 10), and reports both sizes, the
+//groups each draws and the largest normal and texture coordinate errors
+//of the binary file.
+//
+//==========================================
+
+#include "B747Anim.h"
+#include "B747LOD.h"
+#include "B747Mesh.h"
+#include "MeshText.h"
+#include <array>
+#include <chrono>
+#include <dirent.h>
+#include <cstdlib>
+#include <map>
+#include <set>
+
+const uint32_t MESH_FLAG_NO_RENDER = 0x2;    //FLAG bit the clients skip a group for
+
+//Merges the mergeable groups into the first group that renders alike and
+//still has room for 16 bit indices. Returns how many groups were emptied.
+static int Merge(TextMesh &m, const std::vector<bool> &mergeable){
+    std::map<std::array<uint32_t, 4>, size_t> heads;
+    int merged = 0;
+    for (size_t i = 0; i < m.groups.size(); i++) {
+        TextGroup &g = m.groups[i];
+        if (!mergeable[i] || g.vtx.empty() || (g.flag & MESH_FLAG_NO_RENDER)) continue;
+        //Transparent groups are drawn in file order, moving them could change the blend
+        if (g.material && m.materials[g.material - 1].diffuse[3] < 1.0f) continue;
+        const std::array<uint32_t, 4> key = {g.material, g.texture, g.flag, g.zbias};
+        auto it = heads.find(key);
+        if (it == heads.end() || m.groups[it->second].vtx.size() + g.vtx.size() > 65536) {
+            heads[key] = i;
+            continue;
+        }
+        TextGroup &h = m.groups[it->second];
+        const WORD base = (WORD)h.vtx.size();
+        h.vtx.insert(h.vtx.end(), g.vtx.begin(), g.vtx.end());
+        for (WORD k : g.idx) h.idx.push_back(base + k);
+        for (int k = 0; k < 3; k++) {
+            h.lo[k] = std::min(h.lo[k], g.lo[k]);
+            h.hi[k] = std::max(h.hi[k], g.hi[k]);
+        }
+        g.vtx.clear();
+        g.idx.clear();
+        g.flag |= MESH_FLAG_NO_RENDER;
+        merged++;
+    }
+    return merged;
+}
+
+const int CACHE_SIZE = 32;         //Entries the reordering scores for
+const int CACHE_FIFO_SIZE = 16;    //Entries the miss ratio is measured with
+
+//Vertices transformed per triangle by a FIFO post-transform cache.
+static double ACMR(const TextGroup &g){
+    if (g.idx.empty()) return 0.0;
+    std::vector<WORD> fifo;
+    int misses = 0;
+    for (WORD v : g.idx) {
+        if (std::find(fifo.begin(), fifo.end(), v) != fifo.end()) continue;
+        misses++;
+        fifo.push_back(v);
+        if ((int)fifo.size() > CACHE_FIFO_SIZE) fifo.erase(fifo.begin());
+    }
+    return misses/(g.idx.size()/3.0);
+}
+
+//Forsyth's vertex score: recently used vertices first, except the last
+//triangle's, then those few triangles are still waiting for.
+static float VertexScore(int cache_pos, int remaining){
+    if (!remaining) return -1.0f;
+    float score = 0.0f;
+    if (cache_pos >= 3) score = std::pow(1.0f - (cache_pos - 3)/(float)(CACHE_SIZE - 3), 1.5f);
+    else if (cache_pos >= 0) score = 0.75f;
+    return score + 2.0f/std::sqrt((float)remaining);
+}
+
+//Reorders the triangles for the vertex cache and the vertices for fetch
+//order, unless that measures no better than the exported order.
+static void Optimize(TextGroup &g){
+    const size_t nv = g.vtx.size(), nt = g.idx.size()/3;
+    if (nt < 2) return;
+    const double acmr = ACMR(g);
+
+    //Triangles of each vertex, and how many are not emitted yet.
+    std::vector<uint32_t> first(nv + 1, 0), tris(nt*3);
+    std::vector<int> remaining(nv, 0), cache_pos(nv, -1);
+    for (WORD v : g.idx) first[v + 1]++;
+    for (size_t v = 0; v < nv; v++) first[v + 1] += first[v];
+    for (size_t t = 0; t < nt; t++)
+        for (int k = 0; k < 3; k++) {
+            WORD v = g.idx[t*3 + k];
+            tris[first[v] + remaining[v]++] = (uint32_t)t;
+        }
+    std::vector<float> vscore(nv), tscore(nt, 0.0f);
+    for (size_t v = 0; v < nv; v++) vscore[v] = VertexScore(-1, remaining[v]);
+    for (size_t t = 0; t < nt; t++)
+        for (int k = 0; k < 3; k++) tscore[t] += vscore[g.idx[t*3 + k]];
+
+    std::vector<bool> emitted(nt, false);
+    std::vector<WORD> out;
+    out.reserve(nt*3);
+    std::vector<int> cache;
+    size_t scan = 0;        //Every triangle before it is emitted
+    long best = -1;
+    for (size_t n = 0; n < nt; n++) {
+        if (best < 0) {
+            //Nothing in the cache touches a waiting triangle: take the best one left.
+            float top = -1.0f;
+            for (size_t t = scan; t < nt; t++)
+                if (!emitted[t] && tscore[t] > top) {
+                    top = tscore[t];
+                    best = (long)t;
+                }
+        }
+        emitted[best] = true;
+        while (scan < nt && emitted[scan]) scan++;
+
+        //Emit it, its vertices to the front of the cache.
+        std::vector<int> next;
+        for (int k = 0; k < 3; k++) {
+            WORD v = g.idx[best*3 + k];
+            out.push_back(v);
+            for (uint32_t *t = &tris[first[v]], *e = t + remaining[v]; t < e; t++)
+                if (*t == (uint32_t)best) {
+                    *t = tris[first[v] + --remaining[v]];
+                    break;
+                }
+            if (std::find(next.begin(), next.end(), v) == next.end()) next.push_back(v);
+        }
+        for (int v : cache)
+            if (std::find(next.begin(), next.end(), v) == next.end()) next.push_back(v);
+
+        //Rescore what entered, moved in or left the cache.
+        for (size_t i = 0; i < next.size(); i++) {
+            int v = next[i];
+            cache_pos[v] = i < (size_t)CACHE_SIZE ? (int)i : -1;
+            float score = VertexScore(cache_pos[v], remaining[v]);
+            float delta = score - vscore[v];
+            vscore[v] = score;
+            for (uint32_t k = 0; k < (uint32_t)remaining[v]; k++) tscore[tris[first[v] + k]] += delta;
+        }
+        if (next.size() > (size_t)CACHE_SIZE) next.resize(CACHE_SIZE);
+        cache.swap(next);
+
+        //The next triangle is the best one the cache touches.
+        best = -1;
+        float top = -1.0f;
+        for (int v : cache)
+            for (uint32_t k = 0; k < (uint32_t)remaining[v]; k++) {
+                uint32_t t = tris[first[v] + k];
+                if (tscore[t] > top) {
+                    top = tscore[t];
+                    best = (long)t;
+                }
+            }
+    }
+
+    //Vertices in the order the triangles first use them, unused ones last.
+    std::vector<int> remap(nv, -1);
+    std::vector<NTVERTEX> vtx;
+    vtx.reserve(nv);
+    for (WORD &v : out) {
+        if (remap[v] < 0) {
+            remap[v] = (int)vtx.size();
+            vtx.push_back(g.vtx[v]);
+        }
+        v = (WORD)remap[v];
+    }
+    for (size_t v = 0; v < nv; v++)
+        if (remap[v] < 0) vtx.push_back(g.vtx[v]);
+    g.vtx.swap(vtx);
+    g.idx.swap(out);
+    if (ACMR(g) >= acmr) {
+        g.vtx.swap(vtx);
+        g.idx.swap(out);
+    }
+}
+
+//ACMR of a whole mesh: misses over triangles.
+static double ACMR(const TextMesh &m){
+    double misses = 0.0;
+    size_t nt = 0;
+    for (const TextGroup &g : m.groups) {
+        misses += ACMR(g)*(g.idx.size()/3);
+        nt += g.idx.size()/3;
+    }
+    return nt ? misses/nt : 0.0;
+}
+
+//Vertex clustering: the vertices in one grid cell that face the same way
+//become one at their mean position, and the triangles left with fewer
+//than three corners, or repeated, go.
+static void Decimate(TextGroup &g, float cell){
+    std::map<std::array<int32_t, 4>, uint32_t> clusters;
+    std::vector<uint32_t> cluster_of(g.vtx.size());
+    std::vector<std::array<double, 7>> sum;     //Position, normal, count
+    std::vector<NTVERTEX> vtx;
+    for (size_t i = 0; i < g.vtx.size(); i++) {
+        const NTVERTEX &v = g.vtx[i];
+        const float n[3] = {v.nx, v.ny, v.nz};
+        int facing = 6;     //No normal
+        float top = 0.0f;
+        for (int k = 0; k < 3; k++)
+            if (std::fabs(n[k]) > top) {
+                top = std::fabs(n[k]);
+                facing = k*2 + (n[k] < 0.0f);
+            }
+        const std::array<int32_t, 4> key = {(int32_t)std::floor(v.x/cell), (int32_t)std::floor(v.y/cell),
+            (int32_t)std::floor(v.z/cell), facing};
+        auto it = clusters.emplace(key, (uint32_t)vtx.size());
+        if (it.second) {
+            vtx.push_back(v);   //Texture coordinates of the first vertex in the cell
+            sum.push_back({});
+        }
+        std::array<double, 7> &s = sum[it.first->second];
+        s[0] += v.x; s[1] += v.y; s[2] += v.z;
+        s[3] += v.nx; s[4] += v.ny; s[5] += v.nz;
+        s[6] += 1.0;
+        cluster_of[i] = it.first->second;
+    }
+    for (size_t c = 0; c < vtx.size(); c++) {
+        const std::array<double, 7> &s = sum[c];
+        vtx[c].x = (float)(s[0]/s[6]);
+        vtx[c].y = (float)(s[1]/s[6]);
+        vtx[c].z = (float)(s[2]/s[6]);
+        double len = std::sqrt(s[3]*s[3] + s[4]*s[4] + s[5]*s[5]);
+        if (len > 0.0) {
+            vtx[c].nx = (float)(s[3]/len);
+            vtx[c].ny = (float)(s[4]/len);
+            vtx[c].nz = (float)(s[5]/len);
+        }
+    }
+
+    std::set<std::array<uint32_t, 3>> seen;
+    std::vector<WORD> idx;
+    std::vector<int> remap(vtx.size(), -1);
+    std::vector<NTVERTEX> used;
+    for (size_t t = 0; t + 2 < g.idx.size(); t += 3) {
+        std::array<uint32_t, 3> tri = {cluster_of[g.idx[t]], cluster_of[g.idx[t + 1]], cluster_of[g.idx[t + 2]]};
+        if (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2]) continue;
+        std::rotate(tri.begin(), std::min_element(tri.begin(), tri.end()), tri.end());
+        if (!seen.insert(tri).second) continue;
+        for (uint32_t c : tri) {
+            if (remap[c] < 0) {
+                remap[c] = (int)used.size();
+                used.push_back(vtx[c]);
+            }
+            idx.push_back((WORD)remap[c]);
+        }
+    }
+    g.vtx.swap(used);
+    g.idx.swap(idx);
+}
+
+//Distance level `level` (1 for the first) of a mesh.
+static void MakeLOD(TextMesh &m, int level){
+    for (TextGroup &g : m.groups) {
+        std::string label = g.label;
+        std::transform(label.begin(), label.end(), label.begin(), ::tolower);
+        if (label.find("interior") == std::string::npos) Decimate(g, LOD_CELL[level - 1]);
+        else g.vtx.clear();
+        if (g.vtx.empty()) {
+            g.idx.clear();
+            g.flag |= MESH_FLAG_NO_RENDER;
+        }
+    }
+}
+
+static size_t Triangles(const TextMesh &m){
+    size_t n = 0;
+    for (const TextGroup &g : m.groups) n += g.idx.size()/3;
+    return n;
+}
+
+//Groups the client draws: those with geometry not flagged away.
+static int Draws(const TextMesh &m){
+    int n = 0;
+    for (const TextGroup &g : m.groups)
+        if (!g.vtx.empty() && !(g.flag & MESH_FLAG_NO_RENDER)) n++;
+    return n;
+}
+
+static bool Write(const std::string &path, const TextMesh &m, const struct stat &src){
+    MeshFileHeader h = {};
+    memcpy(h.magic, MESH_FILE_MAGIC, sizeof(h.magic));
+    h.version = MESH_FILE_VERSION;
+    h.ngroups = (uint32_t)m.groups.size();
+    h.nmaterials = (uint32_t)m.materials.size();
+    h.ntextures = (uint32_t)m.textures.size();
+    for (const TextGroup &g : m.groups) {
+        h.nvertices += (uint32_t)g.vtx.size();
+        h.nindices += (uint32_t)g.idx.size();
+    }
+    h.source_size = src.st_size;
+    h.source_mtime = src.st_mtime;
+    h.size = (CompiledMesh::Offset(h, 5) + 7)/8*8;
+
+    std::vector<uint8_t> buf(h.size, 0);
+    memcpy(buf.data(), &h, sizeof(h));
+    MeshGroupRecord *grec = (MeshGroupRecord *)(buf.data() + CompiledMesh::Offset(h, 0));
+    MeshVertexRecord *vrec = (MeshVertexRecord *)(buf.data() + CompiledMesh::Offset(h, 3));
+    uint16_t *irec = (uint16_t *)(buf.data() + CompiledMesh::Offset(h, 4));
+    uint32_t fv = 0, fi = 0;
+    for (const TextGroup &g : m.groups) {
+        MeshGroupRecord &r = *grec++;
+        r = {fv, (uint32_t)g.vtx.size(), fi, (uint32_t)g.idx.size(), g.material, g.texture, g.flag, g.zbias, 0, {0, 0}, {0, 0}};
+        float lo[2] = {0, 0}, hi[2] = {0, 0};
+        for (size_t k = 0; k < g.vtx.size(); k++) {
+            const float uv[2] = {g.vtx[k].tu, g.vtx[k].tv};
+            for (int c = 0; c < 2; c++) {
+                lo[c] = k ? std::min(lo[c], uv[c]) : uv[c];
+                hi[c] = k ? std::max(hi[c], uv[c]) : uv[c];
+            }
+        }
+        for (int c = 0; c < 2; c++) {
+            r.uv_min[c] = lo[c];
+            r.uv_scale[c] = (hi[c] - lo[c])/65535.0f;
+        }
+        for (const NTVERTEX &v : g.vtx) {
+            MeshVertexRecord &o = *vrec++;
+            o.pos[0] = v.x;
+            o.pos[1] = v.y;
+            o.pos[2] = v.z;
+            const float n[3] = {v.nx, v.ny, v.nz};
+            OctEncode(n, o.normal);
+            const float uv[2] = {v.tu, v.tv};
+            for (int c = 0; c < 2; c++)
+                o.uv[c] = r.uv_scale[c] > 0.0f ? (uint16_t)std::min(65535L, std::lround((uv[c] - lo[c])/r.uv_scale[c])) : 0;
+        }
+        memcpy(irec, g.idx.data(), g.idx.size()*sizeof(uint16_t));
+        irec += g.idx.size();
+        fv += (uint32_t)g.vtx.size();
+        fi += (uint32_t)g.idx.size();
+    }
+    if (!m.materials.empty())
+        memcpy(buf.data() + CompiledMesh::Offset(h, 1), m.materials.data(), m.materials.size()*sizeof(MeshMaterialRecord));
+    char *tex = (char *)(buf.data() + CompiledMesh::Offset(h, 2));
+    for (size_t i = 0; i < m.textures.size(); i++)
+        memcpy(tex + i*MESH_TEXTURE_NAME_LEN, m.textures[i].c_str(), m.textures[i].size() + 1);
+
+    //Write to a temporary name first so a module never maps a half-written file.
+    std::string tmp = path + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+    ok = fclose(f) == 0 && ok;
+    return ok && rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+static bool WriteTemplate(const std::string &path, const std::string &src){
+    FILE *f = fopen(src.c_str(), "rb");
+    if (!f) return false;
+    std::string text;
+    char chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) text.append(chunk, n);
+    fclose(f);
+    const char *eol = text.find("\r\n") != std::string::npos ? "\r\n" : "\n";
+    size_t materials = text.find(std::string("\nMATERIALS "));
+    std::string out = std::string("MSHX1") + eol + "GROUPS 0" + eol;
+    if (materials != std::string::npos) out += text.substr(materials + 1);
+
+    std::string tmp = path + ".tmp";
+    if (!(f = fopen(tmp.c_str(), "wb"))) return false;
+    bool ok = fwrite(out.data(), 1, out.size(), f) == out.size();
+    ok = fclose(f) == 0 && ok;
+    return ok && rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+static int Check(const char *fname){
+    CompiledMesh cm;
+    const char *err = cm.Open(fname);
+    if (err) {
+        printf("%s %s\n", fname, err);
+        return 1;
+    }
+    const MeshFileHeader &h = cm.Header();
+    printf("%s ok: %u groups, %u vertices, %u triangles, %u materials, %u textures\n",
+        fname, h.ngroups, h.nvertices, h.nindices/3, h.nmaterials, h.ntextures);
+    return 0;
+}
+
+static int Compile(const std::string &dir, const std::string &mesh, const std::string &anims, int lods){
+    std::string src = dir + "/" + mesh + ".msh";
+    std::string out = dir + "/" + mesh + ".mshb";
+    TextMesh m;
+    struct stat st;
+    const char *err = m.Parse(src.c_str());
+    if (!err && stat(src.c_str(), &st) != 0) err = "cannot stat";
+    if (err) {
+        fprintf(stderr, "%s: %s\n", src.c_str(), err);
+        return 1;
+    }
+    if (!anims.empty()) {
+        AnimationSet set;
+        if ((err = set.Parse(anims.c_str()))) {
+            fprintf(stderr, "%s: %s\n", anims.c_str(), err);
+            return 1;
+        }
+        std::vector<bool> mergeable(m.groups.size(), true);
+        for (const AnimComponent &c : set.Components())
+            if (c.mesh == 0)
+                for (uint32_t k = c.first; k < c.first + c.count; k++)
+                    if (set.Groups()[k] < mergeable.size()) mergeable[set.Groups()[k]] = false;
+        int draws = Draws(m), merged = Merge(m, mergeable);
+        printf("%s: %zu groups, %d draw calls -> %d (%d static groups merged)\n",
+            mesh.c_str(), m.groups.size(), draws, Draws(m), merged);
+    }
+    for (int level = 1; level <= lods; level++) {
+        TextMesh lod = m;
+        MakeLOD(lod, level);
+        for (TextGroup &g : lod.groups) Optimize(g);
+        std::string name = dir + "/" + mesh + "_lod" + std::to_string(level) + ".mshb";
+        printf("%s: LOD%d %zu of %zu triangles (%.1f%%), %d draw calls\n", mesh.c_str(), level,
+            Triangles(lod), Triangles(m), 100.0*Triangles(lod)/std::max<size_t>(1, Triangles(m)), Draws(lod));
+        if (!Write(name, lod, st)) {
+            fprintf(stderr, "cannot write %s\n", name.c_str());
+            return 1;
+        }
+    }
+    double acmr = ACMR(m);
+    for (TextGroup &g : m.groups) Optimize(g);
+    printf("%s: ACMR %.3f -> %.3f\n", mesh.c_str(), acmr, ACMR(m));
+    if (!Write(out, m, st)) {
+        fprintf(stderr, "cannot write %s\n", out.c_str());
+        return 1;
+    }
+    std::string tmpl = dir + "/" + mesh + "_materials.msh";
+    if (!WriteTemplate(tmpl, src)) {
+        fprintf(stderr, "cannot write %s\n", tmpl.c_str());
+        return 1;
+    }
+    return 0;
+}
+
+//Every <mesh>.msh in dir but the templates, sorted.
+static std::vector<std::string> List(const std::string &dir){
+    std::vector<std::string> list;
+    if (DIR *d = opendir(dir.c_str())) {
+        while (dirent *e = readdir(d)) {
+            size_t len = strlen(e->d_name);
+            if (len > 4 && !strcmp(e->d_name + len - 4, ".msh") &&
+                !(len > 14 && !strcmp(e->d_name + len - 14, "_materials.msh")))
+                list.push_back(std::string(e->d_name, len - 4));
+        }
+        closedir(d);
+    }
+    std::sort(list.begin(), list.end());
+    return list;
+}
+
+static double Now(){
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int Bench(const std::string &dir, int runs){
+    double total_text = 0.0, total_bin = 0.0;
+    uint64_t size_text = 0, size_bin = 0;
+    int rc = 0;
+    int draws_text = 0, draws_bin = 0;
+    printf("%-28s %10s %10s %10s %10s %8s %6s %6s %9s %9s\n", "mesh", "text KB", "bin KB", "parse us", "load us", "speedup",
+        "draws", "bin", "n err deg", "uv err");
+    for (const std::string &mesh : List(dir)) {
+        std::string src = dir + "/" + mesh + ".msh", bin = dir + "/" + mesh + ".mshb";
+        TextMesh m;
+        CompiledMesh cm;
+        double t_text = 1e30, t_bin = 1e30;
+        const char *err = NULL;
+        std::vector<NTVERTEX> vtx;
+        std::vector<WORD> idx;
+        for (int r = 0; r < runs && !err; r++) {
+            double t = Now();
+            err = m.Parse(src.c_str());
+            t_text = std::min(t_text, Now() - t);
+        }
+        for (int r = 0; r < runs && !err; r++) {
+            double t = Now();
+            err = cm.Open(bin.c_str(), src.c_str());
+            if (err) break;
+            vtx.resize(cm.Header().nvertices);
+            idx.resize(cm.Header().nindices);
+            for (uint32_t g = 0; g < cm.Header().ngroups; g++)
+                cm.Decode(g, vtx.data() + cm.Group(g).first_vertex, idx.data() + cm.Group(g).first_index);
+            t_bin = std::min(t_bin, Now() - t);
+        }
+        if (err) {
+            printf("%-28s %s\n", mesh.c_str(), err);
+            rc = 1;
+            continue;
+        }
+
+        //Redo the merge the binary file shows: the groups it emptied or grew.
+        const int draws = Draws(m);
+        std::vector<bool> merged(m.groups.size());
+        for (size_t g = 0; g < m.groups.size(); g++) merged[g] = cm.Group(g).nvertices != m.groups[g].vtx.size();
+        Merge(m, merged);
+        for (TextGroup &g : m.groups) Optimize(g);
+        bool same = true;
+        for (size_t g = 0; g < m.groups.size(); g++) same = same && cm.Group(g).nvertices == m.groups[g].vtx.size();
+        if (!same) {
+            printf("%-28s binary groups differ from the text mesh\n", mesh.c_str());
+            rc = 1;
+            continue;
+        }
+
+        //Quantization error against the text values.
+        double nerr = 0.0, uverr = 0.0;
+        const NTVERTEX *v = vtx.data();
+        for (const TextGroup &g : m.groups)
+            for (const NTVERTEX &t : g.vtx) {
+                double len = std::sqrt(t.nx*t.nx + t.ny*t.ny + t.nz*t.nz);
+                if (len > 0.0) {
+                    double dot = (t.nx*v->nx + t.ny*v->ny + t.nz*v->nz)/len;
+                    nerr = std::max(nerr, std::acos(std::min(1.0, dot))*DEG);
+                }
+                uverr = std::max(uverr, (double)std::max(std::fabs(t.tu - v->tu), std::fabs(t.tv - v->tv)));
+                v++;
+            }
+
+        struct stat st;
+        uint64_t text_bytes = stat(src.c_str(), &st) == 0 ? st.st_size : 0;
+        printf("%-28s %10.1f %10.1f %10.1f %10.1f %7.1fx %6d %6d %9.4f %9.6f\n", mesh.c_str(), text_bytes/1024.0, cm.Size()/1024.0,
+            t_text, t_bin, t_text/t_bin, draws, Draws(m), nerr, uverr);
+        draws_text += draws;
+        draws_bin += Draws(m);
+        total_text += t_text;
+        total_bin += t_bin;
+        size_text += text_bytes;
+        size_bin += cm.Size();
+    }
+    printf("%-28s %10.1f %10.1f %10.1f %10.1f %7.1fx %6d %6d\n", "total", size_text/1024.0, size_bin/1024.0,
+        total_text, total_bin, total_bin > 0.0 ? total_text/total_bin : 0.0, draws_text, draws_bin);
+    return rc;
+}
+
+static int Cache(const std::string &dir, const std::vector<std::string> &list){
+    int rc = 0;
+    double before = 0.0, after = 0.0;
+    size_t nt = 0;
+    printf("%-24s %3s %-32s %7s %7s %7s\n", "mesh", "grp", "label", "tris", "before", "after");
+    for (const std::string &mesh : list) {
+        std::string src = dir + "/" + mesh + ".msh";
+        TextMesh m;
+        if (const char *err = m.Parse(src.c_str())) {
+            printf("%-24s %s\n", mesh.c_str(), err);
+            rc = 1;
+            continue;
+        }
+        for (size_t i = 0; i < m.groups.size(); i++) {
+            TextGroup &g = m.groups[i];
+            double acmr = ACMR(g);
+            Optimize(g);
+            printf("%-24s %3zu %-32s %7zu %7.3f %7.3f\n", mesh.c_str(), i, g.label.c_str(), g.idx.size()/3, acmr, ACMR(g));
+            before += acmr*(g.idx.size()/3);
+            after += ACMR(g)*(g.idx.size()/3);
+            nt += g.idx.size()/3;
+        }
+    }
+    if (nt) printf("%-24s %3s %-32s %7zu %7.3f %7.3f\n", "total", "", "", nt, before/nt, after/nt);
+    return rc;
+}
+
+static void Usage(){
+    fprintf(stderr,
+        "usage: b747_meshgen [--dir DIR] [--merge ANIMS] [--lods N] [MESH]...\n"
+        "       b747_meshgen --acmr [--dir DIR] [MESH]...\n"
+        "       b747_meshgen --check FILE...\n"
+        "       b747_meshgen --bench [--dir DIR] [--runs N]\n");
+}
+
+int main(int argc, char **argv){
+    std::string dir = "Meshes/Boeing747", anims;
+    std::vector<std::string> list;
+    bool check = false, bench = false, cache = false;
+    int runs = 10, lods = 0;
+    int rc = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if (!strcmp(a, "--dir") && i + 1 < argc) dir = argv[++i];
+        else if (!strcmp(a, "--merge") && i + 1 < argc) anims = argv[++i];
+        else if (!strcmp(a, "--lods") && i + 1 < argc) lods = std::min(std::max(0, atoi(argv[++i])), LOD_LEVELS);
+        else if (!strcmp(a, "--runs") && i + 1 < argc) runs = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(a, "--check")) check = true;
+        else if (!strcmp(a, "--bench")) bench = true;
+        else if (!strcmp(a, "--acmr")) cache = true;
+        else if (a[0] == '-') {
+            Usage();
+            return 2;
+        } else if (check) {
+            rc |= Check(a);
+        } else {
+            list.push_back(a);
+        }
+    }
+    if (check) return rc;
+    if (bench) return Bench(dir, runs);
+    if (list.empty()) list = List(dir);
+    if (cache) return Cache(dir, list);
+
+    for (const std::string &mesh : list) rc |= Compile(dir, mesh, anims, lods);
+    return rc;
+}
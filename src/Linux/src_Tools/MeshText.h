@@ -0,0 +1,188 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          BOEING 747 TOOLS
+//
+//MeshText.h
+//Reader for the MSHX1 text meshes, shared by b747_meshgen and
+//b747_meshcheck. It reads what the simulator's loader reads: per group
+//LABEL, MATERIAL, TEXTURE, FLAG and ZBIAS, then the vertices and
+//triangles, then the material and texture lists. Any other group
+//directive is an error, so a mesh the tools accept means the same to
+//them as to Orbiter.
+//
+//==========================================
+
+#pragma once
+
+#ifndef __MESHTEXT_H
+#define __MESHTEXT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "B747Mesh.h"
+
+struct TextGroup {
+    std::string label;
+    uint32_t material = 0, texture = 0, flag = 0;
+    uint16_t zbias = 0;
+    std::vector<NTVERTEX> vtx;
+    std::vector<WORD> idx;
+    float lo[3] = {0, 0, 0}, hi[3] = {0, 0, 0};   //Bounding box of the vertices
+};
+
+//A text mesh as the simulator's loader reads it.
+struct TextMesh {
+    std::vector<TextGroup> groups;
+    std::vector<MeshMaterialRecord> materials;
+    std::vector<std::string> material_names;
+    std::vector<std::string> textures;
+    char error[128];
+
+    //Returns NULL on success, otherwise the first error and its line.
+    const char *Parse(const char *fname){
+        FILE *f = fopen(fname, "rb");
+        if (!f) return "not found";
+        std::string text;
+        char chunk[65536];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) text.append(chunk, n);
+        fclose(f);
+
+        groups.clear();
+        materials.clear();
+        material_names.clear();
+        textures.clear();
+        pos = text.c_str();
+        lineno = 0;
+        const char *err = ParseText();
+        if (err) {
+            snprintf(error, sizeof(error), "line %d: %s", lineno, err);
+            return error;
+        }
+        return NULL;
+    }
+
+    private:
+
+        const char *pos;
+        int lineno;
+        char line[1024];
+
+        bool Next(){
+            if (!*pos) return false;
+            const char *end = strchr(pos, '\n');
+            size_t len = end ? end - pos : strlen(pos);
+            len = std::min(len, sizeof(line) - 1);
+            memcpy(line, pos, len);
+            line[len] = '\0';
+            if (char *c = strchr(line, ';')) *c = '\0';
+            if (char *c = strchr(line, '\r')) *c = '\0';
+            pos = end ? end + 1 : pos + strlen(pos);
+            lineno++;
+            return true;
+        }
+
+        //Up to max numbers of the current line; returns how many.
+        int Numbers(float *v, int max){
+            const char *p = line;
+            char *end;
+            int n = 0;
+            while (n < max) {
+                double x = strtod(p, &end);
+                if (end == p) break;
+                v[n++] = (float)x;
+                p = end;
+            }
+            return n;
+        }
+
+        //The current line's first word.
+        std::string Word(){
+            char w[256] = "";
+            sscanf(line, "%255s", w);
+            return w;
+        }
+
+        const char *ParseText(){
+            unsigned int ngroups;
+            if (!Next() || strncmp(line, "MSHX1", 5)) return "not an MSHX1 mesh";
+            if (!Next() || sscanf(line, "GROUPS %u", &ngroups) != 1) return "GROUPS expected";
+            groups.resize(ngroups);
+            for (TextGroup &g : groups) {
+                unsigned int nv = 0, nt = 0, u;
+                while (true) {
+                    if (!Next()) return "GEOM expected";
+                    char key[32] = "", label[256] = "";
+                    sscanf(line, "%31s", key);
+                    if (!strcmp(key, "GEOM")) {
+                        if (sscanf(line, "GEOM %u %u", &nv, &nt) != 2) return "bad GEOM line";
+                        break;
+                    }
+                    else if (!strcmp(key, "LABEL") && sscanf(line, "LABEL %255s", label) == 1) g.label = label;
+                    else if (!strcmp(key, "MATERIAL") && sscanf(line, "MATERIAL %u", &u) == 1) g.material = u;
+                    else if (!strcmp(key, "TEXTURE") && sscanf(line, "TEXTURE %u", &u) == 1) g.texture = u;
+                    else if (!strcmp(key, "FLAG") && sscanf(line, "FLAG %x", &u) == 1) g.flag = u;
+                    else if (!strcmp(key, "ZBIAS") && sscanf(line, "ZBIAS %u", &u) == 1) g.zbias = (uint16_t)u;
+                    else if (key[0]) return "unsupported group directive";
+                }
+                if (nv > 65536) return "group needs 32 bit indices";
+                g.vtx.resize(nv);
+                for (NTVERTEX &v : g.vtx) {
+                    float x[8] = {};
+                    if (!Next()) return "vertex expected";
+                    if (Numbers(x, 8) < 3) return "vertex expected";
+                    v = {x[0], x[1], x[2], x[3], x[4], x[5], x[6], x[7]};
+                    for (int k = 0; k < 3; k++) {
+                        g.lo[k] = &v == g.vtx.data() ? x[k] : std::min(g.lo[k], x[k]);
+                        g.hi[k] = &v == g.vtx.data() ? x[k] : std::max(g.hi[k], x[k]);
+                    }
+                }
+                g.idx.resize(nt*3);
+                for (unsigned int i = 0; i < nt; i++) {
+                    float x[3];
+                    if (!Next() || Numbers(x, 3) != 3) return "triangle expected";
+                    for (int k = 0; k < 3; k++) {
+                        if (x[k] < 0 || x[k] >= nv) return "index out of range";
+                        g.idx[i*3 + k] = (WORD)x[k];
+                    }
+                }
+            }
+
+            unsigned int nmat = 0, ntex = 0;
+            while (Next() && sscanf(line, "MATERIALS %u", &nmat) != 1) {}
+            materials.resize(nmat);
+            for (unsigned int i = 0; i < nmat; i++) {
+                if (!Next()) return "material name expected";
+                material_names.push_back(Word());
+            }
+            for (MeshMaterialRecord &m : materials) {
+                memset(&m, 0, sizeof(m));
+                float *col[4] = {m.diffuse, m.ambient, m.specular, m.emissive};
+                if (!Next() || strncmp(line, "MATERIAL", 8)) return "MATERIAL expected";
+                for (int k = 0; k < 4; k++) {
+                    float x[5] = {};
+                    if (!Next() || Numbers(x, 5) < 4) return "material colour expected";
+                    memcpy(col[k], x, 4*sizeof(float));
+                    if (k == 2) m.power = x[4];
+                }
+            }
+            while (Next() && sscanf(line, "TEXTURES %u", &ntex) != 1) {}
+            for (unsigned int i = 0; i < ntex; i++) {
+                if (!Next() || Word().empty()) return "texture name expected";
+                if (Word().size() >= (size_t)MESH_TEXTURE_NAME_LEN) return "texture name too long";
+                textures.push_back(Word());
+            }
+            for (const TextGroup &g : groups)
+                if (g.material > materials.size() || g.texture > textures.size()) return "group material or texture out of range";
+            return NULL;
+        }
+};
+
+#endif